@@ -0,0 +1,140 @@
+/*******************************************************************************
+ *
+ * This file is part of libcommute, a quantum operator algebra DSL and
+ * exact diagonalization toolkit for C++11/14/17.
+ *
+ * Copyright (C) 2016-2021 Igor Krivenko <igor.s.krivenko@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ ******************************************************************************/
+
+//
+// Timings of the ranking algorithms used by n_fermion_sector_view, and of
+// the enumeration of basis states within an N-fermion sector.
+//
+// Usage: benchmark.n_fermion_sector_view [M N [repetitions]]
+//
+
+#include <libcommute/libcommute.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace libcommute;
+using namespace static_indices;
+
+// Best time (in seconds) out of `repetitions` calls to `f`
+template <typename F> double best_time(int repetitions, F&& f) {
+  double best = 0;
+  for(int r = 0; r < repetitions; ++r) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    std::chrono::duration<double> t = std::chrono::steady_clock::now() - start;
+    if(r == 0 || t.count() < best) best = t.count();
+  }
+  return best;
+}
+
+// Apply ranking algorithm `RA` to all basis states of the sector
+template <typename RA>
+void time_ranking(std::string const& name,
+                  detail::n_fermion_sector_params_t const& params,
+                  std::vector<sv_index_type> const& basis_states,
+                  int repetitions,
+                  double reference_time) {
+  RA ranking(params);
+  sv_index_type checksum = 0;
+  double t = best_time(repetitions, [&]() {
+    for(sv_index_type index : basis_states)
+      checksum += ranking(index);
+  });
+  std::cout << name << ": " << t * 1e9 / basis_states.size()
+            << " ns/state, speedup " << reference_time / t
+            << " (checksum " << checksum << ")" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+
+  unsigned int M = argc > 2 ? std::atoi(argv[1]) : 22;
+  unsigned int N = argc > 2 ? std::atoi(argv[2]) : 11;
+  int repetitions = argc > 3 ? std::atoi(argv[3]) : 5;
+
+  hilbert_space<int> hs;
+  for(unsigned int i = 0; i < M; ++i)
+    hs.add(make_space_fermion(int(i)));
+
+  detail::n_fermion_sector_params_t params(hs, N);
+  auto basis_states = n_fermion_sector_basis_states(hs, N);
+  std::cout << "M = " << M << ", N = " << N
+            << ", sector size = " << basis_states.size() << std::endl;
+
+  //
+  // map_index(): Ranking of basis states
+  //
+
+  combination_ranking reference(params);
+  sv_index_type checksum = 0;
+  double reference_time = best_time(repetitions, [&]() {
+    for(sv_index_type index : basis_states)
+      checksum += reference(index);
+  });
+  std::cout << "combination_ranking: "
+            << reference_time * 1e9 / basis_states.size() << " ns/state"
+            << " (checksum " << checksum << ")" << std::endl;
+
+  time_ranking<staggered_ranking<4>>("staggered_ranking<4>",
+                                     params,
+                                     basis_states,
+                                     repetitions,
+                                     reference_time);
+  time_ranking<staggered_ranking<8>>("staggered_ranking<8>",
+                                     params,
+                                     basis_states,
+                                     repetitions,
+                                     reference_time);
+  time_ranking<lin_table_ranking>("lin_table_ranking",
+                                  params,
+                                  basis_states,
+                                  repetitions,
+                                  reference_time);
+
+  //
+  // Enumeration of basis states
+  //
+
+  // Reference: Unrank every sector index separately
+  detail::combination_unranking unranking(params);
+  std::vector<sv_index_type> states(basis_states.size());
+  double unranking_time = best_time(repetitions, [&]() {
+    for(sv_index_type n = 0; n < states.size(); ++n)
+      states[n] = unranking(n);
+  });
+  std::cout << "Basis states via combination_unranking: "
+            << unranking_time * 1e9 / states.size() << " ns/state"
+            << std::endl;
+
+  double basis_time = best_time(repetitions, [&]() {
+    basis_states = n_fermion_sector_basis_states(hs, N);
+  });
+  std::cout << "n_fermion_sector_basis_states(): "
+            << basis_time * 1e9 / basis_states.size() << " ns/state, speedup "
+            << unranking_time / basis_time << std::endl;
+
+  // foreach() over a sector view of a dense vector
+  std::vector<double> sv(basis_states.size(), 1.0);
+  auto view = make_const_nfs_view(sv, hs, N);
+  double sum = 0;
+  double foreach_time = best_time(repetitions, [&]() {
+    foreach(view, [&](sv_index_type index, double a) { sum += a * index; });
+  });
+  std::cout << "foreach(): " << foreach_time * 1e9 / basis_states.size()
+            << " ns/state (checksum " << sum << ")" << std::endl;
+
+  return 0;
+}
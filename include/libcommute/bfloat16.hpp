@@ -0,0 +1,110 @@
+/*******************************************************************************
+ *
+ * This file is part of libcommute, a quantum operator algebra DSL and
+ * exact diagonalization toolkit for C++11/14/17.
+ *
+ * Copyright (C) 2016-2021 Igor Krivenko <igor.s.krivenko@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ ******************************************************************************/
+#ifndef LIBCOMMUTE_BFLOAT16_HPP_
+#define LIBCOMMUTE_BFLOAT16_HPP_
+
+#include "scalar_traits.hpp"
+
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <cstring>
+
+namespace libcommute {
+
+//
+// Brain floating point number (bfloat16): 8 exponent bits and 7 mantissa bits.
+//
+// This type is meant to be a compact storage format for state amplitudes,
+// such as elements of Krylov basis vectors. Arithmetic operations are carried
+// out by converting to float. Products with a double precision coefficient
+// are therefore computed in double precision, and products with a float
+// coefficient are converted to double precision by loperator.
+//
+class bfloat16 {
+
+  std::uint16_t bits_ = 0;
+
+  // Round a float to the nearest bfloat16, ties to even
+  static std::uint16_t round_from_float(float x) {
+    std::uint32_t u;
+    std::memcpy(&u, &x, sizeof(u));
+    if(std::isnan(x)) return std::uint16_t((u >> 16) | 0x40);
+    u += 0x7FFF + ((u >> 16) & 1);
+    return std::uint16_t(u >> 16);
+  }
+
+public:
+  bfloat16() = default;
+  // cppcheck-suppress noExplicitConstructor
+  bfloat16(float x) : bits_(round_from_float(x)) {}
+
+  // Make a bfloat16 number from its binary representation
+  static bfloat16 from_bits(std::uint16_t bits) {
+    bfloat16 x;
+    x.bits_ = bits;
+    return x;
+  }
+
+  // Binary representation
+  std::uint16_t bits() const { return bits_; }
+
+  // Conversion to float is exact
+  operator float() const {
+    std::uint32_t u = std::uint32_t(bits_) << 16;
+    float x;
+    std::memcpy(&x, &u, sizeof(x));
+    return x;
+  }
+
+  // Compound assignments are carried out in double precision
+  bfloat16& operator+=(double x) {
+    *this = bfloat16(float(double(float(*this)) + x));
+    return *this;
+  }
+  bfloat16& operator-=(double x) {
+    *this = bfloat16(float(double(float(*this)) - x));
+    return *this;
+  }
+  bfloat16& operator*=(double x) {
+    *this = bfloat16(float(double(float(*this)) * x));
+    return *this;
+  }
+};
+
+template <> struct scalar_traits<bfloat16> {
+  // Zero value test. bfloat16 numbers store amplitudes computed in double
+  // precision and share the double precision tolerance.
+  static bool is_zero(bfloat16 const& x) {
+    return scalar_traits<double>::is_zero(float(x));
+  }
+  // Make a constant from a double value
+  static bfloat16 make_const(double x) { return bfloat16(float(x)); }
+  // Complex conjugate of x
+  static bfloat16 conj(bfloat16 const& x) { return x; }
+};
+
+// Products of complex numbers and bfloat16 numbers. They are computed in
+// the precision of the complex number.
+template <typename T>
+inline std::complex<T> operator*(std::complex<T> const& z, bfloat16 x) {
+  return z * T(float(x));
+}
+template <typename T>
+inline std::complex<T> operator*(bfloat16 x, std::complex<T> const& z) {
+  return T(float(x)) * z;
+}
+
+} // namespace libcommute
+
+#endif
@@ -25,13 +25,17 @@
 #include "expression/generator_fermion.hpp"
 #include "expression/generator_spin.hpp"
 #include "expression/hc.hpp"
+#include "loperator/basis_map.hpp"
 #include "loperator/elementary_space_boson.hpp"
 #include "loperator/elementary_space_fermion.hpp"
 #include "loperator/elementary_space_spin.hpp"
 #include "loperator/loperator.hpp"
 #include "loperator/mapped_basis_view.hpp"
+#include "loperator/momentum_sector_view.hpp"
 #include "loperator/n_fermion_sector_view.hpp"
+#include "loperator/n_quanta_sector_view.hpp"
 #include "loperator/space_partition.hpp"
+#include "loperator/symmetry_sector_view.hpp"
 
 // C++17-only headers
 #if __cplusplus >= 201703L
@@ -0,0 +1,323 @@
+/*******************************************************************************
+ *
+ * This file is part of libcommute, a quantum operator algebra DSL and
+ * exact diagonalization toolkit for C++11/14/17.
+ *
+ * Copyright (C) 2016-2021 Igor Krivenko <igor.s.krivenko@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ ******************************************************************************/
+#ifndef LIBCOMMUTE_LOPERATOR_BASIS_MAP_HPP_
+#define LIBCOMMUTE_LOPERATOR_BASIS_MAP_HPP_
+
+#include "state_vector.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+//
+// Array-based maps from basis state indices to contiguous mapped indices
+// 0, ..., size() - 1. Each map stores a flat array of basis states, and
+// the mapped index of a basis state is its position in the array. The maps
+// can be used with basis_mapper and mapped_basis_view instead of
+// std::unordered_map, which costs a few times more memory per basis state.
+//
+
+namespace libcommute {
+
+// Input iterator over pairs (basis state, mapped index) of an array-based
+// basis map. The pairs are returned by value.
+class basis_map_iterator {
+
+  sv_index_type const* basis_states_ = nullptr;
+  sv_index_type pos_ = 0;
+
+public:
+  using iterator_category = std::input_iterator_tag;
+  using value_type = std::pair<sv_index_type, sv_index_type>;
+  using difference_type = std::ptrdiff_t;
+  using pointer = void;
+  using reference = value_type;
+
+  basis_map_iterator() = default;
+  basis_map_iterator(sv_index_type const* basis_states, sv_index_type pos)
+    : basis_states_(basis_states), pos_(pos) {}
+
+  value_type operator*() const {
+    return std::make_pair(basis_states_[pos_], pos_);
+  }
+
+  basis_map_iterator& operator++() {
+    ++pos_;
+    return *this;
+  }
+  basis_map_iterator operator++(int) {
+    basis_map_iterator it = *this;
+    ++pos_;
+    return it;
+  }
+
+  friend bool operator==(basis_map_iterator const& it1,
+                         basis_map_iterator const& it2) {
+    return it1.pos_ == it2.pos_;
+  }
+  friend bool operator!=(basis_map_iterator const& it1,
+                         basis_map_iterator const& it2) {
+    return it1.pos_ != it2.pos_;
+  }
+};
+
+namespace detail {
+
+// Array of basis states shared by the array-based basis maps
+class basis_map_base {
+
+protected:
+  std::vector<sv_index_type> basis_states_;
+
+  basis_map_base() = default;
+  explicit basis_map_base(std::vector<sv_index_type> basis_states)
+    : basis_states_(std::move(basis_states)) {}
+
+  [[noreturn]] static void throw_out_of_range(sv_index_type index) {
+    throw std::out_of_range("Basis state " + std::to_string(index) +
+                            " is not in the map");
+  }
+
+public:
+  using const_iterator = basis_map_iterator;
+
+  // Number of basis states in the map
+  sv_index_type size() const { return basis_states_.size(); }
+
+  // Basis states ordered by their mapped indices
+  std::vector<sv_index_type> const& basis_states() const {
+    return basis_states_;
+  }
+
+  // Iteration over pairs (basis state, mapped index)
+  const_iterator begin() const {
+    return const_iterator(basis_states_.data(), 0);
+  }
+  const_iterator end() const {
+    return const_iterator(basis_states_.data(), basis_states_.size());
+  }
+};
+
+} // namespace detail
+
+//
+// Sorted array of basis states
+//
+
+// Basis states are stored in ascending order and located using a branchless
+// binary search. The mapped index of a basis state is its position in
+// the sorted array.
+class sorted_basis_map : public detail::basis_map_base {
+
+public:
+  sorted_basis_map() = default;
+
+  // Build a map from a list of basis states, duplicates are ignored
+  explicit sorted_basis_map(std::vector<sv_index_type> basis_states)
+    : basis_map_base(std::move(basis_states)) {
+    std::sort(basis_states_.begin(), basis_states_.end());
+    basis_states_.erase(std::unique(basis_states_.begin(), basis_states_.end()),
+                        basis_states_.end());
+    basis_states_.shrink_to_fit();
+  }
+
+  // Mapped index of a basis state, or size() if it is not in the map
+  inline sv_index_type find(sv_index_type index) const {
+    sv_index_type const* base = basis_states_.data();
+    std::size_t n = basis_states_.size();
+    if(n == 0) return 0;
+    // Compilers translate the conditional expression into a conditional move.
+    // Both possible midpoints of the next iteration are prefetched.
+    while(n > 1) {
+      std::size_t half = n / 2;
+#ifdef __GNUC__
+      __builtin_prefetch(base + half / 2);
+      __builtin_prefetch(base + half + half / 2);
+#endif
+      base = (base[half] <= index) ? base + half : base;
+      n -= half;
+    }
+    return *base == index ? sv_index_type(base - basis_states_.data())
+                          : size();
+  }
+
+  // Mapped index of a basis state. Throws std::out_of_range if the basis
+  // state is not in the map.
+  inline sv_index_type at(sv_index_type index) const {
+    sv_index_type pos = find(index);
+    if(pos == size()) throw_out_of_range(index);
+    return pos;
+  }
+};
+
+//
+// Minimal perfect hash of basis states
+//
+
+// Basis states are placed into slots of an array using a minimal perfect hash
+// function (hash-and-displace scheme with 4 keys per bucket on average and
+// a table load factor of about 0.97). A lookup takes a constant number of
+// operations and a single access to the array of basis states. In addition to
+// the 8 bytes per basis state, the hash function requires about 1 byte per
+// basis state. The mapped index of a basis state is its slot number.
+class perfect_hash_basis_map : public detail::basis_map_base {
+
+  // Seed of the hash function
+  std::uint64_t seed_ = 0;
+
+  // Number of buckets
+  std::uint64_t n_buckets_ = 0;
+
+  // Size of the hash table before slots are remapped onto [0, size())
+  std::uint64_t table_size_ = 0;
+
+  // Displacement (pilot) values, one per bucket
+  std::vector<std::uint32_t> pilots_;
+
+  // Slot numbers assigned to table positions [size(), table_size_)
+  std::vector<sv_index_type> remap_;
+
+  inline std::uint64_t key_hash(sv_index_type index) const {
+    return detail::mix_hash(index ^ seed_);
+  }
+
+  inline std::uint64_t position(std::uint64_t hash,
+                                std::uint32_t pilot) const {
+    return detail::mix_hash(hash ^ detail::mix_hash(pilot + 1)) % table_size_;
+  }
+
+  // Try to find pilot values for a given seed, returns false on failure
+  bool build(std::vector<sv_index_type> const& keys) {
+    std::size_t n = keys.size();
+    std::uint32_t const max_pilot = 1 << 24;
+
+    // Group hashes of the keys by buckets
+    std::vector<std::uint64_t> hashes(n);
+    std::vector<std::size_t> bucket_start(n_buckets_ + 1, 0);
+    for(std::size_t i = 0; i < n; ++i) {
+      hashes[i] = key_hash(keys[i]);
+      ++bucket_start[hashes[i] % n_buckets_ + 1];
+    }
+    std::size_t max_bucket_size = 0;
+    for(std::uint64_t b = 0; b < n_buckets_; ++b) {
+      max_bucket_size = std::max(max_bucket_size, bucket_start[b + 1]);
+      bucket_start[b + 1] += bucket_start[b];
+    }
+    std::vector<std::uint64_t> bucket_hashes(n);
+    {
+      std::vector<std::size_t> fill(bucket_start.begin(),
+                                    bucket_start.end() - 1);
+      for(std::size_t i = 0; i < n; ++i)
+        bucket_hashes[fill[hashes[i] % n_buckets_]++] = hashes[i];
+    }
+
+    // Process buckets in the order of decreasing size
+    std::vector<std::vector<std::uint64_t>> buckets_by_size(max_bucket_size +
+                                                            1);
+    for(std::uint64_t b = 0; b < n_buckets_; ++b)
+      buckets_by_size[bucket_start[b + 1] - bucket_start[b]].push_back(b);
+
+    std::vector<bool> taken(table_size_, false);
+    std::vector<std::uint64_t> positions;
+    positions.reserve(max_bucket_size);
+    for(std::size_t size = max_bucket_size; size > 0; --size) {
+      for(auto b : buckets_by_size[size]) {
+        auto first = bucket_hashes.begin() + bucket_start[b];
+        std::uint32_t pilot = 0;
+        for(; pilot < max_pilot; ++pilot) {
+          positions.clear();
+          bool ok = true;
+          for(auto it = first; it != first + size; ++it) {
+            auto p = position(*it, pilot);
+            if(taken[p] ||
+               std::find(positions.begin(), positions.end(), p) !=
+                   positions.end()) {
+              ok = false;
+              break;
+            }
+            positions.push_back(p);
+          }
+          if(ok) break;
+        }
+        if(pilot == max_pilot) return false;
+        pilots_[b] = pilot;
+        for(auto p : positions)
+          taken[p] = true;
+      }
+    }
+
+    // Remap taken positions beyond n onto free slots below n
+    remap_.assign(table_size_ - n, 0);
+    std::size_t free_slot = 0;
+    for(std::uint64_t p = n; p < table_size_; ++p) {
+      if(!taken[p]) continue;
+      while(taken[free_slot])
+        ++free_slot;
+      remap_[p - n] = free_slot++;
+    }
+    return true;
+  }
+
+  inline sv_index_type slot(sv_index_type index) const {
+    std::uint64_t hash = key_hash(index);
+    std::uint64_t p = position(hash, pilots_[hash % n_buckets_]);
+    return p < basis_states_.size() ? p : remap_[p - basis_states_.size()];
+  }
+
+public:
+  perfect_hash_basis_map() = default;
+
+  // Build a map from a list of basis states, duplicates are ignored
+  explicit perfect_hash_basis_map(std::vector<sv_index_type> basis_states) {
+    std::sort(basis_states.begin(), basis_states.end());
+    basis_states.erase(std::unique(basis_states.begin(), basis_states.end()),
+                       basis_states.end());
+    std::size_t n = basis_states.size();
+    if(n == 0) return;
+
+    n_buckets_ = (n + 3) / 4;
+    table_size_ = n + n / 32 + 1;
+    pilots_.resize(n_buckets_);
+    for(seed_ = 0;; ++seed_) {
+      if(build(basis_states)) break;
+    }
+
+    basis_states_.resize(n);
+    for(auto index : basis_states)
+      basis_states_[slot(index)] = index;
+  }
+
+  // Mapped index of a basis state, or size() if it is not in the map
+  inline sv_index_type find(sv_index_type index) const {
+    if(basis_states_.empty()) return 0;
+    sv_index_type s = slot(index);
+    return basis_states_[s] == index ? s : size();
+  }
+
+  // Mapped index of a basis state. Throws std::out_of_range if the basis
+  // state is not in the map.
+  inline sv_index_type at(sv_index_type index) const {
+    sv_index_type pos = find(index);
+    if(pos == size()) throw_out_of_range(index);
+    return pos;
+  }
+};
+
+} // namespace libcommute
+
+#endif
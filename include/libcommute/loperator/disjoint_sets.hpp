@@ -16,7 +16,11 @@
 #include <algorithm>
 #include <cassert>
 #include <cstdint>
+#include <limits>
 #include <numeric>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -26,20 +30,38 @@ namespace libcommute {
 // Disjoint sets data structure
 // Adapted from https://github.com/JuliaCollections/DataStructures.jl
 //
+// IndexType is the unsigned integer type used to store parent elements.
+// RankType is the unsigned integer type used to store ranks of the sets.
+// Since ranks never exceed log2(n), an 8-bit RankType is always sufficient.
+//
 
-class disjoint_sets {
-  mutable std::vector<std::size_t> parents_;
-  std::vector<std::size_t> ranks_;
+template <typename IndexType, typename RankType> class basic_disjoint_sets {
+  mutable std::vector<IndexType> parents_;
+  std::vector<RankType> ranks_;
   std::size_t n_sets_;
 
+  static_assert(std::is_unsigned<IndexType>::value &&
+                    std::is_unsigned<RankType>::value,
+                "IndexType and RankType must be unsigned integer types");
+
 public:
-  explicit disjoint_sets(std::size_t n_sets)
+  explicit basic_disjoint_sets(std::size_t n_sets)
     : parents_(n_sets), ranks_(n_sets, 0), n_sets_(n_sets) {
+    check_max_size(n_sets);
     std::iota(parents_.begin(), parents_.end(), 0);
   }
 
+  // Maximal number of elements representable by IndexType
+  static constexpr std::size_t max_size() {
+    return std::numeric_limits<IndexType>::max() <
+                   std::numeric_limits<std::size_t>::max()
+               ? std::size_t(std::numeric_limits<IndexType>::max()) + 1
+               : std::numeric_limits<std::size_t>::max();
+  }
+
   // Add a new singleton set
   inline std::size_t make_set() {
+    check_max_size(size() + 1);
     parents_.push_back(size());
     ranks_.push_back(0);
     n_sets_ += 1;
@@ -48,6 +70,7 @@ public:
 
   // Add n singleton sets
   inline void make_sets(std::size_t n) {
+    check_max_size(size() + n);
     parents_.reserve(size() + n);
     ranks_.reserve(size() + n);
     for(std::size_t i = 0; i < n; ++i) {
@@ -66,7 +89,7 @@ public:
   // Find representative element of the set containing x (with path compression)
   std::size_t find_root(std::size_t x) const {
     assert(x < size());
-    std::size_t p = parents_[x];
+    IndexType p = parents_[x];
     if(parents_[p] != p) { parents_[x] = p = find_root(p); }
     return p;
   }
@@ -85,8 +108,8 @@ public:
     assert(parents_[x] == x);
     assert(parents_[y] == y);
 
-    std::size_t x_rank = ranks_[x];
-    std::size_t y_rank = ranks_[y];
+    RankType x_rank = ranks_[x];
+    RankType y_rank = ranks_[y];
     if(x_rank < y_rank)
       std::swap(x, y);
     else if(x_rank == y_rank)
@@ -106,14 +129,14 @@ public:
 
   // Compress all sets (make every element represented by its parent)
   void compress_sets() {
-    for(std::size_t x : parents_)
+    for(IndexType x : parents_)
       find_root(x);
   }
 
   // Normalize all sets (make every representative be the smallest in its set)
   void normalize_sets() {
     for(std::size_t x = 0; x < size(); ++x) {
-      std::size_t p = parents_[x];
+      IndexType p = parents_[x];
       if(x > p || parents_[p] != p)
         parents_[x] = parents_[p];
       else {
@@ -122,6 +145,104 @@ public:
       }
     }
   }
+
+private:
+  static void check_max_size(std::size_t n) {
+    if(n > max_size())
+      throw std::length_error("Number of elements " + std::to_string(n) +
+                              " exceeds capacity of disjoint sets");
+  }
+};
+
+// Disjoint sets with word-sized parent indices and ranks
+using disjoint_sets = basic_disjoint_sets<std::size_t, std::size_t>;
+
+// Memory-compact disjoint sets with 32-bit parent indices and 8-bit ranks
+// (5 bytes per element instead of 16 bytes for 'disjoint_sets')
+using compact_disjoint_sets = basic_disjoint_sets<std::uint32_t, std::uint8_t>;
+
+//
+// Disjoint sets data structure that chooses between compact_disjoint_sets and
+// 64-bit parent indices depending on the number of elements it is constructed
+// with.
+//
+
+class adaptive_disjoint_sets {
+
+  using wide_disjoint_sets = basic_disjoint_sets<std::uint64_t, std::uint8_t>;
+
+  bool compact_;
+  compact_disjoint_sets compact_ds_;
+  wide_disjoint_sets wide_ds_;
+
+public:
+  explicit adaptive_disjoint_sets(std::size_t n_sets)
+    : compact_(n_sets <= compact_disjoint_sets::max_size()),
+      compact_ds_(compact_ ? n_sets : 0),
+      wide_ds_(compact_ ? 0 : n_sets) {}
+
+  // Are 32-bit parent indices used?
+  inline bool is_compact() const { return compact_; }
+
+  // Add a new singleton set
+  inline std::size_t make_set() {
+    return compact_ ? compact_ds_.make_set() : wide_ds_.make_set();
+  }
+
+  // Add n singleton sets
+  inline void make_sets(std::size_t n) {
+    if(compact_)
+      compact_ds_.make_sets(n);
+    else
+      wide_ds_.make_sets(n);
+  }
+
+  // Size of 'parents' array
+  inline std::size_t size() const {
+    return compact_ ? compact_ds_.size() : wide_ds_.size();
+  }
+
+  // Number of disjoint sets
+  inline std::size_t n_sets() const {
+    return compact_ ? compact_ds_.n_sets() : wide_ds_.n_sets();
+  }
+
+  // Find representative element of the set containing x (with path compression)
+  inline std::size_t find_root(std::size_t x) const {
+    return compact_ ? compact_ds_.find_root(x) : wide_ds_.find_root(x);
+  }
+
+  // Do elements x and y belong to the same set?
+  inline bool in_same_set(std::size_t x, std::size_t y) const {
+    return compact_ ? compact_ds_.in_same_set(x, y)
+                    : wide_ds_.in_same_set(x, y);
+  }
+
+  // Merge sets represented by x and y
+  inline std::size_t root_union(std::size_t x, std::size_t y) {
+    return compact_ ? compact_ds_.root_union(x, y) : wide_ds_.root_union(x, y);
+  }
+
+  // Merge sets containing x and y
+  inline std::size_t set_union(std::size_t x, std::size_t y) {
+    return compact_ ? compact_ds_.set_union(x, y) : wide_ds_.set_union(x, y);
+  }
+
+  // Compress all sets (make every element represented by its parent)
+  inline void compress_sets() {
+    if(compact_)
+      compact_ds_.compress_sets();
+    else
+      wide_ds_.compress_sets();
+  }
+
+  // Normalize all sets (make every representative be the smallest in its set)
+  inline void normalize_sets() {
+    if(compact_)
+      compact_ds_.normalize_sets();
+    else
+      wide_ds_.normalize_sets();
+  }
 };
 
 } // namespace libcommute
@@ -13,6 +13,7 @@
 #ifndef LIBCOMMUTE_LOPERATOR_ELEMENTARY_SPACE_HPP_
 #define LIBCOMMUTE_LOPERATOR_ELEMENTARY_SPACE_HPP_
 
+#include <cstddef>
 #include <memory>
 #include <tuple>
 #include <utility>
@@ -78,6 +79,9 @@ public:
   // in this elementary space
   virtual int n_bits() const = 0;
 
+  // Dimension of this elementary space
+  virtual std::size_t dim() const { return std::size_t(1) << n_bits(); }
+
   // Indices accessor
   index_types const& indices() const { return indices_; }
 
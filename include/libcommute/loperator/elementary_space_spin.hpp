@@ -62,6 +62,9 @@ public:
   // in this elementary space
   int n_bits() const override { return n_bits_; }
 
+  // Dimension of this elementary space, 2S+1
+  std::size_t dim() const override { return multiplicity_; }
+
 private:
   // Multiplicity, 2S+1
   int multiplicity_;
@@ -0,0 +1,227 @@
+/*******************************************************************************
+ *
+ * This file is part of libcommute, a quantum operator algebra DSL and
+ * exact diagonalization toolkit for C++11/14/17.
+ *
+ * Copyright (C) 2016-2021 Igor Krivenko <igor.s.krivenko@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ ******************************************************************************/
+#ifndef LIBCOMMUTE_LOPERATOR_FLAT_INDEX_MAP_HPP_
+#define LIBCOMMUTE_LOPERATOR_FLAT_INDEX_MAP_HPP_
+
+#include "state_vector.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace libcommute {
+
+//
+// Open-addressing hash map with keys of type sv_index_type
+//
+// Elements are stored in flat arrays and collisions are resolved by linear
+// probing with Robin Hood displacement. Erased elements are removed by
+// shifting the following elements of the probe sequence backwards, so that
+// the table never contains tombstones. Unlike std::unordered_map, insertion
+// does not allocate memory unless the table has to grow, and clear() keeps
+// the allocated capacity.
+//
+template <typename T> class flat_index_map {
+
+  // Probe sequence lengths are stored as 8-bit numbers. A table is grown
+  // whenever a probe sequence length would reach this value.
+  static constexpr std::uint8_t max_psl = 255;
+
+  // Probe sequence length plus one for occupied slots, zero for empty slots
+  std::vector<std::uint8_t> psl_;
+  std::vector<sv_index_type> keys_;
+  std::vector<T> values_;
+
+  // Number of stored elements
+  std::size_t size_ = 0;
+
+  // Number of elements that can be stored without growing the table
+  std::size_t max_size_ = 0;
+
+  // Number of slots minus one (the number of slots is a power of 2)
+  std::size_t mask_ = 0;
+
+  inline std::size_t home(sv_index_type key) const {
+    return detail::mix_hash(key) & mask_;
+  }
+
+  // Smallest number of slots that can accommodate `n` elements with
+  // the maximal load factor of 7/8
+  static std::size_t n_slots_for(std::size_t n) {
+    std::size_t n_slots = 8;
+    while(n_slots - n_slots / 8 < n)
+      n_slots *= 2;
+    return n_slots;
+  }
+
+  // Reallocate the table and reinsert all elements
+  void rehash(std::size_t n_slots) {
+    std::vector<std::uint8_t> old_psl(n_slots, 0);
+    std::vector<sv_index_type> old_keys(n_slots);
+    std::vector<T> old_values(n_slots);
+    std::swap(psl_, old_psl);
+    std::swap(keys_, old_keys);
+    std::swap(values_, old_values);
+    size_ = 0;
+    max_size_ = n_slots - n_slots / 8;
+    mask_ = n_slots - 1;
+
+    for(std::size_t pos = 0; pos < old_psl.size(); ++pos) {
+      if(old_psl[pos] == 0) continue;
+      insert_at(home(old_keys[pos]),
+                1,
+                old_keys[pos],
+                std::move(old_values[pos]));
+    }
+  }
+
+  // Insert a new element starting from slot `pos` with the probe sequence
+  // length `psl`. Returns a pointer to the stored value.
+  T* insert_at(std::size_t pos, std::uint8_t psl, sv_index_type key, T value) {
+    sv_index_type const new_key = key;
+    T* result = nullptr;
+    bool relocated = false;
+    while(true) {
+      if(psl == max_psl) {
+        rehash(2 * psl_.size());
+        if(result) relocated = true;
+        pos = home(key);
+        psl = 1;
+        continue;
+      }
+      if(psl_[pos] == 0) {
+        psl_[pos] = psl;
+        keys_[pos] = key;
+        values_[pos] = std::move(value);
+        ++size_;
+        if(!result) result = &values_[pos];
+        break;
+      }
+      // Displace an element that is closer to its home slot
+      if(psl_[pos] < psl) {
+        std::swap(psl_[pos], psl);
+        std::swap(keys_[pos], key);
+        std::swap(values_[pos], value);
+        if(!result) result = &values_[pos];
+      }
+      pos = (pos + 1) & mask_;
+      ++psl;
+    }
+    return relocated ? find(new_key) : result;
+  }
+
+  // Remove the element stored in slot `pos`
+  void erase_at(std::size_t pos) {
+    std::size_t next = (pos + 1) & mask_;
+    while(psl_[next] > 1) {
+      psl_[pos] = psl_[next] - 1;
+      keys_[pos] = keys_[next];
+      values_[pos] = std::move(values_[next]);
+      pos = next;
+      next = (next + 1) & mask_;
+    }
+    psl_[pos] = 0;
+    --size_;
+  }
+
+  // Slot holding `key`, or the number of slots if `key` is not in the map
+  inline std::size_t find_slot(sv_index_type key) const {
+    if(size_ == 0) return psl_.size();
+    std::size_t pos = home(key);
+    for(std::uint8_t psl = 1; psl_[pos] >= psl; ++psl) {
+      if(keys_[pos] == key) return pos;
+      pos = (pos + 1) & mask_;
+    }
+    return psl_.size();
+  }
+
+public:
+  flat_index_map() = default;
+
+  // Number of stored elements
+  inline std::size_t size() const { return size_; }
+
+  // Is the map empty?
+  inline bool empty() const { return size_ == 0; }
+
+  // Number of elements the map can hold without reallocating its storage
+  inline std::size_t capacity() const { return max_size_; }
+
+  // Reserve storage for at least `n` elements
+  void reserve(std::size_t n) {
+    std::size_t n_slots = n_slots_for(n);
+    if(n_slots > psl_.size()) rehash(n_slots);
+  }
+
+  // Remove all elements, the allocated storage is retained
+  void clear() {
+    std::fill(psl_.begin(), psl_.end(), 0);
+    size_ = 0;
+  }
+
+  // Pointer to the value associated with `key`, or nullptr if `key` is not
+  // in the map
+  inline T* find(sv_index_type key) {
+    std::size_t pos = find_slot(key);
+    return pos == psl_.size() ? nullptr : &values_[pos];
+  }
+  inline T const* find(sv_index_type key) const {
+    std::size_t pos = find_slot(key);
+    return pos == psl_.size() ? nullptr : &values_[pos];
+  }
+
+  // Access the value associated with `key`. A value-initialized element is
+  // inserted if `key` is not in the map.
+  inline T& operator[](sv_index_type key) {
+    if(size_ == max_size_) rehash(n_slots_for(size_ + 1));
+    std::size_t pos = home(key);
+    std::uint8_t psl = 1;
+    for(; psl_[pos] >= psl; ++psl) {
+      if(keys_[pos] == key) return values_[pos];
+      pos = (pos + 1) & mask_;
+    }
+    return *insert_at(pos, psl, key, T());
+  }
+
+  // Remove the element associated with `key`. Returns the number of removed
+  // elements (0 or 1).
+  inline std::size_t erase(sv_index_type key) {
+    std::size_t pos = find_slot(key);
+    if(pos == psl_.size()) return 0;
+    erase_at(pos);
+    return 1;
+  }
+
+  // Remove all elements for which `p(key, value)` returns true
+  template <typename Predicate> void erase_if(Predicate&& p) {
+    // Removing an element shifts the following elements backwards,
+    // so the same slot has to be checked again.
+    for(std::size_t pos = 0; pos < psl_.size(); ++pos) {
+      while(psl_[pos] != 0 && p(keys_[pos], values_[pos]))
+        erase_at(pos);
+    }
+  }
+
+  // Apply functor `f` to all stored key/value pairs
+  template <typename Functor> void foreach(Functor&& f) const {
+    for(std::size_t pos = 0; pos < psl_.size(); ++pos) {
+      if(psl_[pos] != 0) f(keys_[pos], values_[pos]);
+    }
+  }
+};
+
+} // namespace libcommute
+
+#endif
@@ -23,6 +23,7 @@
 #include <algorithm>
 #include <cassert>
 #include <iterator>
+#include <ostream>
 #include <limits>
 #include <map>
 #include <stdexcept>
@@ -173,6 +174,19 @@ public:
     return !operator==(hs1, hs2);
   }
 
+  // Stream output: Algebra IDs, indices, and bit ranges of elementary spaces
+  friend std::ostream& operator<<(std::ostream& os, hilbert_space const& hs) {
+    bool print_comma = false;
+    os << "{";
+    for(auto const& es : hs.elementary_spaces_) {
+      os << (print_comma ? ", " : "") << es.first->algebra_id() << "(";
+      print_tuple(os, es.first->indices());
+      os << "):[" << es.second.first << "," << es.second.second << "]";
+      print_comma = true;
+    }
+    return os << "}";
+  }
+
   // Append a new elementary space to the ordered product
   void add(elementary_space_t const& es) {
     auto r = elementary_spaces_.emplace(es.clone(), bit_range_t(0, 0));
@@ -238,6 +252,16 @@ public:
     }
   }
 
+  // Apply functor `f` to all elementary spaces in the order of their bit
+  // ranges. The functor must take two arguments, a constant reference to an
+  // elementary space and its bit range.
+  template <typename Functor>
+  void for_each_elementary_space(Functor&& f) const {
+    for(auto const& es : elementary_spaces_) {
+      f(*es.first, es.second);
+    }
+  }
+
   // Return index of the product basis state, which decomposes as
   // |0> |0> ... |0> |n>_{es} |0> ... |0>.
   sv_index_type basis_state_index(elementary_space_t const& es,
@@ -23,11 +23,44 @@
 #include "monomial_action_spin.hpp"
 #include "state_vector.hpp"
 
+#include <type_traits>
 #include <utility>
 #include <vector>
 
 namespace libcommute {
 
+namespace detail {
+
+// Type of product of a monomial coefficient and a state amplitude
+template <typename C, typename A>
+using amplitude_product_t = accumulator_type_t<mul_type<C, A>>;
+
+template <typename C, typename A>
+inline amplitude_product_t<C, A>
+mul_amplitude_impl(C const& c, A const& a, std::true_type) {
+  return c * a;
+}
+
+template <typename C, typename A>
+inline amplitude_product_t<C, A>
+mul_amplitude_impl(C const& c, A const& a, std::false_type) {
+  using T = amplitude_product_t<C, A>;
+  return T(c) * T(a);
+}
+
+// Multiply coefficient `c` by amplitude `a`. If the product would be computed
+// in single precision, both factors are converted to the accumulator type
+// (double precision) first.
+template <typename C, typename A>
+inline amplitude_product_t<C, A> mul_amplitude(C const& c, A const& a) {
+  return mul_amplitude_impl(
+      c,
+      a,
+      std::is_same<amplitude_product_t<C, A>, mul_type<C, A>>());
+}
+
+} // namespace detail
+
 //
 // Linear operator acting on a state vector in a Hilbert space
 //
@@ -137,7 +170,10 @@ private:
                 auto coeff = scalar_traits<ScalarType>::make_const(1);
                 bool nonzero = ma.first.act(index, coeff);
                 if(nonzero)
-                  update_add_element(dst, index, ma.second * coeff * a);
+                  update_add_element(
+                      dst,
+                      index,
+                      detail::mul_amplitude(ma.second * coeff, a));
               }
             });
   }
@@ -258,7 +294,10 @@ private:
                 scalar_traits<evaluated_coeff_t<CoeffArgs...>>::make_const(1);
             bool nz = m_act[n].first.act(index, coeff);
             if(nz) {
-              update_add_element(dst, index, evaluated_coeffs[n] * coeff * a);
+              update_add_element(
+                  dst,
+                  index,
+                  detail::mul_amplitude(evaluated_coeffs[n] * coeff, a));
             }
           }
         });
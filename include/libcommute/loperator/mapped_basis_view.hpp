@@ -14,12 +14,13 @@
 #define LIBCOMMUTE_LOPERATOR_MAPPED_BASIS_VIEW_HPP_
 
 #include "../metafunctions.hpp"
+#include "basis_map.hpp"
 #include "loperator.hpp"
 #include "sparse_state_vector.hpp"
 #include "state_vector.hpp"
 
 #include <algorithm>
-#include <cassert>
+#include <cstddef>
 #include <iterator>
 #include <type_traits>
 #include <unordered_map>
@@ -35,33 +36,51 @@
 // Hilbert space and it is desirable to store vector components only within this
 // subspace.
 //
+// The map type is a template parameter. Besides std::unordered_map, it can be
+// one of the array-based maps defined in basis_map.hpp.
+//
 
 namespace libcommute {
 
-template <typename StateVector, bool Ref = true> struct mapped_basis_view {
+template <typename StateVector,
+          bool Ref = true,
+          typename Map = std::unordered_map<sv_index_type, sv_index_type>>
+struct mapped_basis_view {
 
   typename std::conditional<Ref, StateVector&, StateVector>::type state_vector;
-  using map_t = std::unordered_map<sv_index_type, sv_index_type>;
+  using map_t = Map;
   map_t const& map;
 
+  // Dense inverse of the map, basis_states[map.at(index)] == index.
+  // nullptr if unknown.
+  std::vector<sv_index_type> const* basis_states;
+
   using scalar_type = typename element_type<
       typename std::remove_const<StateVector>::type>::type;
 
   template <typename SV>
   mapped_basis_view(SV&& sv, map_t const& map)
-    : state_vector(std::forward<SV>(sv)), map(map) {}
+    : state_vector(std::forward<SV>(sv)), map(map), basis_states(nullptr) {}
+
+  template <typename SV>
+  mapped_basis_view(SV&& sv,
+                    map_t const& map,
+                    std::vector<sv_index_type> const& basis_states)
+    : state_vector(std::forward<SV>(sv)),
+      map(map),
+      basis_states(&basis_states) {}
 };
 
 // Get element type of the StateVector object adapted by a given
 // mapped_basis_view object.
-template <typename StateVector, bool Ref>
-struct element_type<mapped_basis_view<StateVector, Ref>> {
+template <typename StateVector, bool Ref, typename Map>
+struct element_type<mapped_basis_view<StateVector, Ref, Map>> {
   using type = typename mapped_basis_view<StateVector>::scalar_type;
 };
 
 // Get state amplitude of the adapted StateVector object at index view.map[n]
-template <typename StateVector, bool Ref>
-inline auto get_element(mapped_basis_view<StateVector, Ref> const& view,
+template <typename StateVector, bool Ref, typename Map>
+inline auto get_element(mapped_basis_view<StateVector, Ref, Map> const& view,
                         sv_index_type n) ->
     typename mapped_basis_view<StateVector>::scalar_type {
   return get_element(view.state_vector, view.map.at(n));
@@ -69,16 +88,16 @@ inline auto get_element(mapped_basis_view<StateVector, Ref> const& view,
 
 // Add a constant to a state amplitude stored in the adapted StateVector object
 // at index view.map[n].
-template <typename StateVector, bool Ref, typename T>
-inline void update_add_element(mapped_basis_view<StateVector, Ref>& view,
+template <typename StateVector, bool Ref, typename Map, typename T>
+inline void update_add_element(mapped_basis_view<StateVector, Ref, Map>& view,
                                sv_index_type n,
                                T&& value) {
   update_add_element(view.state_vector, view.map.at(n), std::forward<T>(value));
 }
 
 // update_add_element() is not defined for constant views
-template <typename StateVector, bool Ref, typename T>
-inline void update_add_element(mapped_basis_view<StateVector const, Ref>&,
+template <typename StateVector, bool Ref, typename Map, typename T>
+inline void update_add_element(mapped_basis_view<StateVector const, Ref, Map>&,
                                sv_index_type,
                                T&&) {
   static_assert(!std::is_same<StateVector, StateVector>::value,
@@ -86,177 +105,300 @@ inline void update_add_element(mapped_basis_view<StateVector const, Ref>&,
 }
 
 // zeros_like() is not defined for views
-template <typename StateVector, bool Ref>
-inline StateVector zeros_like(mapped_basis_view<StateVector, Ref> const&) {
+template <typename StateVector, bool Ref, typename Map>
+inline StateVector zeros_like(mapped_basis_view<StateVector, Ref, Map> const&) {
   static_assert(!std::is_same<StateVector, StateVector>::value,
                 "zeros_like() is not supported for views");
 }
 
 // Set all amplitudes stored in the adapted StateVector object to zero
-template <typename StateVector, bool Ref>
-inline void set_zeros(mapped_basis_view<StateVector, Ref>& view) {
+template <typename StateVector, bool Ref, typename Map>
+inline void set_zeros(mapped_basis_view<StateVector, Ref, Map>& view) {
   set_zeros(view.state_vector);
 }
 
 // set_zeros() is not defined for constant views
-template <typename StateVector, bool Ref>
-inline void set_zeros(mapped_basis_view<StateVector const, Ref>&) {
+template <typename StateVector, bool Ref, typename Map>
+inline void set_zeros(mapped_basis_view<StateVector const, Ref, Map>&) {
   static_assert(!std::is_same<StateVector, StateVector>::value,
                 "set_zeros() is not supported for constant views");
 }
 
 // Apply functor `f` to all index/non-zero amplitude pairs
-// in the adapted StateVector object. This functions iterates over all values
-// stored in view.map.
-template <typename StateVector, bool Ref, typename Functor>
-inline void foreach(mapped_basis_view<StateVector, Ref> const& view,
+// in the adapted StateVector object. This functions iterates over elements of
+// the adapted StateVector object in order if view.basis_states is set, and
+// over all values stored in view.map otherwise.
+template <typename StateVector, bool Ref, typename Map, typename Functor>
+inline void foreach(mapped_basis_view<StateVector, Ref, Map> const& view,
                     Functor&& f) {
   using T = typename mapped_basis_view<StateVector, Ref>::scalar_type;
+  if(view.basis_states != nullptr) {
+    auto const& basis_states = *view.basis_states;
+    for(sv_index_type n = 0; n < basis_states.size(); ++n) {
+      // Emulate decltype(auto)
+      decltype(get_element(view.state_vector, n)) a =
+          get_element(view.state_vector, n);
+      if(is_zero_amplitude<T>(a))
+        continue;
+      else
+        f(basis_states[n], a);
+    }
+    return;
+  }
   for(auto const& p : view.map) {
     // Emulate decltype(auto)
     decltype(get_element(view.state_vector, p.second)) a =
         get_element(view.state_vector, p.second);
-    if(scalar_traits<T>::is_zero(a))
+    if(is_zero_amplitude<T>(a))
       continue;
     else
       f(p.first, a);
   }
 }
 
+namespace detail {
+
+// Build a basis map from a list of basis states
+template <typename Map>
+inline Map make_basis_map(std::vector<sv_index_type> basis_states) {
+  return Map(std::move(basis_states));
+}
+
+// Build an std::unordered_map from a list of basis states. Basis states are
+// mapped to their positions within the list with duplicates removed.
+template <>
+inline std::unordered_map<sv_index_type, sv_index_type>
+make_basis_map<std::unordered_map<sv_index_type, sv_index_type>>(
+    std::vector<sv_index_type> basis_states) {
+  std::unordered_map<sv_index_type, sv_index_type> map;
+  for(auto n : basis_states)
+    map.emplace(n, map.size());
+  return map;
+}
+
+// Dense inverse of a basis map. Array-based maps already store it.
+template <typename Map> class basis_map_inverse {
+public:
+  basis_map_inverse() = default;
+  explicit basis_map_inverse(Map const&) {}
+  std::vector<sv_index_type> const& get(Map const& map) const {
+    return map.basis_states();
+  }
+};
+
+// Dense inverse of an std::unordered_map with values 0, ..., size() - 1
+template <>
+class basis_map_inverse<std::unordered_map<sv_index_type, sv_index_type>> {
+  std::vector<sv_index_type> basis_states_;
+
+public:
+  basis_map_inverse() = default;
+  explicit basis_map_inverse(
+      std::unordered_map<sv_index_type, sv_index_type> const& map)
+    : basis_states_(map.size()) {
+    for(auto const& p : map)
+      basis_states_[p.second] = p.first;
+  }
+  std::vector<sv_index_type> const&
+  get(std::unordered_map<sv_index_type, sv_index_type> const&) const {
+    return basis_states_;
+  }
+};
+
+} // namespace detail
+
 //
 // Factory class for mapped_basis_view
 //
-class basis_mapper {
+template <typename Map = std::unordered_map<sv_index_type, sv_index_type>>
+class basic_basis_mapper {
 
-  std::unordered_map<sv_index_type, sv_index_type> map_;
+  Map map_;
+  detail::basis_map_inverse<Map> inverse_;
 
+  // Apply O to each basis state from a sorted list 'states', and return
+  // a sorted list of all basis states contributing to the results. The list
+  // is processed in parallel if OpenMP is enabled.
   template <typename LOpScalarType, int... LOpAlgebraIDs>
-  void compositions_constructor_impl(
-      std::vector<loperator<LOpScalarType, LOpAlgebraIDs...>> const& O_list,
-      sparse_state_vector<typename loperator<LOpScalarType, LOpAlgebraIDs...>::
-                              scalar_type> const& st,
-      int m,
-      int sum_n,
-      int N) {
-
-    if(sum_n == N) {
-      foreach(st,
-              [&](sv_index_type out_index,
-                  typename loperator<LOpScalarType,
-                                     LOpAlgebraIDs...>::scalar_type const&) {
-                map_.emplace(out_index, map_.size());
-              });
-    }
+  static std::vector<sv_index_type>
+  apply_to_basis_states(loperator<LOpScalarType, LOpAlgebraIDs...> const& O,
+                        std::vector<sv_index_type> const& states,
+                        sv_index_type dim) {
+    using scalar_type =
+        typename loperator<LOpScalarType, LOpAlgebraIDs...>::scalar_type;
+    std::vector<sv_index_type> images;
+    std::ptrdiff_t const n_states = states.size();
 
-    if(std::size_t(m) == O_list.size()) return;
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+    {
+      sparse_state_vector<scalar_type> in_state(dim);
+      sparse_state_vector<scalar_type> out_state(dim);
+      std::vector<sv_index_type> local_images;
 
-    compositions_constructor_impl(O_list, st, m + 1, sum_n, N);
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 256) nowait
+#endif
+      for(std::ptrdiff_t i = 0; i < n_states; ++i) {
+        in_state[states[i]] = scalar_traits<scalar_type>::make_const(1);
+        O(in_state, out_state);
+        foreach(out_state, [&](sv_index_type out_index, scalar_type const&) {
+          local_images.push_back(out_index);
+        });
+        set_zeros(in_state);
+      }
+
+#ifdef _OPENMP
+#pragma omp critical
+#endif
+      images.insert(images.end(), local_images.begin(), local_images.end());
+    }
+
+    std::sort(images.begin(), images.end());
+    images.erase(std::unique(images.begin(), images.end()), images.end());
+    return images;
+  }
 
-    auto from_st = st;
-    auto to_st = zeros_like(st);
-    for(; sum_n < N; ++sum_n) {
-      O_list[m](from_st, to_st);
-      if(to_st.n_nonzeros() == 0) return;
-      compositions_constructor_impl(O_list, to_st, m + 1, sum_n + 1, N);
-      from_st = to_st;
+  // Build map_ and inverse_ from a list of discovered basis states
+  void init(std::vector<sv_index_type> basis_states, bool sort_basis_states) {
+    if(sort_basis_states) {
+      std::sort(basis_states.begin(), basis_states.end());
+      basis_states.erase(std::unique(basis_states.begin(), basis_states.end()),
+                         basis_states.end());
     }
+    map_ = detail::make_basis_map<Map>(std::move(basis_states));
+    inverse_ = detail::basis_map_inverse<Map>(map_);
   }
 
 public:
+  using map_type = Map;
+
   // Build a mapping from a list of basis states
-  // to their positions within the list
-  explicit basis_mapper(std::vector<sv_index_type> const& basis_state_indices) {
-    std::transform(
-        basis_state_indices.begin(),
-        basis_state_indices.end(),
-        std::inserter(map_, map_.end()),
-        [this](sv_index_type n) { return std::make_pair(n, map_.size()); });
-  }
+  // to their positions within the list (std::unordered_map) or within
+  // the internal array of an array-based map
+  explicit basic_basis_mapper(
+      std::vector<sv_index_type> const& basis_state_indices)
+    : map_(detail::make_basis_map<Map>(basis_state_indices)),
+      inverse_(map_) {}
 
   // Build a mapping from a set of all basis states contributing to O|vac>.
-  // Mapped values are assigned continuously but without any specific order.
+  // Mapped values are assigned continuously in the order of basis state
+  // indices if 'sort_basis_states' is true, and without any specific order
+  // otherwise.
   template <typename HSType, typename LOpScalarType, int... LOpAlgebraIDs>
-  basis_mapper(loperator<LOpScalarType, LOpAlgebraIDs...> const& O,
-               HSType const& hs) {
+  basic_basis_mapper(loperator<LOpScalarType, LOpAlgebraIDs...> const& O,
+                     HSType const& hs,
+                     bool sort_basis_states = false) {
     using scalar_type =
         typename loperator<LOpScalarType, LOpAlgebraIDs...>::scalar_type;
     sv_index_type dim = get_dim(hs);
     sparse_state_vector<scalar_type> vac(dim);
     vac[0] = 1;
     auto st = O(vac);
+    std::vector<sv_index_type> basis_states;
+    basis_states.reserve(st.n_nonzeros());
     foreach(st, [&](sv_index_type out_index, scalar_type const&) {
-      map_.emplace(out_index, map_.size());
+      basis_states.push_back(out_index);
     });
+    init(std::move(basis_states), sort_basis_states);
   }
 
   // Given a list of operators {O_1, O_2, O_3, ... , O_M}, build a mapping
   // including all basis states contributing to all states
   // O_1^{n_1} O_2^{n_2} ... O_M^{n_M} |vac>, where n_m >= 0 and
-  // \sum_{m=1}^M n_M = N.
-  // Mapped values are assigned continuously but without any specific order.
+  // \sum_{m=1}^M n_M = N. Accidental cancellations of amplitudes in
+  // superpositions of basis states are not taken into account.
+  // Mapped values are assigned continuously in the order of basis state
+  // indices.
   template <typename HSType, typename LOpScalarType, int... LOpAlgebraIDs>
-  basis_mapper(
+  basic_basis_mapper(
       std::vector<loperator<LOpScalarType, LOpAlgebraIDs...>> const& O_list,
       HSType const& hs,
       unsigned int N) {
     if(N == 0 || O_list.size() == 0) {
-      map_.emplace(0, 0);
+      init({0}, false);
       return;
     }
-    using scalar_type =
-        typename loperator<LOpScalarType, LOpAlgebraIDs...>::scalar_type;
-    sparse_state_vector<scalar_type> vac(get_dim(hs));
-    vac[0] = 1;
-    compositions_constructor_impl(O_list, vac, 0, 0, N);
+    sv_index_type dim = get_dim(hs);
+
+    // Sorted lists of basis states contributing to compositions of
+    // the operators processed so far, indexed by the sum of powers n.
+    // The lists are expanded level by level,
+    // level[n] <- level[n] \cup O_m level[n - 1].
+    std::vector<std::vector<sv_index_type>> levels(N + 1);
+    levels[0] = {0};
+    std::vector<sv_index_type> merged;
+    for(auto const& O : O_list) {
+      for(unsigned int n = 1; n <= N; ++n) {
+        if(levels[n - 1].empty()) continue;
+        auto images = apply_to_basis_states(O, levels[n - 1], dim);
+        merged.clear();
+        std::set_union(levels[n].begin(),
+                       levels[n].end(),
+                       images.begin(),
+                       images.end(),
+                       std::back_inserter(merged));
+        std::swap(levels[n], merged);
+      }
+    }
+    // levels[N] is already sorted
+    init(std::move(levels[N]), false);
   }
 
   // Number of basis states in the mapping
   inline sv_index_type size() const { return map_.size(); }
 
   // Direct access to the mapping
-  inline std::unordered_map<sv_index_type, sv_index_type> const& map() const {
-    return map_;
+  inline Map const& map() const { return map_; }
+
+  // Basis states ordered by their mapped indices (dense inverse mapping)
+  inline std::vector<sv_index_type> const& basis_states() const {
+    return inverse_.get(map_);
   }
 
-  // Direct access to the inverse mapping (slow!)
+  // Inverse mapping as an std::unordered_map (slow!)
   inline std::unordered_map<sv_index_type, sv_index_type> inverse_map() const {
-    std::unordered_map<sv_index_type, sv_index_type> inv_map;
-    std::transform(map_.begin(),
-                   map_.end(),
-                   std::inserter(inv_map, inv_map.end()),
-                   [](std::pair<sv_index_type, sv_index_type> const& p) {
-                     return std::make_pair(p.second, p.first);
-                   });
-    // Check that map_ is actually invertible
-    assert(inv_map.size() == map_.size());
+    auto const& states = basis_states();
+    std::unordered_map<sv_index_type, sv_index_type> inv_map(states.size());
+    for(sv_index_type n = 0; n < states.size(); ++n)
+      inv_map.emplace(n, states[n]);
     return inv_map;
   }
 
   template <typename StateVector>
   using make_view_ret_t =
       mapped_basis_view<remove_cvref_t<StateVector>,
-                        std::is_lvalue_reference<StateVector>::value>;
+                        std::is_lvalue_reference<StateVector>::value,
+                        Map>;
 
   // Make a non-constant basis mapping view
   template <typename StateVector>
   auto make_view(StateVector&& sv) const -> make_view_ret_t<StateVector> {
-    return make_view_ret_t<StateVector>(std::forward<StateVector>(sv), map_);
+    return make_view_ret_t<StateVector>(std::forward<StateVector>(sv),
+                                        map_,
+                                        basis_states());
   }
 
   template <typename StateVector>
   using make_const_view_ret_t =
       mapped_basis_view<remove_cvref_t<StateVector> const,
-                        std::is_lvalue_reference<StateVector>::value>;
+                        std::is_lvalue_reference<StateVector>::value,
+                        Map>;
 
   // Make a constant basis mapping view
   template <typename StateVector>
   auto make_const_view(StateVector&& sv) const
       -> make_const_view_ret_t<StateVector> {
     return make_const_view_ret_t<StateVector>(std::forward<StateVector>(sv),
-                                              map_);
+                                              map_,
+                                              basis_states());
   }
 };
 
+// Factory class for mapped_basis_view based on std::unordered_map
+using basis_mapper = basic_basis_mapper<>;
+
 } // namespace libcommute
 
 #endif
@@ -0,0 +1,224 @@
+/*******************************************************************************
+ *
+ * This file is part of libcommute, a quantum operator algebra DSL and
+ * exact diagonalization toolkit for C++11/14/17.
+ *
+ * Copyright (C) 2016-2021 Igor Krivenko <igor.s.krivenko@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ ******************************************************************************/
+#ifndef LIBCOMMUTE_LOPERATOR_MAPPED_FILE_HPP_
+#define LIBCOMMUTE_LOPERATOR_MAPPED_FILE_HPP_
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//
+// RAII wrapper around a memory-mapped file (POSIX only)
+//
+
+namespace libcommute {
+
+class mapped_file {
+
+public:
+  // How the file is opened
+  enum open_mode {
+    create,    // Create a new file or truncate an existing one, read-write
+    read_only, // Open an existing file for reading
+    read_write // Open an existing file for reading and writing
+  };
+
+  // Expected access pattern, passed to the kernel as a hint
+  enum access_pattern { normal, sequential, random };
+
+private:
+  std::string path_;
+  open_mode mode_ = read_only;
+  int fd_ = -1;
+  void* data_ = nullptr;
+  std::size_t size_ = 0;
+
+  [[noreturn]] void fail(std::string const& what, int err = errno) const {
+    throw std::system_error(err,
+                            std::generic_category(),
+                            what + " '" + path_ + "'");
+  }
+
+  void map() {
+    if(size_ == 0) {
+      data_ = nullptr;
+      return;
+    }
+    int prot = mode_ == read_only ? PROT_READ : (PROT_READ | PROT_WRITE);
+    void* p = ::mmap(nullptr, size_, prot, MAP_SHARED, fd_, 0);
+    if(p == MAP_FAILED) fail("Cannot memory-map file");
+    data_ = p;
+  }
+
+  void unmap() {
+    if(data_ != nullptr) ::munmap(data_, size_);
+    data_ = nullptr;
+  }
+
+  // Pass advice about a byte range to madvise(), which requires
+  // a page-aligned start address
+  void advise_range(std::size_t offset, std::size_t length, int advice) const {
+    if(data_ == nullptr || offset >= size_) return;
+    std::size_t begin = offset / page_size() * page_size();
+    std::size_t end = std::min(offset + length, size_);
+    ::madvise(static_cast<char*>(data_) + begin, end - begin, advice);
+  }
+
+public:
+  mapped_file() = default;
+
+  // Open file `path` in a given mode. In the `create` mode, the file is
+  // resized to `size` bytes.
+  mapped_file(std::string path, open_mode mode, std::size_t size = 0)
+    : path_(std::move(path)), mode_(mode) {
+    int flags = mode == create ? (O_RDWR | O_CREAT | O_TRUNC)
+                               : (mode == read_only ? O_RDONLY : O_RDWR);
+    fd_ = ::open(path_.c_str(), flags, 0644);
+    if(fd_ < 0) fail("Cannot open file");
+
+    if(mode == create) {
+      if(::ftruncate(fd_, static_cast<off_t>(size)) != 0) {
+        int err = errno;
+        ::close(fd_);
+        fail("Cannot resize file", err);
+      }
+      size_ = size;
+    } else {
+      struct stat st {};
+      if(::fstat(fd_, &st) != 0) {
+        int err = errno;
+        ::close(fd_);
+        fail("Cannot stat file", err);
+      }
+      size_ = static_cast<std::size_t>(st.st_size);
+    }
+
+    try {
+      map();
+    } catch(...) {
+      ::close(fd_);
+      throw;
+    }
+  }
+
+  mapped_file(mapped_file const&) = delete;
+  mapped_file& operator=(mapped_file const&) = delete;
+
+  mapped_file(mapped_file&& f) noexcept
+    : path_(std::move(f.path_)),
+      mode_(f.mode_),
+      fd_(f.fd_),
+      data_(f.data_),
+      size_(f.size_) {
+    f.fd_ = -1;
+    f.data_ = nullptr;
+    f.size_ = 0;
+  }
+  mapped_file& operator=(mapped_file&& f) noexcept {
+    if(this != &f) {
+      close();
+      path_ = std::move(f.path_);
+      mode_ = f.mode_;
+      fd_ = f.fd_;
+      data_ = f.data_;
+      size_ = f.size_;
+      f.fd_ = -1;
+      f.data_ = nullptr;
+      f.size_ = 0;
+    }
+    return *this;
+  }
+
+  ~mapped_file() { close(); }
+
+  // Unmap and close the file
+  void close() noexcept {
+    unmap();
+    if(fd_ >= 0) ::close(fd_);
+    fd_ = -1;
+    size_ = 0;
+  }
+
+  // Is the file open?
+  bool is_open() const { return fd_ >= 0; }
+
+  // Path to the file
+  std::string const& path() const { return path_; }
+
+  // Size of the file in bytes
+  std::size_t size() const { return size_; }
+
+  // Pointer to the beginning of the mapped memory region
+  void* data() { return data_; }
+  void const* data() const { return data_; }
+
+  // Change size of the file to `size` bytes and remap it. Pointers obtained
+  // from data() before the call are invalidated.
+  void resize(std::size_t size) {
+    unmap();
+    if(::ftruncate(fd_, static_cast<off_t>(size)) != 0)
+      fail("Cannot resize file");
+    size_ = size;
+    map();
+  }
+
+  // Hint the kernel at the expected access pattern to the mapped memory
+  void advise(access_pattern pattern) const {
+    if(data_ == nullptr) return;
+    int advice = pattern == sequential
+                     ? MADV_SEQUENTIAL
+                     : (pattern == random ? MADV_RANDOM : MADV_NORMAL);
+    ::madvise(data_, size_, advice);
+  }
+
+  // Ask the kernel to read pages overlapping with the byte range
+  // [offset, offset + length) ahead of time
+  void prefetch(std::size_t offset, std::size_t length) const {
+    advise_range(offset, length, MADV_WILLNEED);
+  }
+
+  // Tell the kernel that pages within the byte range [offset, offset + length)
+  // will not be accessed in the near future. Modified pages are retained in
+  // the page cache and eventually written back to the file.
+  void release(std::size_t offset, std::size_t length) const {
+    std::size_t page = page_size();
+    // Only whole pages are released
+    std::size_t begin = (offset + page - 1) / page * page;
+    std::size_t end = std::min(offset + length, size_) / page * page;
+    if(end > begin) advise_range(begin, end - begin, MADV_DONTNEED);
+  }
+
+  // Size of a memory page in bytes
+  static std::size_t page_size() {
+    static std::size_t const size = std::size_t(::sysconf(_SC_PAGESIZE));
+    return size;
+  }
+
+  // Write modified pages back to the file
+  void sync() const {
+    if(data_ == nullptr) return;
+    if(::msync(data_, size_, MS_SYNC) != 0) fail("Cannot synchronize");
+  }
+};
+
+} // namespace libcommute
+
+#endif
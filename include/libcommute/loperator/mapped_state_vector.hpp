@@ -0,0 +1,246 @@
+/*******************************************************************************
+ *
+ * This file is part of libcommute, a quantum operator algebra DSL and
+ * exact diagonalization toolkit for C++11/14/17.
+ *
+ * Copyright (C) 2016-2021 Igor Krivenko <igor.s.krivenko@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ ******************************************************************************/
+#ifndef LIBCOMMUTE_LOPERATOR_MAPPED_STATE_VECTOR_HPP_
+#define LIBCOMMUTE_LOPERATOR_MAPPED_STATE_VECTOR_HPP_
+
+#include "../scalar_traits.hpp"
+#include "mapped_file.hpp"
+#include "state_vector.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <stdlib.h>
+#include <unistd.h>
+
+//
+// Implementation of the StateVector concept based on a memory-mapped file
+// (POSIX only)
+//
+
+namespace libcommute {
+
+template <typename ScalarType> class mapped_state_vector {
+
+  // A newly created (truncated) file reads as zeros. This is a valid zero
+  // amplitude only for the built-in arithmetic and complex types.
+  static_assert(std::is_arithmetic<ScalarType>::value ||
+                    is_complex<ScalarType>::value,
+                "Unsupported amplitude type of a mapped state vector");
+
+  sv_index_type size_ = 0;
+  mapped_file file_;
+
+  // Remove the file when the vector is destroyed
+  bool temporary_ = false;
+
+  // Size of chunks processed by foreach(), in bytes
+  std::size_t chunk_size_ = default_chunk_size;
+
+  inline ScalarType* data() { return static_cast<ScalarType*>(file_.data()); }
+  inline ScalarType const* data() const {
+    return static_cast<ScalarType const*>(file_.data());
+  }
+
+  void remove_temporary() noexcept {
+    if(temporary_) {
+      std::string path = file_.path();
+      file_.close();
+      ::unlink(path.c_str());
+    }
+    temporary_ = false;
+  }
+
+public:
+  // Default size of chunks processed by foreach(), in bytes
+  static constexpr std::size_t default_chunk_size = std::size_t(1) << 24;
+
+  mapped_state_vector() = delete;
+
+  // Create a zero vector of a given size stored in file `path`.
+  // An existing file is overwritten.
+  mapped_state_vector(std::string const& path, sv_index_type size)
+    : size_(size),
+      file_(path, mapped_file::create, size * sizeof(ScalarType)) {}
+
+  // Open a vector previously stored in file `path`
+  mapped_state_vector(std::string const& path, mapped_file::open_mode mode)
+    : file_(path, mode) {
+    if(file_.size() % sizeof(ScalarType) != 0)
+      throw std::runtime_error("Size of file '" + path +
+                               "' is not a multiple of the amplitude size");
+    size_ = file_.size() / sizeof(ScalarType);
+  }
+
+  // Create a zero vector stored in a new uniquely named file. The name
+  // starts with `path_prefix`, and the file is removed when the vector
+  // is destroyed.
+  static mapped_state_vector make_temporary(std::string const& path_prefix,
+                                            sv_index_type size) {
+    std::vector<char> path(path_prefix.begin(), path_prefix.end());
+    for(char c : std::string(".XXXXXX"))
+      path.push_back(c);
+    path.push_back('\0');
+    int fd = ::mkstemp(path.data());
+    if(fd < 0)
+      throw std::system_error(errno,
+                              std::generic_category(),
+                              "Cannot create temporary file '" +
+                                  std::string(path.data()) + "'");
+    ::close(fd);
+
+    mapped_state_vector sv(std::string(path.data()), size);
+    sv.temporary_ = true;
+    return sv;
+  }
+
+  mapped_state_vector(mapped_state_vector const&) = delete;
+  mapped_state_vector& operator=(mapped_state_vector const&) = delete;
+
+  mapped_state_vector(mapped_state_vector&& sv) noexcept
+    : size_(sv.size_),
+      file_(std::move(sv.file_)),
+      temporary_(sv.temporary_),
+      chunk_size_(sv.chunk_size_) {
+    sv.size_ = 0;
+    sv.temporary_ = false;
+  }
+  mapped_state_vector& operator=(mapped_state_vector&& sv) noexcept {
+    if(this != &sv) {
+      remove_temporary();
+      size_ = sv.size_;
+      file_ = std::move(sv.file_);
+      temporary_ = sv.temporary_;
+      chunk_size_ = sv.chunk_size_;
+      sv.size_ = 0;
+      sv.temporary_ = false;
+    }
+    return *this;
+  }
+
+  ~mapped_state_vector() { remove_temporary(); }
+
+  // Size of the vector
+  inline sv_index_type size() const { return size_; }
+
+  // Underlying memory-mapped file
+  inline mapped_file const& file() const { return file_; }
+
+  // Is the file removed when the vector is destroyed?
+  inline bool is_temporary() const { return temporary_; }
+
+  // Size of chunks processed by foreach(), in bytes
+  inline std::size_t chunk_size() const { return chunk_size_; }
+
+  // Set size of chunks processed by foreach(). It is rounded up to a multiple
+  // of the memory page size.
+  inline void set_chunk_size(std::size_t chunk_size) {
+    std::size_t page = mapped_file::page_size();
+    chunk_size_ = std::max((chunk_size + page - 1) / page * page, page);
+  }
+
+  // Hint the kernel at the expected access pattern to the whole vector
+  inline void advise(mapped_file::access_pattern pattern) const {
+    file_.advise(pattern);
+  }
+
+  // Write modified amplitudes back to the file
+  inline void sync() const { file_.sync(); }
+
+  // Element access
+  inline ScalarType& operator[](sv_index_type n) {
+    assert(n < size_);
+    return data()[n];
+  }
+  inline ScalarType const& operator[](sv_index_type n) const {
+    assert(n < size_);
+    return data()[n];
+  }
+
+  // Get n-th state amplitude
+  inline friend ScalarType const& get_element(mapped_state_vector const& sv,
+                                              sv_index_type n) {
+    assert(n < sv.size_);
+    return sv.data()[n];
+  }
+
+  // Add a constant to the n-th state amplitude
+  template <typename T>
+  inline friend void
+  update_add_element(mapped_state_vector& sv, sv_index_type n, T&& value) {
+    assert(n < sv.size_);
+    add_assign(sv.data()[n], value);
+  }
+
+  // Set all amplitudes to zero. The file is truncated and extended back to
+  // its size, which discards its pages instead of overwriting them.
+  inline friend void set_zeros(mapped_state_vector& sv) {
+    sv.file_.resize(0);
+    sv.file_.resize(sv.size_ * sizeof(ScalarType));
+  }
+
+  // Make a zero vector of the same size stored in a temporary file
+  // next to the file of `sv`
+  inline friend mapped_state_vector zeros_like(mapped_state_vector const& sv) {
+    auto res = make_temporary(sv.file_.path(), sv.size_);
+    res.chunk_size_ = sv.chunk_size_;
+    return res;
+  }
+
+  // Apply functor `f` to all index/non-zero amplitude pairs in the order of
+  // ascending indices. The amplitudes are processed in page-aligned chunks.
+  // The next chunk is prefetched while the current one is being processed,
+  // and pages of processed chunks are released.
+  template <typename Functor>
+  inline friend void foreach(mapped_state_vector const& sv, Functor&& f) {
+    sv_index_type const chunk_len =
+        std::max<sv_index_type>(sv.chunk_size_ / sizeof(ScalarType), 1);
+    ScalarType const* data = sv.data();
+    for(sv_index_type begin = 0; begin < sv.size_; begin += chunk_len) {
+      sv_index_type end = std::min(begin + chunk_len, sv.size_);
+      if(end < sv.size_)
+        sv.file_.prefetch(end * sizeof(ScalarType),
+                          chunk_len * sizeof(ScalarType));
+      for(sv_index_type n = begin; n < end; ++n) {
+        auto const& a = data[n];
+        if(is_zero_amplitude<ScalarType>(a))
+          continue;
+        else
+          f(n, a);
+      }
+      sv.file_.release(begin * sizeof(ScalarType),
+                       (end - begin) * sizeof(ScalarType));
+    }
+  }
+};
+
+template <typename ScalarType>
+constexpr std::size_t mapped_state_vector<ScalarType>::default_chunk_size;
+
+// Get element type of a mapped_state_vector<ScalarType> object
+template <typename ScalarType>
+struct element_type<mapped_state_vector<ScalarType>> {
+  using type = ScalarType;
+};
+
+} // namespace libcommute
+
+#endif
@@ -0,0 +1,163 @@
+/*******************************************************************************
+ *
+ * This file is part of libcommute, a quantum operator algebra DSL and
+ * exact diagonalization toolkit for C++11/14/17.
+ *
+ * Copyright (C) 2016-2021 Igor Krivenko <igor.s.krivenko@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ ******************************************************************************/
+#ifndef LIBCOMMUTE_LOPERATOR_MOMENTUM_SECTOR_VIEW_HPP_
+#define LIBCOMMUTE_LOPERATOR_MOMENTUM_SECTOR_VIEW_HPP_
+
+#include "symmetry_sector_view.hpp"
+
+#include <cmath>
+#include <complex>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace libcommute {
+
+//
+// Momentum sector
+//
+
+// Subspace of a Hilbert space with a fixed eigenvalue e^{ik} of a translation
+// operator T with T^L = 1, k = 2\pi m / L. The subspace is spanned by states
+//
+// $$
+//   |a(k)\rangle = \frac{1}{\sqrt{N_a}}
+//                  \sum_{j=0}^{L-1} e^{-ikj} T^j |a\rangle,
+// $$
+//
+// where the representative |a> is the basis state with the smallest index
+// within its orbit {T^j |a>}, and N_a = L^2 / R_a with R_a being the orbit
+// size. Representatives with a vanishing |a(k)> are excluded.
+//
+// This is a symmetry sector of the cyclic group {T^j, j = 0, ..., L - 1} with
+// characters \chi(T^j) = e^{ikj}.
+class momentum_sector : public symmetry_sector {
+
+  // Translation operator
+  space_permutation translation_;
+
+  // Momentum k = 2\pi m / L
+  unsigned int m_;
+
+public:
+  // Construct a momentum sector from a list of basis states invariant under
+  // the translation (all basis states of a Hilbert space, of an N-fermion
+  // sector, etc).
+  momentum_sector(space_permutation translation,
+                  unsigned int m,
+                  std::vector<sv_index_type> const& basis_states)
+    : symmetry_sector(make_group(translation),
+                      make_characters(translation.order(), m),
+                      basis_states),
+      translation_(std::move(translation)),
+      m_(m) {}
+
+  // Translation operator
+  space_permutation const& translation() const { return translation_; }
+
+  // Order L of the translation operator
+  unsigned int L() const { return group().size(); }
+
+  // Momentum index m, k = 2\pi m / L
+  unsigned int m() const { return m_; }
+
+  // Momentum k
+  double k() const { return 2 * std::acos(-1.0) * m_ / L(); }
+
+  using symmetry_sector::find;
+
+  // Find the basis state |a(k)> of the momentum sector that contains
+  // the basis state |index>. Returns the serial number n of |a(k)>, or size()
+  // if there is no such state. Upon success, T^shift |index> = sign |a>.
+  sv_index_type
+  find(sv_index_type index, unsigned int& shift, int& sign) const {
+    std::size_t element = 0;
+    sv_index_type n = symmetry_sector::find(index, element, sign);
+    shift = element;
+    return n;
+  }
+
+private:
+  // Group elements T^j, j = 0, ..., L - 1
+  static std::vector<basis_symmetry>
+  make_group(space_permutation const& translation) {
+    unsigned int L = translation.order();
+    std::vector<basis_symmetry> group;
+    group.reserve(L);
+    for(unsigned int j = 0; j < L; ++j)
+      group.emplace_back(translation.power(j));
+    return group;
+  }
+
+  // Characters e^{ikj}, j = 0, ..., L - 1. Real characters are set exactly.
+  static std::vector<std::complex<double>> make_characters(unsigned int L,
+                                                           unsigned int m) {
+    if(m >= L)
+      throw std::invalid_argument("Momentum index " + std::to_string(m) +
+                                  " must be smaller than " +
+                                  std::to_string(L));
+    std::vector<std::complex<double>> characters;
+    characters.reserve(L);
+    for(unsigned int j = 0; j < L; ++j) {
+      sv_index_type mj = (sv_index_type(m) * j) % L;
+      if(mj == 0)
+        characters.emplace_back(1.0);
+      else if(2 * mj == L)
+        characters.emplace_back(-1.0);
+      else
+        characters.push_back(std::polar(1.0, 2 * std::acos(-1.0) * mj / L));
+    }
+    return characters;
+  }
+};
+
+// Make a shared momentum sector
+inline std::shared_ptr<momentum_sector const>
+make_momentum_sector(space_permutation translation,
+                     unsigned int m,
+                     std::vector<sv_index_type> const& basis_states) {
+  return std::make_shared<momentum_sector const>(std::move(translation),
+                                                 m,
+                                                 basis_states);
+}
+
+// View of a state vector in a momentum sector. Elements of the adapted state
+// vector are amplitudes of the states |a(k)>. Momentum sector views are
+// symmetry sector views, and k != 0, \pi require complex amplitudes.
+template <typename StateVector, bool Ref = true>
+using momentum_sector_view = symmetry_sector_view<StateVector, Ref>;
+
+// Make a non-constant momentum sector view
+template <typename StateVector>
+auto make_momentum_sector_view(StateVector&& sv,
+                               std::shared_ptr<momentum_sector const> sector)
+    -> make_symmetry_sector_view_ret_t<StateVector> {
+  return make_symmetry_sector_view(std::forward<StateVector>(sv),
+                                   std::move(sector));
+}
+
+// Make a constant momentum sector view
+template <typename StateVector>
+auto make_const_momentum_sector_view(
+    StateVector&& sv,
+    std::shared_ptr<momentum_sector const> sector)
+    -> make_const_symmetry_sector_view_ret_t<StateVector> {
+  return make_const_symmetry_sector_view(std::forward<StateVector>(sv),
+                                         std::move(sector));
+}
+
+} // namespace libcommute
+
+#endif
@@ -22,8 +22,8 @@
 
 #include <algorithm>
 #include <cassert>
-#include <functional>
 #include <iterator>
+#include <memory>
 #include <numeric>
 #include <set>
 #include <sstream>
@@ -34,6 +34,16 @@
 #include <utility>
 #include <vector>
 
+// BMI2 instructions PEXT and PDEP are used only if explicitly requested by
+// defining LIBCOMMUTE_USE_BMI2. They are slow (microcoded) on some CPUs.
+// The macro must be defined consistently in all translation units.
+#ifdef LIBCOMMUTE_USE_BMI2
+#if !defined(__BMI2__) || !defined(__x86_64__)
+#error "LIBCOMMUTE_USE_BMI2 requires an x86-64 target with BMI2 enabled"
+#endif
+#include <immintrin.h>
+#endif
+
 namespace libcommute {
 
 template <typename HSType> struct sector_descriptor;
@@ -55,6 +65,141 @@ inline sv_index_type binomial(unsigned int n, unsigned int k) {
   return C;
 }
 
+// Number of set bits in n
+inline unsigned int popcount(sv_index_type n) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_popcountll(n);
+#else
+  unsigned int count = 0;
+  for(; n != 0; n &= n - 1)
+    ++count;
+  return count;
+#endif
+}
+
+// Position of the most significant set bit in n != 0
+inline unsigned int highest_set_bit(sv_index_type n) {
+  assert(n != 0);
+#if defined(__GNUC__) || defined(__clang__)
+  return 63 - __builtin_clzll(n);
+#else
+  unsigned int b = 0;
+  while(n >>= 1)
+    ++b;
+  return b;
+#endif
+}
+
+// Parallel bit extraction: Bits of an index selected by a mask are packed
+// into the lowest bits of the result (same as the PEXT instruction).
+// The bits are gathered using one lookup table per byte of the mask, or
+// using PEXT if LIBCOMMUTE_USE_BMI2 is defined. The tables are built in both
+// cases, so that the layout of the class does not depend on the macro.
+class bit_gather {
+
+  // Mask selecting the bits to be extracted
+  sv_index_type mask_;
+
+  // Number of bytes up to the most significant set bit of the mask
+  unsigned int n_bytes_;
+
+  // Packed bits, table_[c * 256 + v] for byte value v at byte position c
+  std::vector<sv_index_type> table_;
+
+public:
+  explicit bit_gather(sv_index_type mask) : mask_(mask) {
+    n_bytes_ = 0;
+    for(sv_index_type m = mask; m != 0; m >>= 8)
+      ++n_bytes_;
+    table_.resize(std::size_t(n_bytes_) << 8);
+    unsigned int shift = 0;
+    for(unsigned int c = 0; c < n_bytes_; ++c) {
+      sv_index_type byte_mask = (mask >> (8 * c)) & 0xFF;
+      for(sv_index_type v = 0; v < 256; ++v) {
+        sv_index_type packed = 0;
+        unsigned int k = 0;
+        for(unsigned int b = 0; b < 8; ++b) {
+          if((byte_mask >> b) & 1) {
+            packed += ((v >> b) & 1) << k;
+            ++k;
+          }
+        }
+        table_[(c << 8) + v] = packed << shift;
+      }
+      shift += popcount(byte_mask);
+    }
+  }
+
+  // Mask selecting the bits to be extracted
+  sv_index_type mask() const { return mask_; }
+
+  // Number of extracted bits
+  unsigned int size() const { return popcount(mask_); }
+
+  inline sv_index_type operator()(sv_index_type index) const {
+#ifdef LIBCOMMUTE_USE_BMI2
+    return _pext_u64(index, mask_);
+#else
+    sv_index_type result = 0;
+    for(unsigned int c = 0; c < n_bytes_; ++c) {
+      result += table_[(c << 8) + (index & 0xFF)];
+      index >>= 8;
+    }
+    return result;
+#endif
+  }
+};
+
+// Parallel bit deposit: The lowest bits of an index are scattered to
+// the positions of the bits set in a mask (same as the PDEP instruction).
+// The bits are scattered using one lookup table per byte of the source index,
+// or using PDEP if LIBCOMMUTE_USE_BMI2 is defined.
+class bit_scatter {
+
+  // Mask selecting the destination bits
+  sv_index_type mask_;
+
+  // Number of bytes needed to hold popcount(mask) source bits
+  unsigned int n_bytes_;
+
+  // Scattered bits, table_[c * 256 + v] for byte value v at byte position c
+  std::vector<sv_index_type> table_;
+
+public:
+  explicit bit_scatter(sv_index_type mask) : mask_(mask) {
+    std::vector<unsigned int> positions;
+    for(unsigned int b = 0; b < 64; ++b) {
+      if((mask >> b) & 1) positions.push_back(b);
+    }
+    n_bytes_ = (positions.size() + 7) / 8;
+    table_.resize(std::size_t(n_bytes_) << 8);
+    for(unsigned int c = 0; c < n_bytes_; ++c) {
+      for(sv_index_type v = 0; v < 256; ++v) {
+        sv_index_type scattered = 0;
+        for(unsigned int b = 0; b < 8 && 8 * c + b < positions.size(); ++b)
+          scattered += ((v >> b) & 1) << positions[8 * c + b];
+        table_[(c << 8) + v] = scattered;
+      }
+    }
+  }
+
+  // Mask selecting the destination bits
+  sv_index_type mask() const { return mask_; }
+
+  inline sv_index_type operator()(sv_index_type index) const {
+#ifdef LIBCOMMUTE_USE_BMI2
+    return _pdep_u64(index, mask_);
+#else
+    sv_index_type result = 0;
+    for(unsigned int c = 0; c < n_bytes_; ++c) {
+      result += table_[(c << 8) + (index & 0xFF)];
+      index >>= 8;
+    }
+    return result;
+#endif
+  }
+};
+
 // Evaluator for sums of the following form,
 //
 // $$
@@ -152,87 +297,355 @@ private:
   }
 };
 
-// This object uses a non-recursive procedure to generate all restricted N-part
-// compositions of an integer.
-// It does heavy lifting for foreach() and n_fermion_sector_basis_states().
-struct for_each_composition {
+} // namespace detail
 
-  // Parameters of the sector
-  n_fermion_sector_params_t const& params;
+//
+// Ranking algorithms
+//
+// A ranking algorithm is constructed from parameters of an N-fermion sector
+// and maps the fermionic part of a basis state index (M lowest bits) to
+// the serial number of the basis state within the sector. All ranking
+// algorithms must produce the same serial numbers.
+//
 
-  // Restricted partition of M
-  std::vector<unsigned int> mutable lambdas;
+// Bit-by-bit ranking algorithm that computes the serial number as a sum of
+// binomial coefficient sums (one per counted fermionic mode).
+struct combination_ranking {
 
-  // Upper bounds for elements of 'lambdas'
-  std::vector<unsigned int> mutable lambdas_max;
+  // Sum of binomial coefficients
+  detail::binomial_sum_t binomial_sum;
 
-  inline explicit for_each_composition(n_fermion_sector_params_t const& params)
-    : params(params),
-      lambdas(params.N_counted, 0),
-      lambdas_max(params.N_counted, params.M - (params.N_counted - 1)) {
-    lambdas.shrink_to_fit();
-    lambdas_max.shrink_to_fit();
-  }
+  // Total number of fermionic modes
+  unsigned int M;
 
-  // Apply 'f' to each composition
-  template <typename F> void operator()(F&& f) const {
-    if(params.N_counted == 0) {
-      f(lambdas);
-      return;
-    }
+  // Count occupied or unoccupied fermionic modes
+  bool count_occupied;
 
-    std::fill(lambdas.begin(), lambdas.end(), 0);
-    std::fill(lambdas_max.begin(),
-              lambdas_max.end(),
-              params.M - (params.N_counted - 1));
-    for(int i = 0; i >= 0;) {
-      ++lambdas[i];
-      if(lambdas[i] > lambdas_max[i]) {
-        --i;
-        continue;
-      }
+  // Number of counted modes (either occupied or unoccupied)
+  unsigned int N_counted;
+
+  explicit combination_ranking(detail::n_fermion_sector_params_t const& params)
+    : binomial_sum(params.M, params.N_counted),
+      M(params.M),
+      count_occupied(params.count_occupied),
+      N_counted(params.N_counted) {}
 
-      if(static_cast<unsigned int>(i) + 1 == lambdas.size()) {
-        f(lambdas);
+  inline sv_index_type operator()(sv_index_type index_f) const {
+    unsigned int m = M;
+    unsigned int n = N_counted;
+    sv_index_type rank = 0;
+    unsigned int lambda = 1;
+    while(n > 0) {
+      if((index_f & sv_index_type(1)) == count_occupied) {
+        rank += binomial_sum(n, m, lambda);
+        m -= lambda;
+        --n;
+        lambda = 1;
       } else {
-        ++i;
-        lambdas[i] = 0;
-        lambdas_max[i] = lambdas_max[i - 1] + 1 - lambdas[i - 1];
+        ++lambda;
+      }
+      index_f >>= 1;
+    }
+    return rank;
+  }
+};
+
+// Table-driven ranking algorithm.
+//
+// The serial number of a basis state with counted modes at positions
+// p_1 > p_2 > ... > p_N is
+//
+// $$
+//   {{M}\choose{N}} - 1 - \sum_{j=1}^N {{M-1-p_j}\choose{j}}.
+// $$
+//
+// The fermionic part of the index is split into chunks of ChunkBits bits.
+// For each chunk, each possible number of counted modes below the chunk and
+// each possible value of the chunk, the partial sum over p_j within the chunk
+// is pre-computed. The rank is then found using one table lookup per chunk.
+// The tables occupy ceil(M / ChunkBits) * (N + 1) * 2^ChunkBits integers.
+template <unsigned int ChunkBits = 8> class staggered_ranking {
+
+  static_assert(ChunkBits > 0 && ChunkBits <= 16,
+                "ChunkBits must be between 1 and 16");
+
+  // Number of counted modes
+  unsigned int N_counted;
+
+  // XOR-mask used when counting unoccupied states
+  sv_index_type index_mask;
+
+  // Number of chunks
+  unsigned int n_chunks;
+
+  // Binomial[M, N_counted] - 1
+  sv_index_type max_rank;
+
+  // Partial sums, table[(c * (N_counted + 1) + k) * 2^ChunkBits + v]
+  std::vector<sv_index_type> table;
+
+  static constexpr sv_index_type chunk_mask =
+      (sv_index_type(1) << ChunkBits) - 1;
+
+public:
+  explicit staggered_ranking(detail::n_fermion_sector_params_t const& params)
+    : N_counted(params.N_counted),
+      index_mask(params.count_occupied || params.M == 0
+                     ? sv_index_type(0)
+                     : (detail::pow2(params.M) - 1)),
+      n_chunks((params.M + ChunkBits - 1) / ChunkBits),
+      max_rank(detail::binomial(params.M, params.N_counted) - 1) {
+    if(N_counted == 0) return;
+    unsigned int const M = params.M;
+    table.resize(std::size_t(n_chunks) * (N_counted + 1) << ChunkBits);
+    for(unsigned int c = 0; c < n_chunks; ++c) {
+      for(unsigned int k = 0; k <= N_counted; ++k) {
+        auto* t = &table[std::size_t(c * (N_counted + 1) + k) << ChunkBits];
+        for(sv_index_type v = 0; v <= chunk_mask; ++v) {
+          // i-th counted mode (from below) within the chunk is the j-th mode
+          // from above, j = N_counted - k - i + 1.
+          sv_index_type sum = 0;
+          unsigned int j = N_counted - k;
+          for(unsigned int b = 0; b < ChunkBits && j > 0; ++b) {
+            if((v >> b) & 1) {
+              unsigned int p = c * ChunkBits + b;
+              if(p >= M) break;
+              sum += detail::binomial(M - 1 - p, j);
+              --j;
+            }
+          }
+          t[v] = sum;
+        }
       }
     }
   }
+
+  inline sv_index_type operator()(sv_index_type index_f) const {
+    if(N_counted == 0) return 0;
+    index_f ^= index_mask;
+    sv_index_type sum = 0;
+    unsigned int k = 0;
+    for(unsigned int c = 0; c < n_chunks; ++c) {
+      sv_index_type v = index_f & chunk_mask;
+      sum += table[(std::size_t(c * (N_counted + 1) + k) << ChunkBits) + v];
+      k = std::min(k + detail::popcount(v), N_counted);
+      index_f >>= ChunkBits;
+    }
+    return max_rank - sum;
+  }
 };
 
-// Combine a composition {\lambda_i} and a basis state index from
-// the non-fermionic subspace into the index in the full Hilbert space
-struct composition_to_full_hs_index {
+// Ranking algorithm based on precomputed lookup tables for the lower and
+// the upper halves of the fermionic modes (Lin tables).
+//
+// With the serial number written as in staggered_ranking, the contribution of
+// the upper M_high = M - M_low modes depends only on their occupations, and
+// the contribution of the lower M_low = M / 2 modes depends only on their
+// occupations as well, since the number of counted modes above them is
+// N - (number of counted modes among them). Both contributions are
+// tabulated, so that the rank is found using two table lookups. The tables
+// occupy 2^M_low + 2^M_high integers and are shared between copies of
+// a lin_table_ranking object.
+class lin_table_ranking {
+
+public:
+  // Lookup tables
+  struct tables_t {
+    // Number of modes in the lower half
+    unsigned int M_low;
+
+    // Mask selecting the lower half of the modes
+    sv_index_type low_mask;
+
+    // XOR-mask used when counting unoccupied states
+    sv_index_type index_mask;
+
+    // Binomial[M, N_counted] - 1
+    sv_index_type max_rank;
+
+    // Contributions of the lower and the upper halves
+    std::vector<sv_index_type> low;
+    std::vector<sv_index_type> high;
+
+    explicit tables_t(detail::n_fermion_sector_params_t const& params);
+  };
+
+private:
+  std::shared_ptr<tables_t const> tables_;
+
+  // Copies of the table parameters and pointers to the tables
+  unsigned int M_low_;
+  sv_index_type low_mask_;
+  sv_index_type index_mask_;
+  sv_index_type max_rank_;
+  sv_index_type const* low_;
+  sv_index_type const* high_;
+
+public:
+  explicit lin_table_ranking(detail::n_fermion_sector_params_t const& params)
+    : lin_table_ranking(std::make_shared<tables_t const>(params)) {}
+
+  // Construct from precomputed lookup tables
+  explicit lin_table_ranking(std::shared_ptr<tables_t const> tables)
+    : tables_(std::move(tables)),
+      M_low_(tables_->M_low),
+      low_mask_(tables_->low_mask),
+      index_mask_(tables_->index_mask),
+      max_rank_(tables_->max_rank),
+      low_(tables_->low.data()),
+      high_(tables_->high.data()) {}
+
+  // Shared pointer to the lookup tables
+  std::shared_ptr<tables_t const> const& tables() const { return tables_; }
+
+  inline sv_index_type operator()(sv_index_type index_f) const {
+    index_f ^= index_mask_;
+    return max_rank_ - (low_[index_f & low_mask_] + high_[index_f >> M_low_]);
+  }
+};
+
+inline lin_table_ranking::tables_t::tables_t(
+    detail::n_fermion_sector_params_t const& params)
+  : M_low(params.M / 2),
+    low_mask(detail::pow2(M_low) - 1),
+    index_mask(params.count_occupied || params.M == 0
+                   ? sv_index_type(0)
+                   : (detail::pow2(params.M) - 1)),
+    max_rank(detail::binomial(params.M, params.N_counted) - 1),
+    low(detail::pow2(M_low)),
+    high(detail::pow2(params.M - M_low)) {
+  unsigned int const M = params.M;
+  unsigned int const N = params.N_counted;
+
+  // binomials[n * (N + 1) + k] = Binomial[n, k]
+  std::vector<sv_index_type> binomials((M + 1) * (N + 1));
+  for(unsigned int n = 0; n <= M; ++n) {
+    for(unsigned int k = 0; k <= N; ++k)
+      binomials[n * (N + 1) + k] = detail::binomial(n, k);
+  }
+
+  // Sum of Binomial[M - 1 - p_i, j0 + i] over counted modes p_1 > p_2 > ...
+  // in the bits of 'x' shifted by 'offset'
+  auto partial_sum = [&](sv_index_type x,
+                         unsigned int n_bits,
+                         unsigned int offset,
+                         unsigned int j0) {
+    sv_index_type sum = 0;
+    unsigned int j = j0;
+    for(unsigned int b = n_bits; b-- != 0;) {
+      if((x >> b) & 1) {
+        ++j;
+        sum += binomials[(M - 1 - (offset + b)) * (N + 1) + j];
+      }
+    }
+    return sum;
+  };
+
+  for(sv_index_type x = 0; x < low.size(); ++x) {
+    unsigned int pc = detail::popcount(x);
+    low[x] = pc > N ? 0 : partial_sum(x, M_low, 0, N - pc);
+  }
+  for(sv_index_type x = 0; x < high.size(); ++x) {
+    unsigned int pc = detail::popcount(x);
+    high[x] = pc > N ? 0 : partial_sum(x, M - M_low, M_low, 0);
+  }
+}
+
+namespace detail {
+
+// Inverse of the ranking algorithms. It computes the fermionic part of a basis
+// state index (M lowest bits) from the serial number of the basis state within
+// the sector. Counted modes at positions p_1 > p_2 > ... > p_N are recovered
+// from the combinatorial number system representation
+//
+// $$
+//   {{M}\choose{N}} - 1 - \mathrm{rank} = \sum_{j=1}^N {{M-1-p_j}\choose{j}}.
+// $$
+struct combination_unranking {
 
   // Total number of fermionic modes
   unsigned int M;
 
+  // Number of counted modes (either occupied or unoccupied)
+  unsigned int N_counted;
+
   // XOR-mask used when counting unoccupied states
-  sv_index_type const index_mask;
+  sv_index_type index_mask;
+
+  // Binomial[M, N_counted] - 1
+  sv_index_type max_rank;
+
+  // binomials[q * (N_counted + 1) + j] = Binomial[q, j]
+  std::vector<sv_index_type> binomials;
 
-  explicit composition_to_full_hs_index(n_fermion_sector_params_t const& params)
+  explicit combination_unranking(n_fermion_sector_params_t const& params)
     : M(params.M),
-      index_mask(params.count_occupied ? sv_index_type(0) : (pow2(M) - 1)) {}
+      N_counted(params.N_counted),
+      index_mask(params.count_occupied || params.M == 0
+                     ? sv_index_type(0)
+                     : (pow2(params.M) - 1)),
+      max_rank(binomial(params.M, params.N_counted) - 1),
+      binomials(std::size_t(M) * (N_counted + 1)) {
+    for(unsigned int q = 0; q < M; ++q) {
+      for(unsigned int j = 0; j <= N_counted; ++j)
+        binomials[q * (N_counted + 1) + j] = binomial(q, j);
+    }
+  }
 
-  inline sv_index_type operator()(std::vector<unsigned int> const& lambdas,
-                                  sv_index_type index_nf) const {
+  // Fermionic part of the basis state index with a given serial number
+  inline sv_index_type operator()(sv_index_type rank) const {
+    sv_index_type r = max_rank - rank;
     sv_index_type index_f = 0;
-    if(lambdas.size() != 0) {
-      std::for_each(lambdas.rbegin(),
-                    lambdas.rend(),
-                    [&index_f](unsigned int lambda) {
-                      index_f <<= 1;
-                      index_f += 1;
-                      index_f <<= lambda - 1;
-                    });
+    unsigned int q = M;
+    for(unsigned int j = N_counted; j > 0; --j) {
+      do {
+        --q;
+      } while(binomials[q * (N_counted + 1) + j] > r);
+      r -= binomials[q * (N_counted + 1) + j];
+      index_f += pow2(M - 1 - q);
     }
-    return (index_f ^ index_mask) + (index_nf << M);
+    return index_f ^ index_mask;
+  }
+
+  // Fermionic part of the basis state index following 'index_f' within the
+  // sector. 'index_f' must not be the last basis state of the sector.
+  inline sv_index_type next(sv_index_type index_f) const {
+    index_f ^= index_mask;
+    // The highest non-counted mode h lies right below the block of
+    // M - 1 - h counted modes at the top
+    unsigned int h = highest_set_bit(~index_f & (pow2(M) - 1));
+    // Move the highest counted mode below h up by one position and place
+    // the block right above it
+    sv_index_type rest = index_f & (pow2(h) - 1);
+    unsigned int p = highest_set_bit(rest);
+    index_f = (rest ^ pow2(p)) + ((pow2(M - h) - 1) << (p + 1));
+    return index_f ^ index_mask;
   }
 };
 
+// Apply 'f' to pairs (sector index, full Hilbert space index) for all sector
+// indices in the range [begin, end). The fermionic parts of basis states are
+// generated incrementally, at a cost of O(1) bit operations per state.
+template <typename F>
+void for_each_sector_state(combination_unranking const& unranking,
+                           unsigned int M_nonfermion,
+                           sv_index_type begin,
+                           sv_index_type end,
+                           F&& f) {
+  if(begin >= end) return;
+  auto dim_nonfermion = pow2(M_nonfermion);
+  sv_index_type index_f = unranking(begin >> M_nonfermion);
+  sv_index_type index_nf = begin & (dim_nonfermion - 1);
+  for(sv_index_type index = begin;;) {
+    f(index, index_f + (index_nf << unranking.M));
+    if(++index == end) break;
+    if(++index_nf == dim_nonfermion) {
+      index_nf = 0;
+      index_f = unranking.next(index_f);
+    }
+  }
+}
+
 } // namespace detail
 
 //
@@ -252,22 +665,25 @@ inline sv_index_type n_fermion_sector_size(HSType const& hs, unsigned int N) {
   return detail::binomial(M, N) * detail::pow2(total_n_bits - M);
 }
 
-template <typename StateVector, bool Ref = true>
+template <typename StateVector,
+          bool Ref = true,
+          typename RankingAlgorithm = combination_ranking>
 struct n_fermion_sector_view : public detail::n_fermion_sector_params_t {
 
   // The underlying state vector
   typename std::conditional<Ref, StateVector&, StateVector>::type state_vector;
 
-  // Sum of binomial coefficients
-  detail::binomial_sum_t binomial_sum;
+  // Ranking algorithm
+  RankingAlgorithm ranking;
 
   // Number of bits corresponding to the non-fermionic modes
   unsigned int M_nonfermion;
 
-  // Although the following two objects are not used by this class' methods,
-  // storing them here allows to eliminate memory allocations in foreach().
-  detail::for_each_composition for_each_comp;
-  detail::composition_to_full_hs_index comp_to_index;
+  // Mask selecting the fermionic bits of an index
+  sv_index_type fermion_mask;
+
+  // Inverse of the ranking algorithm
+  detail::combination_unranking unranking;
 
   using scalar_type = typename element_type<
       typename std::remove_const<StateVector>::type>::type;
@@ -276,118 +692,134 @@ struct n_fermion_sector_view : public detail::n_fermion_sector_params_t {
   n_fermion_sector_view(SV&& sv, HSType const& hs, unsigned int N)
     : detail::n_fermion_sector_params_t(hs, N),
       state_vector(std::forward<SV>(sv)),
-      binomial_sum(M, N_counted),
+      ranking(*this),
       M_nonfermion(hs.total_n_bits() - M),
-      for_each_comp(*this),
-      comp_to_index(*this) {}
+      fermion_mask(detail::pow2(M) - 1),
+      unranking(*this) {}
 
-  sv_index_type map_index(sv_index_type index) const {
-    unsigned int m = M;
-    unsigned int n = N_counted;
-    sv_index_type index_f = 0;
-    unsigned int lambda = 1;
-    // Translate the fermionic part of 'index' into the sector index
-    while(n > 0) {
-      if((index & sv_index_type(1)) == count_occupied) {
-        index_f += binomial_sum(n, m, lambda);
-        m -= lambda;
-        --n;
-        lambda = 1;
-      } else {
-        ++lambda;
-      }
-      index >>= 1;
-    }
+  // Construct a view using a given ranking algorithm object, which must have
+  // been constructed for the same N-fermion sector. This allows, for
+  // instance, to share lookup tables between multiple views.
+  template <typename SV, typename HSType>
+  n_fermion_sector_view(SV&& sv,
+                        HSType const& hs,
+                        unsigned int N,
+                        RankingAlgorithm ranking)
+    : detail::n_fermion_sector_params_t(hs, N),
+      state_vector(std::forward<SV>(sv)),
+      ranking(std::move(ranking)),
+      M_nonfermion(hs.total_n_bits() - M),
+      fermion_mask(detail::pow2(M) - 1),
+      unranking(*this) {}
 
-    // Remove the remaining fermionic bits from 'index'
-    index >>= m;
+  sv_index_type map_index(sv_index_type index) const {
+    // Translate the fermionic part of 'index' into the sector index and
+    // combine it with the non-fermionic bits of 'index'
+    return (ranking(index & fermion_mask) << M_nonfermion) + (index >> M);
+  }
 
-    // Here, 'index' contains only non-fermionic bits
-    return (index_f << M_nonfermion) + index;
+  // Translate a basis state index from the sector to the full Hilbert space
+  // (inverse of map_index())
+  sv_index_type inverse_map_index(sv_index_type index) const {
+    return unranking(index >> M_nonfermion) +
+           ((index & (detail::pow2(M_nonfermion) - 1)) << M);
   }
 };
 
 // Get element type of the StateVector object adapted by a given
 // n_fermion_sector_view object.
-template <typename StateVector, bool Ref>
-struct element_type<n_fermion_sector_view<StateVector, Ref>> {
+template <typename StateVector, bool Ref, typename RA>
+struct element_type<n_fermion_sector_view<StateVector, Ref, RA>> {
   using type = typename n_fermion_sector_view<StateVector>::scalar_type;
 };
 
 // Get state amplitude of the adapted StateVector object
 // at index view.map_index(n)
-template <typename StateVector, bool Ref>
-inline auto get_element(n_fermion_sector_view<StateVector, Ref> const& view,
-                        sv_index_type n) ->
+template <typename StateVector, bool Ref, typename RA>
+inline auto
+get_element(n_fermion_sector_view<StateVector, Ref, RA> const& view,
+            sv_index_type n) ->
     typename n_fermion_sector_view<StateVector>::scalar_type {
   return get_element(view.state_vector, view.map_index(n));
 }
 
 // Add a constant to a state amplitude stored in the adapted StateVector object
 // at index view.map_index(n)
-template <typename StateVector, bool Ref, typename T>
-inline void update_add_element(n_fermion_sector_view<StateVector, Ref>& view,
-                               sv_index_type n,
-                               T&& value) {
+template <typename StateVector, bool Ref, typename RA, typename T>
+inline void
+update_add_element(n_fermion_sector_view<StateVector, Ref, RA>& view,
+                   sv_index_type n,
+                   T&& value) {
   update_add_element(view.state_vector,
                      view.map_index(n),
                      std::forward<T>(value));
 }
 
 // update_add_element() is not defined for constant views
-template <typename StateVector, bool Ref, typename T>
-inline void update_add_element(n_fermion_sector_view<StateVector const, Ref>&,
-                               sv_index_type,
-                               T&&) {
+template <typename StateVector, bool Ref, typename RA, typename T>
+inline void
+update_add_element(n_fermion_sector_view<StateVector const, Ref, RA>&,
+                   sv_index_type,
+                   T&&) {
   static_assert(!std::is_same<StateVector, StateVector>::value,
                 "update_add_element() is not supported for constant views");
 }
 
 // zeros_like() is not defined for views
-template <typename StateVector, bool Ref>
-inline StateVector zeros_like(n_fermion_sector_view<StateVector, Ref> const&) {
+template <typename StateVector, bool Ref, typename RA>
+inline StateVector
+zeros_like(n_fermion_sector_view<StateVector, Ref, RA> const&) {
   static_assert(!std::is_same<StateVector, StateVector>::value,
                 "zeros_like() is not supported for views");
 }
 
 // Set all amplitudes stored in the adapted StateVector object to zero
-template <typename StateVector, bool Ref>
-inline void set_zeros(n_fermion_sector_view<StateVector, Ref>& view) {
+template <typename StateVector, bool Ref, typename RA>
+inline void set_zeros(n_fermion_sector_view<StateVector, Ref, RA>& view) {
   set_zeros(view.state_vector);
 }
 
 // set_zeros() is not defined for constant views
-template <typename StateVector, bool Ref>
-inline void set_zeros(n_fermion_sector_view<StateVector const, Ref>&) {
+template <typename StateVector, bool Ref, typename RA>
+inline void set_zeros(n_fermion_sector_view<StateVector const, Ref, RA>&) {
   static_assert(!std::is_same<StateVector, StateVector>::value,
                 "set_zeros() is not supported for constant views");
 }
 
-// Apply functor `f` to all index/non-zero amplitude pairs
-// in the adapted StateVector object
-template <typename StateVector, bool Ref, typename Functor>
-inline void foreach(n_fermion_sector_view<StateVector, Ref> const& view,
+// Apply functor `f` to all index/non-zero amplitude pairs in the adapted
+// StateVector object, whose sector indices lie in the range [begin, end).
+// Disjoint ranges can be processed concurrently.
+template <typename StateVector, bool Ref, typename RA, typename Functor>
+inline void foreach(n_fermion_sector_view<StateVector, Ref, RA> const& view,
+                    sv_index_type begin,
+                    sv_index_type end,
                     Functor&& f) {
   if(view.M == 0 && view.M_nonfermion == 0) return;
 
-  auto dim_nonfermion = detail::pow2(view.M_nonfermion);
-  sv_index_type sector_index = 0;
-  view.for_each_comp([&](std::vector<unsigned int> const& lambdas) {
-    for(sv_index_type index_nf = 0; index_nf < dim_nonfermion; ++index_nf) {
-
-      // Emulate decltype(auto)
-      decltype(get_element(view.state_vector, sector_index)) a =
-          get_element(view.state_vector, sector_index);
-
-      ++sector_index;
+  detail::for_each_sector_state(
+      view.unranking,
+      view.M_nonfermion,
+      begin,
+      end,
+      [&](sv_index_type sector_index, sv_index_type index) {
+        // Emulate decltype(auto)
+        decltype(get_element(view.state_vector, sector_index)) a =
+            get_element(view.state_vector, sector_index);
+
+        using T =
+            typename n_fermion_sector_view<StateVector, Ref, RA>::scalar_type;
+        if(!is_zero_amplitude<T>(a)) f(index, a);
+      });
+}
 
-      using T = typename n_fermion_sector_view<StateVector, Ref>::scalar_type;
-      if(scalar_traits<T>::is_zero(a))
-        continue;
-      else
-        f(view.comp_to_index(lambdas, index_nf), a);
-    }
-  });
+// Apply functor `f` to all index/non-zero amplitude pairs
+// in the adapted StateVector object
+template <typename StateVector, bool Ref, typename RA, typename Functor>
+inline void foreach(n_fermion_sector_view<StateVector, Ref, RA> const& view,
+                    Functor&& f) {
+  sv_index_type size = detail::binomial(view.M, view.N_counted)
+                       << view.M_nonfermion;
+  foreach(view, 0, size, std::forward<Functor>(f));
 }
 
 // Make a list of basis state indices spanning the N-fermion sector
@@ -400,46 +832,498 @@ n_fermion_sector_basis_states(HSType const& hs, unsigned int N) {
   unsigned int M_nonfermion = hs.total_n_bits() - params.M;
   if(params.M == 0 && M_nonfermion == 0) return {};
 
-  detail::for_each_composition for_each_comp(params);
-  detail::composition_to_full_hs_index comp_to_index(params);
+  detail::combination_unranking unranking(params);
 
-  sv_index_type dim_nonfermion = detail::pow2(M_nonfermion);
+  sv_index_type size = detail::binomial(params.M, N) << M_nonfermion;
 
   std::vector<sv_index_type> basis_states;
-  basis_states.reserve(detail::binomial(params.M, N) * dim_nonfermion);
-  for_each_comp([&](std::vector<unsigned int> const& lambdas) {
-    for(sv_index_type index_nf = 0; index_nf < dim_nonfermion; ++index_nf) {
-      basis_states.push_back(comp_to_index(lambdas, index_nf));
-    }
-  });
+  basis_states.reserve(size);
+  detail::for_each_sector_state(
+      unranking,
+      M_nonfermion,
+      0,
+      size,
+      [&](sv_index_type, sv_index_type index) {
+        basis_states.push_back(index);
+      });
 
   return basis_states;
 }
 
-template <typename StateVector>
+template <typename StateVector, typename RankingAlgorithm>
 using make_nfs_view_ret_t =
     n_fermion_sector_view<remove_cvref_t<StateVector>,
-                          std::is_lvalue_reference<StateVector>::value>;
+                          std::is_lvalue_reference<StateVector>::value,
+                          RankingAlgorithm>;
 
 // Make a non-constant N-fermion sector view
-template <typename StateVector, typename HSType>
+template <typename RankingAlgorithm = combination_ranking,
+          typename StateVector,
+          typename HSType>
 auto make_nfs_view(StateVector&& sv, HSType const& hs, unsigned int N)
-    -> make_nfs_view_ret_t<StateVector> {
-  return make_nfs_view_ret_t<StateVector>(std::forward<StateVector>(sv), hs, N);
+    -> make_nfs_view_ret_t<StateVector, RankingAlgorithm> {
+  return make_nfs_view_ret_t<StateVector, RankingAlgorithm>(
+      std::forward<StateVector>(sv),
+      hs,
+      N);
+}
+
+// Make a non-constant N-fermion sector view using a given ranking algorithm
+// object
+template <typename StateVector, typename HSType, typename RankingAlgorithm>
+auto make_nfs_view(StateVector&& sv,
+                   HSType const& hs,
+                   unsigned int N,
+                   RankingAlgorithm ranking)
+    -> make_nfs_view_ret_t<StateVector, RankingAlgorithm> {
+  return make_nfs_view_ret_t<StateVector, RankingAlgorithm>(
+      std::forward<StateVector>(sv),
+      hs,
+      N,
+      std::move(ranking));
 }
 
-template <typename StateVector>
+template <typename StateVector, typename RankingAlgorithm>
 using make_const_nfs_view_ret_t =
     n_fermion_sector_view<remove_cvref_t<StateVector> const,
-                          std::is_lvalue_reference<StateVector>::value>;
+                          std::is_lvalue_reference<StateVector>::value,
+                          RankingAlgorithm>;
 
 // Make a constant N-fermion sector view
-template <typename StateVector, typename HSType>
+template <typename RankingAlgorithm = combination_ranking,
+          typename StateVector,
+          typename HSType>
 auto make_const_nfs_view(StateVector&& sv, HSType const& hs, unsigned int N)
-    -> make_const_nfs_view_ret_t<StateVector> {
-  return make_const_nfs_view_ret_t<StateVector>(std::forward<StateVector>(sv),
-                                                hs,
-                                                N);
+    -> make_const_nfs_view_ret_t<StateVector, RankingAlgorithm> {
+  return make_const_nfs_view_ret_t<StateVector, RankingAlgorithm>(
+      std::forward<StateVector>(sv),
+      hs,
+      N);
+}
+
+// Make a constant N-fermion sector view using a given ranking algorithm object
+template <typename StateVector, typename HSType, typename RankingAlgorithm>
+auto make_const_nfs_view(StateVector&& sv,
+                         HSType const& hs,
+                         unsigned int N,
+                         RankingAlgorithm ranking)
+    -> make_const_nfs_view_ret_t<StateVector, RankingAlgorithm> {
+  return make_const_nfs_view_ret_t<StateVector, RankingAlgorithm>(
+      std::forward<StateVector>(sv),
+      hs,
+      N,
+      std::move(ranking));
+}
+
+//
+// N-fermion sector with a mixed-radix non-fermionic part
+//
+
+namespace detail {
+
+// Dense encoding of the non-fermionic part of a basis state index.
+//
+// Basis states of the k-th non-fermionic elementary space are indexed by
+// n_k = 0, ..., d_k - 1, where d_k does not have to be a power of 2.
+// The non-fermionic part of a basis state index is encoded as
+//
+// $$
+//   \sum_k n_k \prod_{j<k} d_j.
+// $$
+class mixed_radix_encoding {
+
+  // Non-fermionic elementary space
+  struct mode_t {
+    // Bits of the elementary space are selected as (index >> shift) & mask
+    unsigned int shift;
+    sv_index_type mask;
+    // Number of allowed basis states d_k
+    sv_index_type dim;
+    // \prod_{j<k} d_j
+    sv_index_type stride;
+  };
+
+  std::vector<mode_t> modes_;
+
+  // \prod_k d_k
+  sv_index_type size_ = 1;
+
+public:
+  // 'dims' lists d_k for all non-fermionic elementary spaces of 'hs' in
+  // the order of their bit ranges.
+  template <typename... IndexTypes>
+  mixed_radix_encoding(hilbert_space<IndexTypes...> const& hs,
+                       std::vector<sv_index_type> const& dims) {
+    hs.for_each_elementary_space(
+        [&](elementary_space<IndexTypes...> const& es,
+            bit_range_t const& range) {
+          if(es.algebra_id() == fermion) return;
+          std::size_t k = modes_.size();
+          if(k >= dims.size())
+            throw std::invalid_argument(
+                "Too few dimensions of non-fermionic elementary spaces");
+          if(dims[k] == 0 || dims[k] > es.dim())
+            throw std::invalid_argument(
+                "Wrong dimension " + std::to_string(dims[k]) +
+                " of non-fermionic elementary space " + std::to_string(k));
+          unsigned int n_bits = range.second - range.first + 1;
+          modes_.push_back({static_cast<unsigned int>(range.first),
+                            pow2(n_bits) - 1,
+                            dims[k],
+                            size_});
+          size_ *= dims[k];
+        });
+    if(modes_.size() != dims.size())
+      throw std::invalid_argument(
+          "Too many dimensions of non-fermionic elementary spaces");
+  }
+
+  // Number of encoded non-fermionic basis states
+  sv_index_type size() const { return size_; }
+
+  // Dense encoding of the non-fermionic part of 'index'
+  inline sv_index_type operator()(sv_index_type index) const {
+    sv_index_type result = 0;
+    for(auto const& mode : modes_)
+      result += ((index >> mode.shift) & mode.mask) * mode.stride;
+    return result;
+  }
+
+  // Non-fermionic part of a basis state index encoded as 'encoded'
+  inline sv_index_type decode(sv_index_type encoded) const {
+    sv_index_type index = 0;
+    for(auto const& mode : modes_) {
+      index += (encoded % mode.dim) << mode.shift;
+      encoded /= mode.dim;
+    }
+    return index;
+  }
+
+  // Do all non-fermionic elementary spaces of 'index' have n_k < d_k?
+  inline bool contains(sv_index_type index) const {
+    for(auto const& mode : modes_) {
+      if(((index >> mode.shift) & mode.mask) >= mode.dim) return false;
+    }
+    return true;
+  }
+
+  // Non-fermionic part of the basis state index that follows 'index' in
+  // the encoding order. The last basis state is followed by the first one.
+  inline sv_index_type next(sv_index_type index) const {
+    for(auto const& mode : modes_) {
+      sv_index_type n = (index >> mode.shift) & mode.mask;
+      if(n + 1 < mode.dim) return index + (sv_index_type(1) << mode.shift);
+      index -= n << mode.shift;
+    }
+    return index;
+  }
+};
+
+// Apply 'f' to pairs (sector index, full Hilbert space index) for all sector
+// indices in the range [begin, end) of an N-fermion sector with
+// a mixed-radix non-fermionic part.
+template <typename F>
+void for_each_sector_state(combination_unranking const& unranking,
+                           mixed_radix_encoding const& nonfermion,
+                           sv_index_type begin,
+                           sv_index_type end,
+                           F&& f) {
+  if(begin >= end) return;
+  sv_index_type const dim_nonfermion = nonfermion.size();
+  sv_index_type index_f = unranking(begin / dim_nonfermion);
+  sv_index_type n_nf = begin % dim_nonfermion;
+  sv_index_type index_nf = nonfermion.decode(n_nf);
+  for(sv_index_type index = begin;;) {
+    f(index, index_f + index_nf);
+    if(++index == end) break;
+    index_nf = nonfermion.next(index_nf);
+    if(++n_nf == dim_nonfermion) {
+      n_nf = 0;
+      index_f = unranking.next(index_f);
+    }
+  }
+}
+
+} // namespace detail
+
+// Dimensions of all non-fermionic elementary spaces of 'hs' in the order of
+// their bit ranges. An element of the returned list can be reduced to
+// truncate the corresponding elementary space, e.g. to n_max + 1 for a boson.
+template <typename... IndexTypes>
+std::vector<sv_index_type>
+nonfermion_dims(hilbert_space<IndexTypes...> const& hs) {
+  std::vector<sv_index_type> dims;
+  hs.for_each_elementary_space(
+      [&](elementary_space<IndexTypes...> const& es, bit_range_t const&) {
+        if(es.algebra_id() != fermion) dims.push_back(es.dim());
+      });
+  return dims;
+}
+
+// Size of the fermionic sector with N particles, whose non-fermionic
+// elementary spaces have given dimensions
+template <typename... IndexTypes>
+inline sv_index_type
+n_fermion_sector_size(hilbert_space<IndexTypes...> const& hs,
+                      unsigned int N,
+                      std::vector<sv_index_type> const& nonfermion_dims) {
+  detail::n_fermion_sector_params_t params(hs, N);
+  detail::mixed_radix_encoding nonfermion(hs, nonfermion_dims);
+  return detail::binomial(params.M, N) * nonfermion.size();
+}
+
+// View of a state vector projected on an N-fermion sector. Unlike
+// n_fermion_sector_view, the non-fermionic part of a basis state index is
+// densely encoded with arbitrary dimensions of non-fermionic elementary
+// spaces (2S+1 for spins, n_max + 1 for truncated bosons). Contributions to
+// the basis states outside of the truncated elementary spaces are discarded
+// by update_add_element().
+template <typename StateVector,
+          bool Ref = true,
+          typename RankingAlgorithm = combination_ranking>
+struct n_fermion_sector_mixed_radix_view
+  : public detail::n_fermion_sector_params_t {
+
+  // The underlying state vector
+  typename std::conditional<Ref, StateVector&, StateVector>::type state_vector;
+
+  // Ranking algorithm
+  RankingAlgorithm ranking;
+
+  // Encoding of the non-fermionic part of an index
+  detail::mixed_radix_encoding nonfermion;
+
+  // Mask selecting the fermionic bits of an index
+  sv_index_type fermion_mask;
+
+  // Inverse of the ranking algorithm
+  detail::combination_unranking unranking;
+
+  using scalar_type = typename element_type<
+      typename std::remove_const<StateVector>::type>::type;
+
+  template <typename SV, typename... IndexTypes>
+  n_fermion_sector_mixed_radix_view(SV&& sv,
+                                    hilbert_space<IndexTypes...> const& hs,
+                                    unsigned int N)
+    : n_fermion_sector_mixed_radix_view(std::forward<SV>(sv),
+                                        hs,
+                                        N,
+                                        libcommute::nonfermion_dims(hs)) {}
+
+  // Construct a view with given dimensions of all non-fermionic elementary
+  // spaces listed in the order of their bit ranges
+  template <typename SV, typename... IndexTypes>
+  n_fermion_sector_mixed_radix_view(
+      SV&& sv,
+      hilbert_space<IndexTypes...> const& hs,
+      unsigned int N,
+      std::vector<sv_index_type> const& nonfermion_dims)
+    : detail::n_fermion_sector_params_t(hs, N),
+      state_vector(std::forward<SV>(sv)),
+      ranking(*this),
+      nonfermion(hs, nonfermion_dims),
+      fermion_mask(detail::pow2(M) - 1),
+      unranking(*this) {}
+
+  sv_index_type map_index(sv_index_type index) const {
+    return ranking(index & fermion_mask) * nonfermion.size() +
+           nonfermion(index);
+  }
+
+  // Translate a basis state index from the sector to the full Hilbert space
+  // (inverse of map_index())
+  sv_index_type inverse_map_index(sv_index_type index) const {
+    return unranking(index / nonfermion.size()) +
+           nonfermion.decode(index % nonfermion.size());
+  }
+
+  // Number of basis states in the sector
+  sv_index_type size() const {
+    return detail::binomial(M, N_counted) * nonfermion.size();
+  }
+};
+
+// Get element type of the StateVector object adapted by a given
+// n_fermion_sector_mixed_radix_view object.
+template <typename StateVector, bool Ref, typename RA>
+struct element_type<n_fermion_sector_mixed_radix_view<StateVector, Ref, RA>> {
+  using type =
+      typename n_fermion_sector_mixed_radix_view<StateVector>::scalar_type;
+};
+
+// Get state amplitude of the adapted StateVector object
+// at index view.map_index(n). Amplitudes of states lying outside of
+// the truncated non-fermionic elementary spaces are zero.
+template <typename StateVector, bool Ref, typename RA>
+inline auto get_element(
+    n_fermion_sector_mixed_radix_view<StateVector, Ref, RA> const& view,
+    sv_index_type n) ->
+    typename n_fermion_sector_mixed_radix_view<StateVector>::scalar_type {
+  using scalar_type =
+      typename n_fermion_sector_mixed_radix_view<StateVector>::scalar_type;
+  if(!view.nonfermion.contains(n))
+    return scalar_traits<scalar_type>::make_const(0);
+  return get_element(view.state_vector, view.map_index(n));
+}
+
+// Add a constant to a state amplitude stored in the adapted StateVector object
+// at index view.map_index(n). The update is discarded if 'n' lies outside of
+// the truncated non-fermionic elementary spaces.
+template <typename StateVector, bool Ref, typename RA, typename T>
+inline void update_add_element(
+    n_fermion_sector_mixed_radix_view<StateVector, Ref, RA>& view,
+    sv_index_type n,
+    T&& value) {
+  if(!view.nonfermion.contains(n)) return;
+  update_add_element(view.state_vector,
+                     view.map_index(n),
+                     std::forward<T>(value));
+}
+
+// update_add_element() is not defined for constant views
+template <typename StateVector, bool Ref, typename RA, typename T>
+inline void update_add_element(
+    n_fermion_sector_mixed_radix_view<StateVector const, Ref, RA>&,
+    sv_index_type,
+    T&&) {
+  static_assert(!std::is_same<StateVector, StateVector>::value,
+                "update_add_element() is not supported for constant views");
+}
+
+// zeros_like() is not defined for views
+template <typename StateVector, bool Ref, typename RA>
+inline StateVector
+zeros_like(n_fermion_sector_mixed_radix_view<StateVector, Ref, RA> const&) {
+  static_assert(!std::is_same<StateVector, StateVector>::value,
+                "zeros_like() is not supported for views");
+}
+
+// Set all amplitudes stored in the adapted StateVector object to zero
+template <typename StateVector, bool Ref, typename RA>
+inline void
+set_zeros(n_fermion_sector_mixed_radix_view<StateVector, Ref, RA>& view) {
+  set_zeros(view.state_vector);
+}
+
+// set_zeros() is not defined for constant views
+template <typename StateVector, bool Ref, typename RA>
+inline void
+set_zeros(n_fermion_sector_mixed_radix_view<StateVector const, Ref, RA>&) {
+  static_assert(!std::is_same<StateVector, StateVector>::value,
+                "set_zeros() is not supported for constant views");
+}
+
+// Apply functor `f` to all index/non-zero amplitude pairs in the adapted
+// StateVector object, whose sector indices lie in the range [begin, end).
+// Disjoint ranges can be processed concurrently.
+template <typename StateVector, bool Ref, typename RA, typename Functor>
+inline void
+foreach(n_fermion_sector_mixed_radix_view<StateVector, Ref, RA> const& view,
+        sv_index_type begin,
+        sv_index_type end,
+        Functor&& f) {
+  detail::for_each_sector_state(
+      view.unranking,
+      view.nonfermion,
+      begin,
+      end,
+      [&](sv_index_type sector_index, sv_index_type index) {
+        // Emulate decltype(auto)
+        decltype(get_element(view.state_vector, sector_index)) a =
+            get_element(view.state_vector, sector_index);
+
+        using T = typename n_fermion_sector_mixed_radix_view<StateVector,
+                                                             Ref,
+                                                             RA>::scalar_type;
+        if(!is_zero_amplitude<T>(a)) f(index, a);
+      });
+}
+
+// Apply functor `f` to all index/non-zero amplitude pairs
+// in the adapted StateVector object
+template <typename StateVector, bool Ref, typename RA, typename Functor>
+inline void
+foreach(n_fermion_sector_mixed_radix_view<StateVector, Ref, RA> const& view,
+        Functor&& f) {
+  foreach(view, 0, view.size(), std::forward<Functor>(f));
+}
+
+// Make a list of basis state indices spanning the N-fermion sector, whose
+// non-fermionic elementary spaces have given dimensions. The order of indices
+// is consistent with that used by n_fermion_sector_mixed_radix_view.
+template <typename... IndexTypes>
+inline std::vector<sv_index_type> n_fermion_sector_basis_states(
+    hilbert_space<IndexTypes...> const& hs,
+    unsigned int N,
+    std::vector<sv_index_type> const& nonfermion_dims) {
+  detail::n_fermion_sector_params_t params(hs, N);
+  detail::combination_unranking unranking(params);
+  detail::mixed_radix_encoding nonfermion(hs, nonfermion_dims);
+
+  sv_index_type size = detail::binomial(params.M, N) * nonfermion.size();
+
+  std::vector<sv_index_type> basis_states;
+  basis_states.reserve(size);
+  detail::for_each_sector_state(
+      unranking,
+      nonfermion,
+      0,
+      size,
+      [&](sv_index_type, sv_index_type index) {
+        basis_states.push_back(index);
+      });
+
+  return basis_states;
+}
+
+template <typename StateVector, typename RankingAlgorithm>
+using make_nfs_mixed_radix_view_ret_t =
+    n_fermion_sector_mixed_radix_view<
+        remove_cvref_t<StateVector>,
+        std::is_lvalue_reference<StateVector>::value,
+        RankingAlgorithm>;
+
+// Make a non-constant N-fermion sector view with a mixed-radix non-fermionic
+// part
+template <typename RankingAlgorithm = combination_ranking,
+          typename StateVector,
+          typename... IndexTypes>
+auto make_nfs_mixed_radix_view(
+    StateVector&& sv,
+    hilbert_space<IndexTypes...> const& hs,
+    unsigned int N,
+    std::vector<sv_index_type> const& nonfermion_dims)
+    -> make_nfs_mixed_radix_view_ret_t<StateVector, RankingAlgorithm> {
+  return make_nfs_mixed_radix_view_ret_t<StateVector, RankingAlgorithm>(
+      std::forward<StateVector>(sv),
+      hs,
+      N,
+      nonfermion_dims);
+}
+
+template <typename StateVector, typename RankingAlgorithm>
+using make_const_nfs_mixed_radix_view_ret_t =
+    n_fermion_sector_mixed_radix_view<
+        remove_cvref_t<StateVector> const,
+        std::is_lvalue_reference<StateVector>::value,
+        RankingAlgorithm>;
+
+// Make a constant N-fermion sector view with a mixed-radix non-fermionic part
+template <typename RankingAlgorithm = combination_ranking,
+          typename StateVector,
+          typename... IndexTypes>
+auto make_const_nfs_mixed_radix_view(
+    StateVector&& sv,
+    hilbert_space<IndexTypes...> const& hs,
+    unsigned int N,
+    std::vector<sv_index_type> const& nonfermion_dims)
+    -> make_const_nfs_mixed_radix_view_ret_t<StateVector, RankingAlgorithm> {
+  return make_const_nfs_mixed_radix_view_ret_t<StateVector, RankingAlgorithm>(
+      std::forward<StateVector>(sv),
+      hs,
+      N,
+      nonfermion_dims);
 }
 
 //
@@ -510,176 +1394,10 @@ unsigned int get_fermion_bit(
   return hs.bit_range(elementary_space_fermion<IndexTypes...>(indices)).first;
 }
 
-// This object uses a non-recursive procedure to generate all restricted N-part
-// compositions of multiple integers in parallel.
-// It does heavy lifting for foreach() and n_fermion_multisector_basis_states().
-struct for_each_composition_multi {
-
-  // Parameters of sectors
-  sector_params_vec_t const& sector_params;
-
-  // Index of the first sector with N_computed != 0
-  int s_min = -1;
-
-  // Index of the last sector with N_computed != 0
-  int s_max = -1;
-
-  // Restricted partitions of M_s
-  std::vector<std::vector<unsigned int>> mutable lambdas;
-
-  // Upper bounds for elements of 'lambdas'
-  std::vector<std::vector<unsigned int>> mutable lambdas_max;
-
-  inline explicit for_each_composition_multi(
-      sector_params_vec_t const& sector_params)
-    : sector_params(sector_params) {
-    for(int s = 0; s < static_cast<int>(sector_params.size()); ++s) {
-      auto const& p = sector_params[s];
-      lambdas.emplace_back(p.N_counted, 0);
-      lambdas.back().shrink_to_fit();
-      lambdas_max.emplace_back(p.N_counted, p.M - (p.N_counted - 1));
-      lambdas_max.back().shrink_to_fit();
-      if(p.N_counted != 0) {
-        if(s_min == -1) s_min = s;
-        s_max = s;
-      }
-    }
-    lambdas.shrink_to_fit();
-    lambdas_max.shrink_to_fit();
-  }
-
-  // Apply 'f' to each composition
-  template <typename F> void operator()(F&& f) const {
-    if(s_min == -1) { // All compositions are empty
-      f(lambdas);
-      return;
-    }
-
-    for(std::size_t s = 0; s < lambdas.size(); ++s) {
-      std::fill(lambdas[s].begin(), lambdas[s].end(), 0);
-      std::fill(lambdas_max[s].begin(),
-                lambdas_max[s].end(),
-                sector_params[s].M - (sector_params[s].N_counted - 1));
-    }
-
-    int s = s_min; // Index of current sector
-    int i = 0;     // Index within the current sector
-
-    while(s >= s_min) {
-      ++lambdas[s][i];
-      if(lambdas[s][i] > lambdas_max[s][i]) {
-        --i;
-        if(i < 0) {
-          do {
-            --s;
-          } while(sector_params[s].N_counted == 0);
-          i = static_cast<int>(sector_params[s].N_counted) - 1;
-        }
-        continue;
-      }
-
-      if(s == s_max &&
-         static_cast<unsigned int>(i) + 1 == sector_params[s].N_counted) {
-        f(lambdas);
-      } else {
-        ++i;
-        if(i == static_cast<int>(sector_params[s].N_counted)) {
-          do {
-            ++s;
-          } while(sector_params[s].N_counted == 0);
-          auto const& p = sector_params[s];
-          i = 0;
-          lambdas_max[s][i] = p.M - (p.N_counted - 1);
-        } else {
-          lambdas_max[s][i] = lambdas_max[s][i - 1] + 1 - lambdas[s][i - 1];
-        }
-        lambdas[s][i] = 0;
-      }
-    }
-  }
-};
-
 // 'non_multisector_bit' stands for a bit corresponding to a non-multisector
 // fermionic degree of freedom.
 static constexpr int non_multisector_bit = -1;
 
-// Combine a composition {\lambda_i} and a basis state index from
-// the non-multisector subspace into the index in the full Hilbert space
-struct compositions_to_full_hs_index {
-
-  // Parameters of sectors
-  sector_params_vec_t const& sector_params;
-
-  // Mapping from bit position to sector index
-  std::vector<int> const& bit_to_sector;
-
-  // XOR-mask used to flip bits in all count_occupied == false sectors
-  sv_index_type const index_mask;
-
-  // Index withing each sector
-  std::vector<sv_index_type> mutable sector_indices;
-
-  compositions_to_full_hs_index(sector_params_vec_t const& sector_params,
-                                std::vector<int> const& bit_to_sector)
-    : sector_params(sector_params),
-      bit_to_sector(bit_to_sector),
-      index_mask(init_index_mask(sector_params, bit_to_sector)),
-      sector_indices(sector_params.size()) {
-    sector_indices.shrink_to_fit();
-  }
-
-  inline sv_index_type
-  operator()(std::vector<std::vector<unsigned int>> const& lambdas,
-             sv_index_type index_nf) const {
-
-    for(unsigned int s = 0; s < lambdas.size(); ++s) {
-      if(lambdas[s].size() != 0) {
-        auto& index_f = sector_indices[s];
-        std::for_each(lambdas[s].rbegin(),
-                      lambdas[s].rend(),
-                      [&index_f](unsigned int lambda) {
-                        index_f <<= 1;
-                        index_f += 1;
-                        index_f <<= lambda - 1;
-                      });
-      } else
-        sector_indices[s] = 0;
-    }
-
-    sv_index_type index = 0;
-
-    // Consume bits from sector_indices and index_nf
-    for(unsigned int b = 0; b < bit_to_sector.size(); ++b) {
-      int s = bit_to_sector[b];
-      if(s != non_multisector_bit) {
-        auto& index_f = sector_indices[s];
-        index += (index_f & sv_index_type(1)) << b;
-        index_f >>= 1;
-      } else {
-        index += (index_nf & sv_index_type(1)) << b;
-        index_nf >>= 1;
-      }
-    }
-
-    index += index_nf << bit_to_sector.size();
-
-    return index ^ index_mask;
-  }
-
-private:
-  static sv_index_type init_index_mask(sector_params_vec_t const& sector_params,
-                                       std::vector<int> const& bit_to_sector) {
-    sv_index_type mask = 0;
-    for(unsigned int b = 0; b < bit_to_sector.size(); ++b) {
-      int s = bit_to_sector[b];
-      if(s != non_multisector_bit && (!sector_params[s].count_occupied)) {
-        mask += pow2(b);
-      }
-    }
-    return mask;
-  }
-};
-
 template <typename HSType>
 static std::vector<int>
 make_bit_to_sector(HSType const& hs,
@@ -748,49 +1466,35 @@ inline sv_index_type n_fermion_multisector_size(
   return multisector_size * detail::pow2(total_n_bits - M_total);
 }
 
-template <typename StateVector, bool Ref = true>
-struct n_fermion_multisector_view {
-
-  // The underlying state vector
-  typename std::conditional<Ref, StateVector&, StateVector>::type state_vector;
+// Immutable data describing an N-fermion multisector and used to translate
+// basis state indices into it. A single descriptor can be shared by multiple
+// n_fermion_multisector_view objects, including those used by concurrent
+// threads.
+template <typename RankingAlgorithm = combination_ranking>
+struct n_fermion_multisector_descriptor {
 
   // Parameters of sectors
   detail::sector_params_vec_t sector_params;
 
-  // Various per-sector data used by map_index()
-  struct sector_map_index_data_t {
-
-    // Sum of binomial coefficients
-    detail::binomial_sum_t binomial_sum;
-
-    // Current value of m
-    unsigned int m = 0;
-
-    // Current value of n
-    unsigned int n = 0;
+  // Mapping from bit position to sector index.
+  std::vector<int> bit_to_sector;
 
-    // Current value of \lambda
-    unsigned int lambda = 1;
+  // Extractors of the bits belonging to each sector
+  std::vector<detail::bit_gather> sector_gathers;
 
-    // Current index within this sector
-    sv_index_type index = 0;
+  // Ranking algorithms of sectors
+  std::vector<RankingAlgorithm> rankings;
 
-    explicit sector_map_index_data_t(
-        detail::n_fermion_sector_params_t const& params)
-      : binomial_sum(params.M, params.N_counted) {}
+  // Depositors of the bits belonging to each sector
+  std::vector<detail::bit_scatter> sector_scatters;
 
-    // Reset all current values
-    void reset(detail::n_fermion_sector_params_t const& params) {
-      m = params.M;
-      n = params.N_counted;
-      index = 0;
-      lambda = 1;
-    }
-  };
-  std::vector<sector_map_index_data_t> mutable sector_map_index_data;
+  // Inverses of the ranking algorithms of sectors
+  std::vector<detail::combination_unranking> unrankings;
 
-  // Mapping from bit position to sector index.
-  std::vector<int> bit_to_sector;
+  // Extractor and depositor of the fermionic bits not belonging to
+  // the multisector
+  detail::bit_gather nonmultisector_gather;
+  detail::bit_scatter nonmultisector_scatter;
 
   // Strides used to combine sector indices into a multisector index
   std::vector<sv_index_type> sector_strides;
@@ -798,76 +1502,145 @@ struct n_fermion_multisector_view {
   // The number of bits not belonging to the multisector
   unsigned int M_nonmultisector;
 
-  // Although the following two objects are not used by this class' methods,
-  // storing them here allows to eliminate memory allocations in foreach().
-  detail::for_each_composition_multi for_each_comp;
-  detail::compositions_to_full_hs_index comp_to_index;
-
-  using scalar_type = typename element_type<
-      typename std::remove_const<StateVector>::type>::type;
-
-  template <typename SV, typename HSType>
-  n_fermion_multisector_view(
-      SV&& sv,
+  template <typename HSType>
+  n_fermion_multisector_descriptor(
       HSType const& hs,
       std::vector<sector_descriptor<HSType>> const& sectors)
-    : state_vector(std::forward<SV>(sv)),
-      sector_params(detail::make_sector_params(hs, sectors)),
+    : sector_params(detail::make_sector_params(hs, sectors)),
       bit_to_sector(detail::make_bit_to_sector(hs, sectors)),
+      nonmultisector_gather(
+          init_sector_mask(bit_to_sector, detail::non_multisector_bit)),
+      nonmultisector_scatter(nonmultisector_gather.mask()),
       sector_strides(init_sector_strides(sector_params)),
-      M_nonmultisector(detail::compute_m_nonmultisector(hs, sector_params)),
-      for_each_comp(sector_params),
-      comp_to_index(sector_params, bit_to_sector) {
-    sector_map_index_data.reserve(sector_params.size());
-    for(auto const& p : sector_params) {
-      // cppcheck-suppress useStlAlgorithm
-      sector_map_index_data.emplace_back(p);
+      M_nonmultisector(detail::compute_m_nonmultisector(hs, sector_params)) {
+    sector_gathers.reserve(sector_params.size());
+    rankings.reserve(sector_params.size());
+    sector_scatters.reserve(sector_params.size());
+    unrankings.reserve(sector_params.size());
+    for(std::size_t s = 0; s < sector_params.size(); ++s) {
+      auto mask = init_sector_mask(bit_to_sector, int(s));
+      sector_gathers.emplace_back(mask);
+      rankings.emplace_back(sector_params[s]);
+      sector_scatters.emplace_back(mask);
+      unrankings.emplace_back(sector_params[s]);
     }
   }
 
+  // Translate a basis state index from the full Hilbert space to the
+  // multisector
   sv_index_type map_index(sv_index_type index) const {
 
-    // Translate the fermionic part of 'index' into a list of sector indices
-    for(std::size_t s = 0; s < sector_params.size(); ++s)
-      sector_map_index_data[s].reset(sector_params[s]);
-
-    sv_index_type index_nonmultisector = 0;
-    unsigned int b_nonmultisector = 0;
-
-    for(int s : bit_to_sector) {
-      if(s !=
-         detail::non_multisector_bit) { // This bit belongs to the multisector
-        auto& d = sector_map_index_data[s];
-        if((index & sv_index_type(1)) == sector_params[s].count_occupied) {
-          d.index += d.binomial_sum(d.n, d.m, d.lambda);
-          d.m -= d.lambda;
-          --d.n;
-          d.lambda = 1;
-        } else {
-          ++d.lambda;
-        }
-      } else { // a non-multisector bit
-        index_nonmultisector += (index & sv_index_type(1)) << b_nonmultisector;
-        ++b_nonmultisector;
-      }
-      index >>= 1;
+    // Extract bits of each sector and translate them into a sector index
+    sv_index_type index_multisector = 0;
+    for(std::size_t s = 0; s < rankings.size(); ++s) {
+      index_multisector +=
+          rankings[s](sector_gathers[s](index)) * sector_strides[s];
     }
 
-    index_nonmultisector += index << b_nonmultisector;
+    sv_index_type index_nonmultisector =
+        nonmultisector_gather(index) +
+        ((index >> bit_to_sector.size()) << nonmultisector_gather.size());
 
-    auto index_multisector = std::inner_product(
-        sector_map_index_data.begin(),
-        sector_map_index_data.end(),
-        sector_strides.begin(),
-        0,
-        std::plus<sv_index_type>(),
-        [](sector_map_index_data_t const& data, sv_index_type stride) {
-          return data.index * stride;
-        });
     return (index_multisector << M_nonmultisector) + index_nonmultisector;
   }
 
+  // Translate a basis state index from the multisector to the full Hilbert
+  // space (inverse of map_index())
+  sv_index_type inverse_map_index(sv_index_type index) const {
+    sv_index_type index_nonmultisector =
+        index & (detail::pow2(M_nonmultisector) - 1);
+    sv_index_type index_multisector = index >> M_nonmultisector;
+
+    sv_index_type result = nonmultisector_index(index_nonmultisector);
+    for(std::size_t s = 0; s < unrankings.size(); ++s) {
+      result += sector_scatters[s](unrankings[s](index_multisector /
+                                                 sector_strides[s]));
+      index_multisector %= sector_strides[s];
+    }
+    return result;
+  }
+
+  // Contribution of a non-multisector index to the full Hilbert space index
+  sv_index_type nonmultisector_index(sv_index_type index_nms) const {
+    return nonmultisector_scatter(index_nms) +
+           ((index_nms >> nonmultisector_gather.size())
+            << bit_to_sector.size());
+  }
+
+  // Multisector size
+  sv_index_type size() const {
+    sv_index_type size_multisector = 1;
+    if(!sector_params.empty()) {
+      auto const& p = sector_params[0];
+      size_multisector = sector_strides[0] * detail::binomial(p.M, p.N_counted);
+    }
+    return size_multisector << M_nonmultisector;
+  }
+
+  // Apply 'f' to pairs (multisector index, full Hilbert space index) for all
+  // multisector indices in the range [begin, end). The fermionic parts of
+  // basis states are generated incrementally, sector by sector.
+  template <typename F>
+  void for_each_state(sv_index_type begin, sv_index_type end, F&& f) const {
+    if(begin >= end) return;
+
+    std::size_t const n_sectors = sector_params.size();
+
+    auto dim_nonmultisector = detail::pow2(M_nonmultisector);
+    sv_index_type index_nms = begin & (dim_nonmultisector - 1);
+
+    // Sizes of sectors and fermionic parts of their first basis states
+    std::vector<sv_index_type> sizes(n_sectors);
+    std::vector<sv_index_type> first_indices(n_sectors);
+
+    // Current ranks and fermionic parts of the basis states within each
+    // sector
+    std::vector<sv_index_type> ranks(n_sectors);
+    std::vector<sv_index_type> sector_indices(n_sectors);
+    sv_index_type index_multisector = begin >> M_nonmultisector;
+    sv_index_type index_f = 0;
+    for(std::size_t s = 0; s < n_sectors; ++s) {
+      auto const& p = sector_params[s];
+      sizes[s] = detail::binomial(p.M, p.N_counted);
+      first_indices[s] = unrankings[s](0);
+      ranks[s] = index_multisector / sector_strides[s];
+      index_multisector %= sector_strides[s];
+      sector_indices[s] = unrankings[s](ranks[s]);
+      index_f += sector_scatters[s](sector_indices[s]);
+    }
+
+    for(sv_index_type index = begin;;) {
+      f(index, index_f + nonmultisector_index(index_nms));
+      if(++index == end) break;
+      if(++index_nms == dim_nonmultisector) {
+        index_nms = 0;
+        // Advance to the next multisector basis state: The last sector
+        // changes fastest
+        for(std::size_t s = n_sectors; s-- != 0;) {
+          index_f -= sector_scatters[s](sector_indices[s]);
+          bool carry = ++ranks[s] == sizes[s];
+          if(carry) {
+            ranks[s] = 0;
+            sector_indices[s] = first_indices[s];
+          } else
+            sector_indices[s] = unrankings[s].next(sector_indices[s]);
+          index_f += sector_scatters[s](sector_indices[s]);
+          if(!carry) break;
+        }
+      }
+    }
+  }
+
 private:
+  static sv_index_type init_sector_mask(std::vector<int> const& bit_to_sector,
+                                        int sector) {
+    sv_index_type mask = 0;
+    for(unsigned int b = 0; b < bit_to_sector.size(); ++b) {
+      if(bit_to_sector[b] == sector) mask += detail::pow2(b);
+    }
+    return mask;
+  }
+
   static std::vector<sv_index_type>
   init_sector_strides(detail::sector_params_vec_t const& sector_params) {
     std::vector<sv_index_type> strides(sector_params.size());
@@ -884,18 +1657,82 @@ private:
   }
 };
 
+// Make a shared N-fermion multisector descriptor
+template <typename RankingAlgorithm = combination_ranking, typename HSType>
+std::shared_ptr<n_fermion_multisector_descriptor<RankingAlgorithm> const>
+make_nfms_descriptor(HSType const& hs,
+                     std::vector<sector_descriptor<HSType>> const& sectors) {
+  return std::make_shared<
+      n_fermion_multisector_descriptor<RankingAlgorithm> const>(hs, sectors);
+}
+
+template <typename StateVector,
+          bool Ref = true,
+          typename RankingAlgorithm = combination_ranking>
+struct n_fermion_multisector_view {
+
+  using descriptor_type = n_fermion_multisector_descriptor<RankingAlgorithm>;
+
+  // The underlying state vector
+  typename std::conditional<Ref, StateVector&, StateVector>::type state_vector;
+
+  // Shared multisector descriptor
+  std::shared_ptr<descriptor_type const> descriptor;
+
+  // References to the data stored in the descriptor
+  detail::sector_params_vec_t const& sector_params;
+  std::vector<int> const& bit_to_sector;
+  std::vector<sv_index_type> const& sector_strides;
+  unsigned int const& M_nonmultisector;
+
+  using scalar_type = typename element_type<
+      typename std::remove_const<StateVector>::type>::type;
+
+  template <typename SV, typename HSType>
+  n_fermion_multisector_view(
+      SV&& sv,
+      HSType const& hs,
+      std::vector<sector_descriptor<HSType>> const& sectors)
+    : n_fermion_multisector_view(
+          std::forward<SV>(sv),
+          make_nfms_descriptor<RankingAlgorithm>(hs, sectors)) {}
+
+  // Construct a view using a shared multisector descriptor
+  template <typename SV>
+  n_fermion_multisector_view(SV&& sv,
+                             std::shared_ptr<descriptor_type const> desc)
+    : state_vector(std::forward<SV>(sv)),
+      descriptor(std::move(desc)),
+      sector_params(descriptor->sector_params),
+      bit_to_sector(descriptor->bit_to_sector),
+      sector_strides(descriptor->sector_strides),
+      M_nonmultisector(descriptor->M_nonmultisector) {}
+
+  // This method does not modify the view and can be called concurrently
+  // from multiple threads.
+  sv_index_type map_index(sv_index_type index) const {
+    return descriptor->map_index(index);
+  }
+
+  // Translate a basis state index from the multisector to the full Hilbert
+  // space (inverse of map_index())
+  sv_index_type inverse_map_index(sv_index_type index) const {
+    return descriptor->inverse_map_index(index);
+  }
+};
+
 // Get element type of the StateVector object adapted by a given
 // n_fermion_multisector_view object.
-template <typename StateVector, bool Ref>
-struct element_type<n_fermion_multisector_view<StateVector, Ref>> {
+template <typename StateVector, bool Ref, typename RA>
+struct element_type<n_fermion_multisector_view<StateVector, Ref, RA>> {
   using type = typename n_fermion_multisector_view<StateVector>::scalar_type;
 };
 
 // Get state amplitude of the adapted StateVector object
 // at index view.map_index(n)
-template <typename StateVector, bool Ref>
+template <typename StateVector, bool Ref, typename RA>
 inline auto
-get_element(n_fermion_multisector_view<StateVector, Ref> const& view,
+get_element(n_fermion_multisector_view<StateVector, Ref, RA> const& view,
             sv_index_type n) ->
     typename n_fermion_sector_view<StateVector>::scalar_type {
   return get_element(view.state_vector, view.map_index(n));
@@ -903,9 +1740,9 @@ get_element(n_fermion_multisector_view<StateVector, Ref> const& view,
 
 // Add a constant to a state amplitude stored in the adapted StateVector object
 // at index view.map_index(n)
-template <typename StateVector, bool Ref, typename T>
+template <typename StateVector, bool Ref, typename RA, typename T>
 inline void
-update_add_element(n_fermion_multisector_view<StateVector, Ref>& view,
+update_add_element(n_fermion_multisector_view<StateVector, Ref, RA>& view,
                    sv_index_type n,
                    T&& value) {
   update_add_element(view.state_vector,
@@ -914,9 +1751,9 @@ update_add_element(n_fermion_multisector_view<StateVector, Ref>& view,
 }
 
 // update_add_element() is not defined for constant views
-template <typename StateVector, bool Ref, typename T>
+template <typename StateVector, bool Ref, typename RA, typename T>
 inline void
-update_add_element(n_fermion_multisector_view<StateVector const, Ref>&,
+update_add_element(n_fermion_multisector_view<StateVector const, Ref, RA>&,
                    sv_index_type,
                    T&&) {
   static_assert(!std::is_same<StateVector, StateVector>::value,
@@ -924,54 +1761,58 @@ update_add_element(n_fermion_multisector_view<StateVector const, Ref>&,
 }
 
 // zeros_like() is not defined for views
-template <typename StateVector, bool Ref>
+template <typename StateVector, bool Ref, typename RA>
 inline StateVector
-zeros_like(n_fermion_multisector_view<StateVector, Ref> const&) {
+zeros_like(n_fermion_multisector_view<StateVector, Ref, RA> const&) {
   static_assert(!std::is_same<StateVector, StateVector>::value,
                 "zeros_like() is not supported for views");
 }
 
 // Set all amplitudes stored in the adapted StateVector object to zero
-template <typename StateVector, bool Ref>
-inline void set_zeros(n_fermion_multisector_view<StateVector, Ref>& view) {
+template <typename StateVector, bool Ref, typename RA>
+inline void set_zeros(n_fermion_multisector_view<StateVector, Ref, RA>& view) {
   set_zeros(view.state_vector);
 }
 
 // set_zeros() is not defined for constant views
-template <typename StateVector, bool Ref>
-inline void set_zeros(n_fermion_multisector_view<StateVector const, Ref>&) {
+template <typename StateVector, bool Ref, typename RA>
+inline void set_zeros(n_fermion_multisector_view<StateVector const, Ref, RA>&) {
   static_assert(!std::is_same<StateVector, StateVector>::value,
                 "set_zeros() is not supported for constant views");
 }
 
-// Apply functor `f` to all index/non-zero amplitude pairs
-// in the adapted StateVector object
-template <typename StateVector, bool Ref, typename Functor>
-inline void foreach(n_fermion_multisector_view<StateVector, Ref> const& view,
-                    Functor&& f) {
+// Apply functor `f` to all index/non-zero amplitude pairs in the adapted
+// StateVector object, whose multisector indices lie in the range [begin, end).
+// Disjoint ranges can be processed concurrently.
+template <typename StateVector, bool Ref, typename RA, typename Functor>
+inline void
+foreach(n_fermion_multisector_view<StateVector, Ref, RA> const& view,
+        sv_index_type begin,
+        sv_index_type end,
+        Functor&& f) {
   if(view.sector_params.size() == 0 && view.M_nonmultisector == 0) return;
 
-  auto dim_nonmultisector = detail::pow2(view.M_nonmultisector);
-  sv_index_type multisector_index = 0;
-  view.for_each_comp([&](std::vector<std::vector<unsigned int>> const&
-                             lambdas) {
-    for(sv_index_type index_nms = 0; index_nms < dim_nonmultisector;
-        ++index_nms) {
-
-      // Emulate decltype(auto)
-      decltype(get_element(view.state_vector, multisector_index)) a =
-          get_element(view.state_vector, multisector_index);
-
-      ++multisector_index;
-
-      using T =
-          typename n_fermion_multisector_view<StateVector, Ref>::scalar_type;
-      if(scalar_traits<T>::is_zero(a))
-        continue;
-      else
-        f(view.comp_to_index(lambdas, index_nms), a);
-    }
-  });
+  view.descriptor->for_each_state(
+      begin,
+      end,
+      [&](sv_index_type multisector_index, sv_index_type index) {
+        // Emulate decltype(auto)
+        decltype(get_element(view.state_vector, multisector_index)) a =
+            get_element(view.state_vector, multisector_index);
+
+        using T = typename n_fermion_multisector_view<StateVector, Ref, RA>::
+            scalar_type;
+        if(!is_zero_amplitude<T>(a)) f(index, a);
+      });
+}
+
+// Apply functor `f` to all index/non-zero amplitude pairs
+// in the adapted StateVector object
+template <typename StateVector, bool Ref, typename RA, typename Functor>
+inline void
+foreach(n_fermion_multisector_view<StateVector, Ref, RA> const& view,
+        Functor&& f) {
+  foreach(view, 0, view.descriptor->size(), std::forward<Functor>(f));
 }
 
 // Make a list of basis state indices spanning the N-fermion multisector
@@ -981,67 +1822,83 @@ template <typename HSType>
 inline std::vector<sv_index_type> n_fermion_multisector_basis_states(
     HSType const& hs,
     std::vector<sector_descriptor<HSType>> const& sectors) {
-  auto sector_params = detail::make_sector_params(hs, sectors);
-  if(hs.total_n_bits() == 0 && sector_params.empty()) return {};
-
-  detail::for_each_composition_multi for_each_comp(sector_params);
-  auto bit_to_sector = detail::make_bit_to_sector(hs, sectors);
-  detail::compositions_to_full_hs_index comp_to_index(sector_params,
-                                                      bit_to_sector);
-
-  sv_index_type dim_multisector = std::accumulate(
-      sector_params.begin(),
-      sector_params.end(),
-      1,
-      [](sv_index_type dim, detail::n_fermion_sector_params_t const& p) {
-        return dim * detail::binomial(p.M, p.N_counted);
-      });
+  n_fermion_multisector_descriptor<> descriptor(hs, sectors);
+  if(hs.total_n_bits() == 0 && descriptor.sector_params.empty()) return {};
 
-  unsigned int M_nonmultisector = compute_m_nonmultisector(hs, sector_params);
-  sv_index_type dim_nonmultisector = detail::pow2(M_nonmultisector);
+  sv_index_type size = descriptor.size();
 
   std::vector<sv_index_type> basis_states;
-  basis_states.reserve(dim_multisector * dim_nonmultisector);
-  for_each_comp([&](std::vector<std::vector<unsigned int>> const& lambdas) {
-    for(sv_index_type index_nms = 0; index_nms < dim_nonmultisector;
-        ++index_nms) {
-      basis_states.push_back(comp_to_index(lambdas, index_nms));
-    }
+  basis_states.reserve(size);
+  descriptor.for_each_state(0, size, [&](sv_index_type, sv_index_type index) {
+    basis_states.push_back(index);
   });
 
   return basis_states;
 }
 
-template <typename StateVector>
+template <typename StateVector, typename RankingAlgorithm>
 using make_nfms_view_ret_t =
     n_fermion_multisector_view<remove_cvref_t<StateVector>,
-                               std::is_lvalue_reference<StateVector>::value>;
+                               std::is_lvalue_reference<StateVector>::value,
+                               RankingAlgorithm>;
 
 // Make a non-constant N-fermion sector view
-template <typename StateVector, typename HSType>
+template <typename RankingAlgorithm = combination_ranking,
+          typename StateVector,
+          typename HSType>
 auto make_nfms_view(StateVector&& sv,
                     HSType const& hs,
                     std::vector<sector_descriptor<HSType>> const& sectors)
-    -> make_nfms_view_ret_t<StateVector> {
-  return make_nfms_view_ret_t<StateVector>(std::forward<StateVector>(sv),
-                                           hs,
-                                           sectors);
+    -> make_nfms_view_ret_t<StateVector, RankingAlgorithm> {
+  return make_nfms_view_ret_t<StateVector, RankingAlgorithm>(
+      std::forward<StateVector>(sv),
+      hs,
+      sectors);
+}
+
+// Make a non-constant N-fermion multisector view using a shared multisector
+// descriptor
+template <typename StateVector, typename RankingAlgorithm>
+auto make_nfms_view(
+    StateVector&& sv,
+    std::shared_ptr<n_fermion_multisector_descriptor<RankingAlgorithm> const>
+        descriptor) -> make_nfms_view_ret_t<StateVector, RankingAlgorithm> {
+  return make_nfms_view_ret_t<StateVector, RankingAlgorithm>(
+      std::forward<StateVector>(sv),
+      std::move(descriptor));
 }
 
-template <typename StateVector>
+template <typename StateVector, typename RankingAlgorithm>
 using make_const_nfms_view_ret_t =
     n_fermion_multisector_view<remove_cvref_t<StateVector> const,
-                               std::is_lvalue_reference<StateVector>::value>;
+                               std::is_lvalue_reference<StateVector>::value,
+                               RankingAlgorithm>;
 
 // Make a constant N-fermion sector view
-template <typename StateVector, typename HSType>
+template <typename RankingAlgorithm = combination_ranking,
+          typename StateVector,
+          typename HSType>
 auto make_const_nfms_view(StateVector&& sv,
                           HSType const& hs,
                           std::vector<sector_descriptor<HSType>> const& sectors)
-    -> make_const_nfms_view_ret_t<StateVector> {
-  return make_const_nfms_view_ret_t<StateVector>(std::forward<StateVector>(sv),
-                                                 hs,
-                                                 sectors);
+    -> make_const_nfms_view_ret_t<StateVector, RankingAlgorithm> {
+  return make_const_nfms_view_ret_t<StateVector, RankingAlgorithm>(
+      std::forward<StateVector>(sv),
+      hs,
+      sectors);
+}
+
+// Make a constant N-fermion multisector view using a shared multisector
+// descriptor
+template <typename StateVector, typename RankingAlgorithm>
+auto make_const_nfms_view(
+    StateVector&& sv,
+    std::shared_ptr<n_fermion_multisector_descriptor<RankingAlgorithm> const>
+        descriptor)
+    -> make_const_nfms_view_ret_t<StateVector, RankingAlgorithm> {
+  return make_const_nfms_view_ret_t<StateVector, RankingAlgorithm>(
+      std::forward<StateVector>(sv),
+      std::move(descriptor));
 }
 
 } // namespace libcommute
@@ -0,0 +1,467 @@
+/*******************************************************************************
+ *
+ * This file is part of libcommute, a quantum operator algebra DSL and
+ * exact diagonalization toolkit for C++11/14/17.
+ *
+ * Copyright (C) 2016-2021 Igor Krivenko <igor.s.krivenko@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ ******************************************************************************/
+#ifndef LIBCOMMUTE_LOPERATOR_N_QUANTA_SECTOR_VIEW_HPP_
+#define LIBCOMMUTE_LOPERATOR_N_QUANTA_SECTOR_VIEW_HPP_
+
+#include "../algebra_ids.hpp"
+#include "../utility.hpp"
+
+#include "elementary_space.hpp"
+#include "hilbert_space.hpp"
+#include "n_fermion_sector_view.hpp"
+#include "state_vector.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <set>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace libcommute {
+
+namespace detail {
+
+// Mask with the n lowest bits set
+inline sv_index_type low_bits_mask(unsigned int n) {
+  return n < std::numeric_limits<sv_index_type>::digits ? pow2(n) - 1
+                                                         : ~sv_index_type(0);
+}
+
+// Sector of a Hilbert space with a fixed total number of quanta
+//
+// $$
+//   N = \sum_{k=0}^{K-1} n_k,
+// $$
+//
+// where n_k is the index of the basis state of the k-th selected elementary
+// space (occupation number of a bosonic or fermionic mode, m + S for
+// a spin-S mode). The selected elementary spaces are ordered by their bit
+// ranges.
+//
+// Basis states are ordered lexicographically in (n_{K-1}, ..., n_0), so that
+// the serial number of a basis state grows with its index in the full Hilbert
+// space. The serial number is
+//
+// $$
+//   \sum_{k=0}^{K-1} \sum_{n'=0}^{n_k - 1} C_k(N - \sum_{j>k} n_j - n'),
+// $$
+//
+// where C_k(r) is the number of ways to distribute r quanta over elementary
+// spaces 0, ..., k-1. For each elementary space, each number of quanta left
+// for it and the lower spaces, and each value of n_k, the inner sum is
+// pre-computed, so that ranking requires one table lookup per elementary
+// space.
+class n_quanta_sector {
+
+  // Selected elementary space
+  struct mode_t {
+    // Bits of the elementary space are selected as (index >> shift) & mask
+    unsigned int shift;
+    sv_index_type mask;
+    // Dimension of the elementary space
+    sv_index_type dim;
+    // Number of stored partial sums per number of remaining quanta,
+    // min(dim, N + 1)
+    sv_index_type row_size;
+    // Offset of the partial sums for this elementary space in table_
+    std::size_t offset;
+  };
+
+  // Total number of quanta
+  unsigned int N_;
+
+  // Selected elementary spaces
+  std::vector<mode_t> modes_;
+
+  // Mask selecting the bits of all selected elementary spaces
+  sv_index_type mask_ = 0;
+
+  // Partial sums table_[offset + rem * row_size + n] for mode_t 'offset' and
+  // 'row_size', with 'rem' quanta left for the elementary space and the lower
+  // spaces
+  std::vector<sv_index_type> table_;
+
+  // Number of basis states in the sector
+  sv_index_type size_ = 0;
+
+  // Row of partial sums for a given mode and a number of remaining quanta
+  sv_index_type const* row(mode_t const& mode, unsigned int rem) const {
+    return table_.data() + mode.offset + rem * mode.row_size;
+  }
+
+public:
+  template <typename... IndexTypes>
+  n_quanta_sector(hilbert_space<IndexTypes...> const& hs,
+                  unsigned int N,
+                  std::set<int> const& algebra_ids)
+    : N_(N) {
+    hs.for_each_elementary_space(
+        [&](elementary_space<IndexTypes...> const& es,
+            bit_range_t const& range) {
+          if(algebra_ids.count(es.algebra_id()) == 0) return;
+          unsigned int n_bits = range.second - range.first + 1;
+          sv_index_type dim = es.dim();
+          mode_t mode{static_cast<unsigned int>(range.first),
+                      low_bits_mask(n_bits),
+                      dim,
+                      std::min(dim, sv_index_type(N) + 1),
+                      0};
+          mask_ |= mode.mask << mode.shift;
+          modes_.push_back(mode);
+        });
+
+    // count[r] = C_k(r)
+    std::vector<sv_index_type> count(N + 1, 0);
+    count[0] = 1;
+    std::vector<sv_index_type> new_count(N + 1);
+    for(auto& mode : modes_) {
+      mode.offset = table_.size();
+      table_.resize(mode.offset + (N + 1) * mode.row_size);
+      for(unsigned int rem = 0; rem <= N; ++rem) {
+        sv_index_type* r = table_.data() + mode.offset + rem * mode.row_size;
+        sv_index_type sum = 0;
+        for(sv_index_type n = 0; n < mode.row_size; ++n) {
+          r[n] = sum;
+          if(n <= rem) sum += count[rem - n];
+        }
+        new_count[rem] = sum;
+      }
+      std::swap(count, new_count);
+    }
+    size_ = count[N];
+  }
+
+  // Total number of quanta
+  unsigned int N() const { return N_; }
+
+  // Mask selecting the bits of all selected elementary spaces
+  sv_index_type mask() const { return mask_; }
+
+  // Number of basis states in the sector
+  sv_index_type size() const { return size_; }
+
+  // Serial number of a basis state within the sector. Only the bits selected
+  // by mask() are taken into account.
+  sv_index_type rank(sv_index_type index) const {
+    sv_index_type result = 0;
+    unsigned int rem = N_;
+    for(auto mode = modes_.rbegin(); mode != modes_.rend(); ++mode) {
+      sv_index_type n = (index >> mode->shift) & mode->mask;
+      result += row(*mode, rem)[std::min(n, mode->row_size - 1)];
+      rem -= std::min(sv_index_type(rem), n);
+    }
+    return result;
+  }
+
+  // Index of a basis state with a given serial number within the sector
+  // (inverse of rank())
+  sv_index_type unrank(sv_index_type rank) const {
+    assert(rank < size_);
+    sv_index_type index = 0;
+    unsigned int rem = N_;
+    for(auto mode = modes_.rbegin(); mode != modes_.rend(); ++mode) {
+      sv_index_type const* r = row(*mode, rem);
+      sv_index_type n_max = std::min(mode->dim - 1, sv_index_type(rem));
+      sv_index_type n = std::upper_bound(r, r + n_max + 1, rank) - r - 1;
+      rank -= r[n];
+      rem -= n;
+      index += n << mode->shift;
+    }
+    return index;
+  }
+
+  // Index of the basis state following a given basis state 'index' within
+  // the sector. 'index' must not be the last basis state of the sector.
+  sv_index_type next(sv_index_type index) const {
+    // Find the lowest elementary space k that can accept one more quantum
+    // taken from the spaces below it
+    unsigned int lower = 0;
+    std::size_t k = 0;
+    for(;; ++k) {
+      assert(k < modes_.size());
+      auto const& mode = modes_[k];
+      sv_index_type n = (index >> mode.shift) & mode.mask;
+      if(lower > 0 && n + 1 < mode.dim) break;
+      lower += n;
+      index -= n << mode.shift;
+    }
+    index += sv_index_type(1) << modes_[k].shift;
+    // Distribute the remaining quanta over the lower spaces starting from
+    // the lowest one
+    --lower;
+    for(std::size_t j = 0; lower > 0; ++j) {
+      auto const& mode = modes_[j];
+      sv_index_type n = std::min(mode.dim - 1, sv_index_type(lower));
+      index += n << mode.shift;
+      lower -= n;
+    }
+    return index;
+  }
+};
+
+// Apply 'f' to pairs (sector index, full Hilbert space index) for all sector
+// indices in the range [begin, end).
+template <typename F>
+void for_each_n_quanta_sector_state(n_quanta_sector const& sector,
+                                    bit_scatter const& nonsector_scatter,
+                                    unsigned int M_nonsector,
+                                    sv_index_type begin,
+                                    sv_index_type end,
+                                    F&& f) {
+  if(begin >= end) return;
+  auto dim_nonsector = pow2(M_nonsector);
+  sv_index_type index_s = sector.unrank(begin >> M_nonsector);
+  sv_index_type index_ns = begin & (dim_nonsector - 1);
+  for(sv_index_type index = begin;;) {
+    f(index, index_s + nonsector_scatter(index_ns));
+    if(++index == end) break;
+    if(++index_ns == dim_nonsector) {
+      index_ns = 0;
+      index_s = sector.next(index_s);
+    }
+  }
+}
+
+} // namespace detail
+
+//
+// Sector with a fixed total number of quanta
+//
+
+// Algebra IDs of elementary spaces contributing to the total number of quanta
+// by default
+inline std::set<int> default_n_quanta_algebra_ids() { return {boson, spin}; }
+
+// Size of the sector with N quanta distributed over elementary spaces with
+// given algebra IDs
+template <typename... IndexTypes>
+inline sv_index_type
+n_quanta_sector_size(hilbert_space<IndexTypes...> const& hs,
+                     unsigned int N,
+                     std::set<int> const& algebra_ids =
+                         default_n_quanta_algebra_ids()) {
+  detail::n_quanta_sector sector(hs, N, algebra_ids);
+  return sector.size()
+         << (hs.total_n_bits() - detail::popcount(sector.mask()));
+}
+
+template <typename StateVector, bool Ref = true> struct n_quanta_sector_view {
+
+  // The underlying state vector
+  typename std::conditional<Ref, StateVector&, StateVector>::type state_vector;
+
+  // Ranking tables of the sector
+  detail::n_quanta_sector sector;
+
+  // Gather/scatter the bits of elementary spaces not belonging to the sector
+  detail::bit_gather nonsector_gather;
+  detail::bit_scatter nonsector_scatter;
+
+  // Number of bits corresponding to elementary spaces not belonging to
+  // the sector
+  unsigned int M_nonsector;
+
+  using scalar_type = typename element_type<
+      typename std::remove_const<StateVector>::type>::type;
+
+  template <typename SV, typename... IndexTypes>
+  n_quanta_sector_view(SV&& sv,
+                       hilbert_space<IndexTypes...> const& hs,
+                       unsigned int N,
+                       std::set<int> const& algebra_ids =
+                           default_n_quanta_algebra_ids())
+    : state_vector(std::forward<SV>(sv)),
+      sector(hs, N, algebra_ids),
+      nonsector_gather(~sector.mask() &
+                       detail::low_bits_mask(hs.total_n_bits())),
+      nonsector_scatter(nonsector_gather.mask()),
+      M_nonsector(nonsector_gather.size()) {}
+
+  sv_index_type map_index(sv_index_type index) const {
+    return (sector.rank(index) << M_nonsector) + nonsector_gather(index);
+  }
+
+  // Translate a basis state index from the sector to the full Hilbert space
+  // (inverse of map_index())
+  sv_index_type inverse_map_index(sv_index_type index) const {
+    return sector.unrank(index >> M_nonsector) +
+           nonsector_scatter(index & (detail::pow2(M_nonsector) - 1));
+  }
+
+  // Number of basis states in the sector
+  sv_index_type size() const { return sector.size() << M_nonsector; }
+};
+
+// Get element type of the StateVector object adapted by a given
+// n_quanta_sector_view object.
+template <typename StateVector, bool Ref>
+struct element_type<n_quanta_sector_view<StateVector, Ref>> {
+  using type = typename n_quanta_sector_view<StateVector>::scalar_type;
+};
+
+// Get state amplitude of the adapted StateVector object
+// at index view.map_index(n)
+template <typename StateVector, bool Ref>
+inline auto get_element(n_quanta_sector_view<StateVector, Ref> const& view,
+                        sv_index_type n) ->
+    typename n_quanta_sector_view<StateVector>::scalar_type {
+  return get_element(view.state_vector, view.map_index(n));
+}
+
+// Add a constant to a state amplitude stored in the adapted StateVector object
+// at index view.map_index(n)
+template <typename StateVector, bool Ref, typename T>
+inline void update_add_element(n_quanta_sector_view<StateVector, Ref>& view,
+                               sv_index_type n,
+                               T&& value) {
+  update_add_element(view.state_vector,
+                     view.map_index(n),
+                     std::forward<T>(value));
+}
+
+// update_add_element() is not defined for constant views
+template <typename StateVector, bool Ref, typename T>
+inline void
+update_add_element(n_quanta_sector_view<StateVector const, Ref>&,
+                   sv_index_type,
+                   T&&) {
+  static_assert(!std::is_same<StateVector, StateVector>::value,
+                "update_add_element() is not supported for constant views");
+}
+
+// zeros_like() is not defined for views
+template <typename StateVector, bool Ref>
+inline StateVector zeros_like(n_quanta_sector_view<StateVector, Ref> const&) {
+  static_assert(!std::is_same<StateVector, StateVector>::value,
+                "zeros_like() is not supported for views");
+}
+
+// Set all amplitudes stored in the adapted StateVector object to zero
+template <typename StateVector, bool Ref>
+inline void set_zeros(n_quanta_sector_view<StateVector, Ref>& view) {
+  set_zeros(view.state_vector);
+}
+
+// set_zeros() is not defined for constant views
+template <typename StateVector, bool Ref>
+inline void set_zeros(n_quanta_sector_view<StateVector const, Ref>&) {
+  static_assert(!std::is_same<StateVector, StateVector>::value,
+                "set_zeros() is not supported for constant views");
+}
+
+// Apply functor `f` to all index/non-zero amplitude pairs in the adapted
+// StateVector object, whose sector indices lie in the range [begin, end).
+// Disjoint ranges can be processed concurrently.
+template <typename StateVector, bool Ref, typename Functor>
+inline void foreach(n_quanta_sector_view<StateVector, Ref> const& view,
+                    sv_index_type begin,
+                    sv_index_type end,
+                    Functor&& f) {
+  detail::for_each_n_quanta_sector_state(
+      view.sector,
+      view.nonsector_scatter,
+      view.M_nonsector,
+      begin,
+      end,
+      [&](sv_index_type sector_index, sv_index_type index) {
+        // Emulate decltype(auto)
+        decltype(get_element(view.state_vector, sector_index)) a =
+            get_element(view.state_vector, sector_index);
+
+        using T = typename n_quanta_sector_view<StateVector, Ref>::scalar_type;
+        if(!is_zero_amplitude<T>(a)) f(index, a);
+      });
+}
+
+// Apply functor `f` to all index/non-zero amplitude pairs
+// in the adapted StateVector object
+template <typename StateVector, bool Ref, typename Functor>
+inline void foreach(n_quanta_sector_view<StateVector, Ref> const& view,
+                    Functor&& f) {
+  foreach(view, 0, view.size(), std::forward<Functor>(f));
+}
+
+// Make a list of basis state indices spanning the sector with N quanta
+// The order of indices is consistent with that used by n_quanta_sector_view
+template <typename... IndexTypes>
+inline std::vector<sv_index_type>
+n_quanta_sector_basis_states(hilbert_space<IndexTypes...> const& hs,
+                             unsigned int N,
+                             std::set<int> const& algebra_ids =
+                                 default_n_quanta_algebra_ids()) {
+  detail::n_quanta_sector sector(hs, N, algebra_ids);
+  detail::bit_scatter nonsector_scatter(
+      ~sector.mask() & detail::low_bits_mask(hs.total_n_bits()));
+  unsigned int M_nonsector =
+      hs.total_n_bits() - detail::popcount(sector.mask());
+
+  sv_index_type size = sector.size() << M_nonsector;
+
+  std::vector<sv_index_type> basis_states;
+  basis_states.reserve(size);
+  detail::for_each_n_quanta_sector_state(
+      sector,
+      nonsector_scatter,
+      M_nonsector,
+      0,
+      size,
+      [&](sv_index_type, sv_index_type index) {
+        basis_states.push_back(index);
+      });
+
+  return basis_states;
+}
+
+template <typename StateVector>
+using make_nqs_view_ret_t =
+    n_quanta_sector_view<remove_cvref_t<StateVector>,
+                         std::is_lvalue_reference<StateVector>::value>;
+
+// Make a non-constant view of the sector with N quanta
+template <typename StateVector, typename... IndexTypes>
+auto make_nqs_view(StateVector&& sv,
+                   hilbert_space<IndexTypes...> const& hs,
+                   unsigned int N,
+                   std::set<int> const& algebra_ids =
+                       default_n_quanta_algebra_ids())
+    -> make_nqs_view_ret_t<StateVector> {
+  return make_nqs_view_ret_t<StateVector>(std::forward<StateVector>(sv),
+                                          hs,
+                                          N,
+                                          algebra_ids);
+}
+
+template <typename StateVector>
+using make_const_nqs_view_ret_t =
+    n_quanta_sector_view<remove_cvref_t<StateVector> const,
+                         std::is_lvalue_reference<StateVector>::value>;
+
+// Make a constant view of the sector with N quanta
+template <typename StateVector, typename... IndexTypes>
+auto make_const_nqs_view(StateVector&& sv,
+                         hilbert_space<IndexTypes...> const& hs,
+                         unsigned int N,
+                         std::set<int> const& algebra_ids =
+                             default_n_quanta_algebra_ids())
+    -> make_const_nqs_view_ret_t<StateVector> {
+  return make_const_nqs_view_ret_t<StateVector>(std::forward<StateVector>(sv),
+                                                hs,
+                                                N,
+                                                algebra_ids);
+}
+
+} // namespace libcommute
+
+#endif
@@ -0,0 +1,284 @@
+/*******************************************************************************
+ *
+ * This file is part of libcommute, a quantum operator algebra DSL and
+ * exact diagonalization toolkit for C++11/14/17.
+ *
+ * Copyright (C) 2016-2021 Igor Krivenko <igor.s.krivenko@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ ******************************************************************************/
+#ifndef LIBCOMMUTE_LOPERATOR_OUT_OF_CORE_SPACE_PARTITION_HPP_
+#define LIBCOMMUTE_LOPERATOR_OUT_OF_CORE_SPACE_PARTITION_HPP_
+
+#include "../scalar_traits.hpp"
+#include "loperator.hpp"
+#include "mapped_file.hpp"
+#include "sparse_state_vector.hpp"
+#include "subspace_file.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+//
+// Partition of a Hilbert space into invariant subspaces, which keeps all
+// per-basis-state data in memory-mapped files (POSIX only)
+//
+
+namespace libcommute {
+
+namespace detail {
+
+// A pair of basis states connected by an operator
+template <typename IndexType> struct basis_state_link {
+  IndexType from;
+  IndexType to;
+};
+
+} // namespace detail
+
+// Partition of a Hilbert space into a set of disjoint subspaces invariant
+// under action of a given Hermitian operator (Hamiltonian).
+//
+// Unlike space_partition, this class stores the subspace serial numbers of all
+// basis states in a memory-mapped file (subspace file) and can therefore
+// handle Hilbert spaces whose dimension exceeds the available RAM.
+class out_of_core_space_partition {
+
+  mapped_file file_;
+  detail::subspace_file_layout layout_ = {0, 0, 4};
+  std::uint64_t key_ = 0;
+
+  template <typename IndexType> IndexType* table() {
+    return reinterpret_cast<IndexType*>(static_cast<char*>(file_.data()) +
+                                        layout_.table_offset());
+  }
+  template <typename IndexType> IndexType const* table() const {
+    return reinterpret_cast<IndexType const*>(
+        static_cast<char const*>(file_.data()) + layout_.table_offset());
+  }
+  template <typename IndexType> IndexType* sizes() {
+    return reinterpret_cast<IndexType*>(static_cast<char*>(file_.data()) +
+                                        layout_.sizes_offset());
+  }
+  template <typename IndexType> IndexType const* sizes() const {
+    return reinterpret_cast<IndexType const*>(
+        static_cast<char const*>(file_.data()) + layout_.sizes_offset());
+  }
+
+  sv_index_type table_at(sv_index_type n) const {
+    return layout_.index_width == 4 ? sv_index_type(table<std::uint32_t>()[n])
+                                    : sv_index_type(table<std::uint64_t>()[n]);
+  }
+
+public:
+  // Default maximal number of buffered basis state links
+  static constexpr sv_index_type default_buffer_size = 1 << 22;
+
+  out_of_core_space_partition() = delete;
+
+  // Partition Hilbert space `hs` using Hermitian operator `h` and write the
+  // result into a subspace file `path` together with a user-defined `key`,
+  // e.g. the one computed by partition_key().
+  //
+  // Pairs of basis states connected by `h` are accumulated in a
+  // memory-mapped buffer file `path + ".links"` holding up to `buffer_size`
+  // pairs. Each time the buffer is full, the pairs are merged into a
+  // union-find forest stored in the subspace file itself. The buffer file is
+  // removed upon completion.
+  //
+  // This is an ordinary union-find algorithm running over a memory-mapped
+  // table: Root lookups access the table at random positions. It performs
+  // well as long as the table fits into the page cache, and slows down
+  // considerably when it does not.
+  //
+  // `hs` can be of any type, for which `get_dim(hs)` returns the dimension of
+  // the corresponding Hilbert space, and `foreach(hs, f)` applies functor `f`
+  // to each basis state index in `hs`.
+  template <typename HSType, typename LOpScalarType, int... LOpAlgebraIDs>
+  out_of_core_space_partition(
+      loperator<LOpScalarType, LOpAlgebraIDs...> const& h,
+      HSType const& hs,
+      std::string const& path,
+      sv_index_type buffer_size = default_buffer_size,
+      std::uint64_t key = 0)
+    : key_(key) {
+    if(buffer_size == 0)
+      throw std::invalid_argument("Buffer size must be positive");
+    if(detail::subspace_file_index_width(get_dim(hs)) == 4)
+      build<std::uint32_t>(h, hs, path, buffer_size);
+    else
+      build<std::uint64_t>(h, hs, path, buffer_size);
+  }
+
+  // Open an existing subspace file `path` for reading. The file can also be
+  // created by space_partition::save().
+  explicit out_of_core_space_partition(std::string const& path)
+    : file_(path, mapped_file::read_only) {
+    detail::subspace_file_header header{};
+    if(file_.size() < sizeof(header))
+      throw std::runtime_error("File '" + path + "' is not a subspace file");
+    std::memcpy(&header, file_.data(), sizeof(header));
+    layout_ = detail::check_subspace_file_header(header, path);
+    key_ = header.key;
+    if(file_.size() < layout_.matrix_elements_offset())
+      throw std::runtime_error("Subspace file '" + path + "' is truncated");
+  }
+
+  // Path to the subspace file
+  std::string const& path() const { return file_.path(); }
+
+  // Key stored in the subspace file
+  std::uint64_t key() const { return key_; }
+
+  // Hilbert space dimension
+  sv_index_type dim() const { return layout_.dim; }
+
+  // Number of subspaces
+  sv_index_type n_subspaces() const { return layout_.n_subspaces; }
+
+  // Find what invariant subspace a given basis state belongs to
+  sv_index_type operator[](sv_index_type index) const {
+    if(index >= dim())
+      throw std::out_of_range("Unexpected basis state index " +
+                              std::to_string(index));
+    else
+      return table_at(index);
+  }
+
+  // Number of basis states spanning a given subspace 'index'
+  sv_index_type subspace_size(sv_index_type index) const {
+    if(index >= n_subspaces())
+      throw std::runtime_error("Wrong subspace index " + std::to_string(index));
+    return layout_.index_width == 4
+               ? sv_index_type(sizes<std::uint32_t>()[index])
+               : sv_index_type(sizes<std::uint64_t>()[index]);
+  }
+
+  // Build a list of all basis states spanning a given subspace 'index'.
+  std::vector<sv_index_type> subspace_basis(sv_index_type index) const {
+    std::vector<sv_index_type> basis;
+    basis.reserve(subspace_size(index));
+    file_.advise(mapped_file::sequential);
+    for(sv_index_type n = 0; n < dim(); ++n) {
+      if(table_at(n) == index) basis.emplace_back(n);
+    }
+    return basis;
+  }
+
+  // Apply a functor `f` to all basis states in a given space partition.
+  // The functor must take two arguments, index of the basis state,
+  // and index of the subspace this basis state belongs to.
+  template <typename F>
+  friend void foreach(out_of_core_space_partition const& sp, F&& f) {
+    sp.file_.advise(mapped_file::sequential);
+    for(sv_index_type n = 0; n < sp.dim(); ++n) {
+      f(n, sp.table_at(n));
+    }
+  }
+
+private:
+  template <typename IndexType,
+            typename HSType,
+            typename LOpScalarType,
+            int... LOpAlgebraIDs>
+  void build(loperator<LOpScalarType, LOpAlgebraIDs...> const& h,
+             HSType const& hs,
+             std::string const& path,
+             sv_index_type buffer_size) {
+    using scalar_type =
+        typename loperator<LOpScalarType, LOpAlgebraIDs...>::scalar_type;
+    using link_t = detail::basis_state_link<IndexType>;
+
+    sv_index_type const d = get_dim(hs);
+    layout_ = {d, 0, sizeof(IndexType)};
+    file_ = mapped_file(path, mapped_file::create, layout_.sizes_offset());
+
+    // Union-find forest. The parent of each element is never greater than
+    // the element itself, so that the root of each tree is its smallest
+    // element.
+    IndexType* parents = table<IndexType>();
+    for(sv_index_type n = 0; n < d; ++n)
+      parents[n] = static_cast<IndexType>(n);
+
+    auto find_root = [parents](IndexType n) {
+      while(parents[n] != n) {
+        parents[n] = parents[parents[n]];
+        n = parents[n];
+      }
+      return n;
+    };
+
+    std::string links_path = path + ".links";
+    {
+      mapped_file links_file(links_path,
+                             mapped_file::create,
+                             buffer_size * sizeof(link_t));
+      link_t* links = static_cast<link_t*>(links_file.data());
+      sv_index_type n_links = 0;
+
+      auto flush_links = [&]() {
+        file_.advise(mapped_file::random);
+        for(sv_index_type l = 0; l < n_links; ++l) {
+          IndexType root1 = find_root(links[l].from);
+          IndexType root2 = find_root(links[l].to);
+          if(root1 < root2)
+            parents[root2] = root1;
+          else if(root2 < root1)
+            parents[root1] = root2;
+        }
+        n_links = 0;
+      };
+
+      sparse_state_vector<scalar_type> in_state(d);
+      sparse_state_vector<scalar_type> out_state(d);
+      foreach(hs, [&](sv_index_type in_index) {
+        in_state[in_index] = scalar_traits<scalar_type>::make_const(1);
+        h(in_state, out_state);
+        foreach(out_state, [&](sv_index_type out_index, scalar_type const&) {
+          if(out_index == in_index) return;
+          if(n_links == buffer_size) flush_links();
+          links[n_links++] = {static_cast<IndexType>(in_index),
+                              static_cast<IndexType>(out_index)};
+        });
+        set_zeros(in_state);
+      });
+      flush_links();
+    }
+    std::remove(links_path.c_str());
+
+    // Replace parents with subspace serial numbers in place. Subspaces are
+    // numbered in the order of appearance of their first basis state.
+    // Since parents[n] <= n, parents[parents[n]] has already been replaced
+    // with the serial number when basis state n is visited.
+    file_.advise(mapped_file::sequential);
+    sv_index_type n_subspaces = 0;
+    for(sv_index_type n = 0; n < d; ++n) {
+      IndexType parent = parents[n];
+      parents[n] = parent == n ? static_cast<IndexType>(n_subspaces++)
+                               : parents[parent];
+    }
+    layout_.n_subspaces = n_subspaces;
+
+    // Count basis states in each subspace
+    file_.resize(layout_.matrix_elements_offset());
+    IndexType const* subspace_of = table<IndexType>();
+    IndexType* subspace_sizes = sizes<IndexType>();
+    for(sv_index_type n = 0; n < d; ++n)
+      ++subspace_sizes[subspace_of[n]];
+
+    auto header = detail::make_subspace_file_header(layout_, key_);
+    std::memcpy(file_.data(), &header, sizeof(header));
+    file_.sync();
+  }
+};
+
+} // namespace libcommute
+
+#endif
@@ -0,0 +1,347 @@
+/*******************************************************************************
+ *
+ * This file is part of libcommute, a quantum operator algebra DSL and
+ * exact diagonalization toolkit for C++11/14/17.
+ *
+ * Copyright (C) 2016-2021 Igor Krivenko <igor.s.krivenko@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ ******************************************************************************/
+#ifndef LIBCOMMUTE_LOPERATOR_SHARDED_STATE_VECTOR_HPP_
+#define LIBCOMMUTE_LOPERATOR_SHARDED_STATE_VECTOR_HPP_
+
+#include "../scalar_traits.hpp"
+#include "state_vector.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <condition_variable>
+#include <cstddef>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+//
+// State vector distributed over multiple ranks (processes or threads)
+//
+// Each rank stores a contiguous block of amplitudes (shard) and calls
+// loperator::operator() with its own pair of sharded vectors. Contributions
+// to amplitudes stored by other ranks are buffered and delivered in bulk by
+// a collective call to sharded_state_vector::exchange().
+//
+// Communication between the ranks is delegated to a Transport object, which
+// must provide the following member functions.
+//
+//  int rank() const;
+//    Rank of the calling process, 0 <= rank() < n_ranks().
+//  int n_ranks() const;
+//    Total number of ranks.
+//  void all_to_all(std::vector<std::vector<char>> const& send,
+//                  std::vector<std::vector<char>>& recv);
+//    Collective operation. Send byte buffer send[r] to rank r and receive
+//    the buffer sent by rank r into recv[r], for all r.
+//
+// A Transport based on MPI can implement all_to_all() using MPI_Alltoall()
+// (to exchange buffer sizes) and MPI_Alltoallv(). in_process_transport defined
+// below connects ranks running as threads of a single process.
+//
+
+namespace libcommute {
+
+//
+// Partition of basis state indices into contiguous blocks
+//
+class block_partition {
+
+  sv_index_type dim_ = 0;
+  sv_index_type block_size_ = 1;
+  int n_blocks_ = 1;
+
+public:
+  block_partition() = default;
+  block_partition(sv_index_type dim, int n_blocks)
+    : dim_(dim), n_blocks_(n_blocks) {
+    if(n_blocks < 1)
+      throw std::invalid_argument("Number of blocks must be positive");
+    block_size_ = std::max<sv_index_type>((dim + n_blocks - 1) / n_blocks, 1);
+  }
+
+  // Total number of basis states
+  inline sv_index_type dim() const { return dim_; }
+
+  // Number of blocks
+  inline int n_blocks() const { return n_blocks_; }
+
+  // Block containing basis state `index`
+  inline int block(sv_index_type index) const {
+    return int(index / block_size_);
+  }
+
+  // First basis state of block `b`
+  inline sv_index_type begin(int b) const {
+    return std::min(sv_index_type(b) * block_size_, dim_);
+  }
+
+  // Past-the-end basis state of block `b`
+  inline sv_index_type end(int b) const { return begin(b + 1); }
+};
+
+//
+// Sharded state vector
+//
+template <typename ScalarType, typename Transport> class sharded_state_vector {
+
+  static_assert(std::is_trivially_copyable<ScalarType>::value,
+                "Amplitudes of a sharded state vector must be trivially "
+                "copyable");
+
+  // Contribution to a remotely stored amplitude
+  struct remote_entry_type {
+    sv_index_type index;
+    ScalarType value;
+  };
+
+  Transport* transport_;
+  block_partition partition_;
+  int rank_;
+
+  // First basis state stored on this rank
+  sv_index_type local_begin_;
+
+  // Locally stored amplitudes
+  std::vector<ScalarType> local_data_;
+
+  // Buffered contributions to amplitudes stored by other ranks
+  std::vector<std::vector<remote_entry_type>> outbox_;
+
+public:
+  sharded_state_vector() = delete;
+
+  // Make a zero state vector of dimension `dim` distributed over all ranks
+  // connected by `transport`. The transport object must outlive the vector.
+  sharded_state_vector(sv_index_type dim, Transport& transport)
+    : transport_(&transport),
+      partition_(dim, transport.n_ranks()),
+      rank_(transport.rank()),
+      local_begin_(partition_.begin(rank_)),
+      local_data_(partition_.end(rank_) - local_begin_,
+                  scalar_traits<ScalarType>::make_const(0)),
+      outbox_(transport.n_ranks()) {}
+
+  // Size of the vector (dimension of the full Hilbert space)
+  inline sv_index_type size() const { return partition_.dim(); }
+
+  // Partition of basis states between the ranks
+  inline block_partition const& partition() const { return partition_; }
+
+  // Rank of the calling process
+  inline int rank() const { return rank_; }
+
+  // Range of basis states stored on this rank
+  inline sv_index_type local_begin() const { return local_begin_; }
+  inline sv_index_type local_end() const {
+    return local_begin_ + local_data_.size();
+  }
+
+  // Locally stored amplitudes
+  inline std::vector<ScalarType>& local_data() { return local_data_; }
+  inline std::vector<ScalarType> const& local_data() const {
+    return local_data_;
+  }
+
+  // Number of buffered contributions to amplitudes stored by other ranks
+  inline std::size_t n_pending() const {
+    std::size_t n = 0;
+    for(auto const& b : outbox_)
+      n += b.size();
+    return n;
+  }
+
+  // Deliver buffered contributions to their ranks and add contributions
+  // received from other ranks. This is a collective operation, which must be
+  // called by all ranks.
+  void exchange() {
+    int n_ranks = int(outbox_.size());
+    std::vector<std::vector<char>> send(n_ranks), recv(n_ranks);
+    for(int r = 0; r < n_ranks; ++r) {
+      auto const& b = outbox_[r];
+      send[r].resize(b.size() * sizeof(remote_entry_type));
+      if(!b.empty()) std::memcpy(send[r].data(), b.data(), send[r].size());
+    }
+
+    transport_->all_to_all(send, recv);
+
+    for(int r = 0; r < n_ranks; ++r) {
+      outbox_[r].clear();
+      std::size_t n = recv[r].size() / sizeof(remote_entry_type);
+      for(std::size_t i = 0; i < n; ++i) {
+        remote_entry_type e;
+        std::memcpy(&e,
+                    recv[r].data() + i * sizeof(remote_entry_type),
+                    sizeof(remote_entry_type));
+        assert(partition_.block(e.index) == rank_);
+        add_assign(local_data_[e.index - local_begin_], e.value);
+      }
+    }
+  }
+
+  // Get n-th state amplitude. Throws std::out_of_range if `n` is not stored
+  // on this rank.
+  inline friend ScalarType const& get_element(sharded_state_vector const& sv,
+                                              sv_index_type n) {
+    if(n < sv.local_begin() || n >= sv.local_end())
+      throw std::out_of_range("Amplitude " + std::to_string(n) +
+                              " is not stored on rank " +
+                              std::to_string(sv.rank_));
+    return sv.local_data_[n - sv.local_begin_];
+  }
+
+  // Add a constant to the n-th state amplitude. Contributions to amplitudes
+  // stored by other ranks are buffered until the next call to exchange().
+  template <typename T>
+  inline friend void
+  update_add_element(sharded_state_vector& sv, sv_index_type n, T&& value) {
+    assert(n < sv.size());
+    if(n >= sv.local_begin_ && n < sv.local_end())
+      add_assign(sv.local_data_[n - sv.local_begin_], value);
+    else
+      sv.outbox_[sv.partition_.block(n)].push_back(
+          remote_entry_type{n, ScalarType(value)});
+  }
+
+  // Set all amplitudes to zero and discard buffered contributions
+  inline friend void set_zeros(sharded_state_vector& sv) {
+    std::fill(sv.local_data_.begin(),
+              sv.local_data_.end(),
+              scalar_traits<ScalarType>::make_const(0));
+    for(auto& b : sv.outbox_)
+      b.clear();
+  }
+
+  // Make a zero vector distributed in the same way
+  inline friend sharded_state_vector
+  zeros_like(sharded_state_vector const& sv) {
+    return sharded_state_vector(sv.size(), *sv.transport_);
+  }
+
+  // Apply functor `f` to all index/non-zero amplitude pairs stored on
+  // this rank. Throws std::logic_error if the vector has buffered
+  // contributions that have not been delivered by exchange().
+  template <typename Functor>
+  inline friend void foreach(sharded_state_vector const& sv, Functor&& f) {
+    if(sv.n_pending() != 0)
+      throw std::logic_error(
+          "foreach() called for a sharded state vector with " +
+          std::to_string(sv.n_pending()) +
+          " undelivered contributions, exchange() must be called first");
+    for(sv_index_type i = 0; i < sv.local_data_.size(); ++i) {
+      auto const& a = sv.local_data_[i];
+      if(is_zero_amplitude<ScalarType>(a))
+        continue;
+      else
+        f(sv.local_begin_ + i, a);
+    }
+  }
+};
+
+// Get element type of a sharded_state_vector object
+template <typename ScalarType, typename Transport>
+struct element_type<sharded_state_vector<ScalarType, Transport>> {
+  using type = ScalarType;
+};
+
+// Act on a sharded state vector `in` with a linear operator `op`, store
+// the result in `out` and deliver contributions to amplitudes stored by other
+// ranks. This is a collective operation, which must be called by all ranks.
+template <typename LOperator, typename ScalarType, typename Transport>
+inline void
+apply_and_exchange(LOperator const& op,
+                   sharded_state_vector<ScalarType, Transport> const& in,
+                   sharded_state_vector<ScalarType, Transport>& out) {
+  op(in, out);
+  out.exchange();
+}
+
+//
+// Transport connecting ranks running as threads of a single process
+//
+
+class in_process_transport;
+
+// State shared by all ranks of an in-process group
+class in_process_group {
+
+  int n_ranks_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  int n_arrived_ = 0;
+  unsigned long generation_ = 0;
+
+  // mailbox_[from][to]
+  std::vector<std::vector<std::vector<char>>> mailbox_;
+
+  friend class in_process_transport;
+
+  // Block until all ranks have called this function
+  void barrier(std::unique_lock<std::mutex>& lock) {
+    unsigned long generation = generation_;
+    if(++n_arrived_ == n_ranks_) {
+      n_arrived_ = 0;
+      ++generation_;
+      cv_.notify_all();
+    } else
+      cv_.wait(lock, [&] { return generation_ != generation; });
+  }
+
+public:
+  explicit in_process_group(int n_ranks)
+    : n_ranks_(n_ranks), mailbox_(n_ranks) {
+    if(n_ranks < 1)
+      throw std::invalid_argument("Number of ranks must be positive");
+  }
+  in_process_group(in_process_group const&) = delete;
+  in_process_group& operator=(in_process_group const&) = delete;
+
+  // Number of ranks in the group
+  int n_ranks() const { return n_ranks_; }
+};
+
+class in_process_transport {
+
+  in_process_group* group_;
+  int rank_;
+
+public:
+  in_process_transport(in_process_group& group, int rank)
+    : group_(&group), rank_(rank) {
+    if(rank < 0 || rank >= group.n_ranks())
+      throw std::invalid_argument("Invalid rank " + std::to_string(rank));
+  }
+
+  int rank() const { return rank_; }
+  int n_ranks() const { return group_->n_ranks_; }
+
+  void all_to_all(std::vector<std::vector<char>> const& send,
+                  std::vector<std::vector<char>>& recv) {
+    std::unique_lock<std::mutex> lock(group_->mutex_);
+    group_->mailbox_[rank_] = send;
+    group_->barrier(lock);
+    recv.resize(group_->n_ranks_);
+    for(int r = 0; r < group_->n_ranks_; ++r)
+      recv[r] = group_->mailbox_[r][rank_];
+    // Mailboxes must not be overwritten before all ranks have read them
+    group_->barrier(lock);
+  }
+};
+
+} // namespace libcommute
+
+#endif
@@ -0,0 +1,250 @@
+/*******************************************************************************
+ *
+ * This file is part of libcommute, a quantum operator algebra DSL and
+ * exact diagonalization toolkit for C++11/14/17.
+ *
+ * Copyright (C) 2016-2021 Igor Krivenko <igor.s.krivenko@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ ******************************************************************************/
+#ifndef LIBCOMMUTE_LOPERATOR_SORTED_SPARSE_STATE_VECTOR_HPP_
+#define LIBCOMMUTE_LOPERATOR_SORTED_SPARSE_STATE_VECTOR_HPP_
+
+#include "../scalar_traits.hpp"
+#include "state_vector.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace libcommute {
+
+namespace detail {
+
+// Sort index/amplitude pairs by index. Larger arrays are sorted using
+// the least significant digit radix sort with 8-bit digits, which skips
+// digits that are equal for all indices. Pairs with equal indices retain
+// their relative order. `buffer` is used as scratch space.
+template <typename T>
+void radix_sort_by_index(std::vector<std::pair<sv_index_type, T>>& v,
+                         std::vector<std::pair<sv_index_type, T>>& buffer) {
+  std::size_t n = v.size();
+  if(n < 256) {
+    std::stable_sort(v.begin(),
+                     v.end(),
+                     [](std::pair<sv_index_type, T> const& p1,
+                        std::pair<sv_index_type, T> const& p2) {
+                       return p1.first < p2.first;
+                     });
+    return;
+  }
+
+  constexpr int n_digits = sizeof(sv_index_type);
+  std::vector<std::size_t> counts(n_digits * 256, 0);
+  for(auto const& p : v) {
+    for(int d = 0; d < n_digits; ++d)
+      ++counts[d * 256 + ((p.first >> (8 * d)) & 0xFF)];
+  }
+
+  buffer.resize(n);
+  for(int d = 0; d < n_digits; ++d) {
+    std::size_t* c = counts.data() + d * 256;
+    if(c[(v.front().first >> (8 * d)) & 0xFF] == n) continue;
+
+    std::size_t offset = 0;
+    for(int digit = 0; digit < 256; ++digit) {
+      std::size_t count = c[digit];
+      c[digit] = offset;
+      offset += count;
+    }
+    for(auto& p : v)
+      buffer[c[(p.first >> (8 * d)) & 0xFF]++] = std::move(p);
+    std::swap(v, buffer);
+  }
+}
+
+} // namespace detail
+
+//
+// Implementation of the StateVector concept based on a sorted sparse storage
+//
+// Non-zero amplitudes are stored as a list of index/amplitude pairs sorted by
+// index (coordinate format). update_add_element() appends contributions to
+// a buffer. The buffer is sorted and merged into the list when the amplitudes
+// are accessed next time, or when consolidate() is called explicitly.
+//
+template <typename ScalarType> class sorted_sparse_state_vector {
+
+  using entry_type = std::pair<sv_index_type, ScalarType>;
+
+  sv_index_type size_;
+
+  // Non-zero amplitudes sorted by index
+  mutable std::vector<entry_type> entries_;
+
+  // Buffered contributions added by update_add_element()
+  mutable std::vector<entry_type> buffer_;
+
+  // Scratch space for sorting and merging
+  mutable std::vector<entry_type> scratch_;
+
+  // Sort the buffered contributions and add them to the stored amplitudes
+  void merge_buffer() const {
+    if(buffer_.empty()) return;
+    detail::radix_sort_by_index(buffer_, scratch_);
+
+    // Reduce contributions with equal indices
+    auto out = buffer_.begin();
+    for(auto it = buffer_.begin() + 1; it != buffer_.end(); ++it) {
+      if(it->first == out->first)
+        out->second += it->second;
+      else
+        *++out = std::move(*it);
+    }
+    buffer_.erase(out + 1, buffer_.end());
+
+    merge_sorted(buffer_);
+    buffer_.clear();
+  }
+
+  // Add a list of amplitudes with unique sorted indices
+  void merge_sorted(std::vector<entry_type> const& v) const {
+    scratch_.clear();
+    scratch_.reserve(entries_.size() + v.size());
+    auto it1 = entries_.begin();
+    auto it2 = v.begin();
+    while(it1 != entries_.end() && it2 != v.end()) {
+      if(it1->first < it2->first) {
+        scratch_.emplace_back(std::move(*it1++));
+      } else if(it2->first < it1->first) {
+        if(!is_zero_amplitude<ScalarType>(it2->second))
+          scratch_.push_back(*it2);
+        ++it2;
+      } else {
+        it1->second += it2->second;
+        if(!is_zero_amplitude<ScalarType>(it1->second))
+          scratch_.emplace_back(std::move(*it1));
+        ++it1;
+        ++it2;
+      }
+    }
+    for(; it1 != entries_.end(); ++it1)
+      scratch_.emplace_back(std::move(*it1));
+    for(; it2 != v.end(); ++it2) {
+      if(!is_zero_amplitude<ScalarType>(it2->second))
+        scratch_.push_back(*it2);
+    }
+    std::swap(entries_, scratch_);
+  }
+
+public:
+  sorted_sparse_state_vector() = delete;
+  explicit sorted_sparse_state_vector(sv_index_type size) : size_(size) {}
+
+  // Size of the vector
+  inline sv_index_type size() const { return size_; }
+
+  // Number of non-zero amplitudes
+  inline sv_index_type n_nonzeros() const {
+    merge_buffer();
+    return entries_.size();
+  }
+
+  // Number of buffered contributions that have not been merged yet
+  inline std::size_t n_buffered() const { return buffer_.size(); }
+
+  // Reserve storage for at least `n` buffered contributions
+  inline void reserve(std::size_t n) { buffer_.reserve(n); }
+
+  // Merge all buffered contributions into the sorted list of amplitudes
+  inline void consolidate() { merge_buffer(); }
+
+  // Add amplitudes of another vector to this vector
+  inline void merge(sorted_sparse_state_vector const& sv) {
+    assert(sv.size_ == size_);
+    merge_buffer();
+    if(&sv == this) {
+      for(auto& e : entries_)
+        e.second += e.second;
+      return;
+    }
+    sv.merge_buffer();
+    merge_sorted(sv.entries_);
+  }
+
+  // Get n-th state amplitude
+  inline friend ScalarType get_element(sorted_sparse_state_vector const& sv,
+                                       sv_index_type n) {
+    assert(n < sv.size_);
+    sv.merge_buffer();
+    auto it = std::lower_bound(
+        sv.entries_.begin(),
+        sv.entries_.end(),
+        n,
+        [](entry_type const& p, sv_index_type index) {
+          return p.first < index;
+        });
+    if(it == sv.entries_.end() || it->first != n)
+      return scalar_traits<ScalarType>::make_const(0);
+    else
+      return it->second;
+  }
+
+  // Add a constant to the n-th state amplitude
+  template <typename T>
+  inline friend void update_add_element(sorted_sparse_state_vector& sv,
+                                        sv_index_type n,
+                                        T&& value) {
+    assert(n < sv.size_);
+    if(!is_zero_amplitude<ScalarType>(value))
+      sv.buffer_.emplace_back(n, std::forward<T>(value));
+  }
+
+  // Set all amplitudes to zero, the allocated storage is retained
+  inline friend void set_zeros(sorted_sparse_state_vector& sv) {
+    sv.entries_.clear();
+    sv.buffer_.clear();
+  }
+
+  // Make an empty vector with the same Hilbert space dimension
+  inline friend sorted_sparse_state_vector
+  zeros_like(sorted_sparse_state_vector const& sv) {
+    return sorted_sparse_state_vector(sv.size_);
+  }
+
+  // Apply functor `f` to all index/non-zero amplitude pairs in the order of
+  // ascending indices
+  template <typename Functor>
+  inline friend void foreach(sorted_sparse_state_vector const& sv,
+                             Functor&& f) {
+    sv.merge_buffer();
+    for(auto const& p : sv.entries_)
+      f(p.first, p.second);
+  }
+
+  // Force removal of all amplitudes meeting a specified criterion
+  template <typename UnaryPredicate> inline void prune(UnaryPredicate&& p) {
+    merge_buffer();
+    entries_.erase(std::remove_if(entries_.begin(),
+                                  entries_.end(),
+                                  [&p](entry_type const& e) -> bool {
+                                    return p(e.second);
+                                  }),
+                   entries_.end());
+  }
+};
+
+// Get element type of a sorted_sparse_state_vector<ScalarType> object
+template <typename ScalarType>
+struct element_type<sorted_sparse_state_vector<ScalarType>> {
+  using type = ScalarType;
+};
+
+} // namespace libcommute
+
+#endif
@@ -17,13 +17,22 @@
 #include "disjoint_sets.hpp"
 #include "loperator.hpp"
 #include "sparse_state_vector.hpp"
+#include "subspace_file.hpp"
 
+#include <algorithm>
+#include <complex>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
 #include <functional>
+#include <iterator>
+#include <limits>
 #include <map>
 #include <set>
 #include <stdexcept>
 #include <string>
 #include <tuple>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -41,6 +50,73 @@ using matrix_elements_map =
 // Connections between subspaces
 using connections_map = std::set<std::pair<sv_index_type, sv_index_type>>;
 
+namespace detail {
+
+// Strict weak ordering of quantum numbers (eigenvalues of conserved operators).
+// Values closer to each other than the zero detection tolerance are considered
+// equal.
+template <typename S>
+inline bool quantum_number_less(S const& qn1, S const& qn2) {
+  return !scalar_traits<S>::is_zero(qn2 - qn1) && qn1 < qn2;
+}
+template <typename T>
+inline bool quantum_number_less(std::complex<T> const& qn1,
+                                std::complex<T> const& qn2) {
+  if(!scalar_traits<T>::is_zero(qn2.real() - qn1.real()))
+    return qn1.real() < qn2.real();
+  else
+    return quantum_number_less(qn1.imag(), qn2.imag());
+}
+
+// Lexicographical ordering of lists of quantum numbers
+struct quantum_numbers_less {
+  template <typename S>
+  bool operator()(std::vector<S> const& qns1,
+                  std::vector<S> const& qns2) const {
+    return std::lexicographical_compare(
+        qns1.begin(),
+        qns1.end(),
+        qns2.begin(),
+        qns2.end(),
+        [](S const& qn1, S const& qn2) {
+          return quantum_number_less(qn1, qn2);
+        });
+  }
+};
+
+// Dense array of basis state/subspace indices. 32-bit integers are used to
+// store the elements whenever the maximal stored value allows for it.
+class adaptive_index_array {
+  bool compact_ = true;
+  std::vector<std::uint32_t> data32_;
+  std::vector<std::uint64_t> data64_;
+
+public:
+  adaptive_index_array() = default;
+  adaptive_index_array(std::size_t size, sv_index_type max_value)
+    : compact_(max_value <= std::numeric_limits<std::uint32_t>::max()),
+      data32_(compact_ ? size : 0),
+      data64_(compact_ ? 0 : size) {}
+
+  // Number of elements
+  inline std::size_t size() const {
+    return compact_ ? data32_.size() : data64_.size();
+  }
+
+  // Element access
+  inline sv_index_type operator[](std::size_t i) const {
+    return compact_ ? sv_index_type(data32_[i]) : sv_index_type(data64_[i]);
+  }
+  inline void set(std::size_t i, sv_index_type value) {
+    if(compact_)
+      data32_[i] = static_cast<std::uint32_t>(value);
+    else
+      data64_[i] = value;
+  }
+};
+
+} // namespace detail
+
 // Partition of a Hilbert space into a set of disjoint subspaces invariant
 // under action of a given Hermitian operator (Hamiltonian).
 //
@@ -50,17 +126,19 @@ using connections_map = std::set<std::pair<sv_index_type, sv_index_type>>;
 */
 class space_partition {
 
-  // Space partition
-  disjoint_sets ds;
-  // Map representative basis state to subspace index
-  std::map<sv_index_type, sv_index_type> root_to_subspace;
+  // Index of the subspace each basis state belongs to
+  detail::adaptive_index_array subspace_of;
+  // Number of basis states in each subspace
+  std::vector<sv_index_type> subspace_sizes;
 
   template <typename LOpScalarType, int... LOpAlgebraIDs>
   using loperator_melem_t = matrix_elements_map<
       typename loperator<LOpScalarType, LOpAlgebraIDs...>::scalar_type>;
 
+  // Used by load()
+  space_partition() = default;
+
 public:
-  space_partition() = delete;
 
   // Partition Hilbert space `hs` using Hermitian operator `h`.
   //
@@ -69,11 +147,11 @@ public:
   // to each basis state index in `hs`.
   template <typename HSType, typename LOpScalarType, int... LOpAlgebraIDs>
   space_partition(loperator<LOpScalarType, LOpAlgebraIDs...> const& h,
-                  HSType const& hs)
-    : ds(get_dim(hs)) {
+                  HSType const& hs) {
     using scalar_type =
         typename loperator<LOpScalarType, LOpAlgebraIDs...>::scalar_type;
     sv_index_type d = get_dim(hs);
+    adaptive_disjoint_sets ds(d);
 
     sparse_state_vector<scalar_type> in_state(d);
     sparse_state_vector<scalar_type> out_state(d);
@@ -86,7 +164,7 @@ public:
       set_zeros(in_state);
     });
 
-    update_root_to_subspace();
+    init_subspaces(ds);
   }
 
   // Partition Hilbert space `hs` using Hermitian operator `h`. Save
@@ -99,11 +177,11 @@ public:
   template <typename HSType, typename LOpScalarType, int... LOpAlgebraIDs>
   space_partition(loperator<LOpScalarType, LOpAlgebraIDs...> const& h,
                   HSType const& hs,
-                  loperator_melem_t<LOpScalarType, LOpAlgebraIDs...>& me)
-    : ds(get_dim(hs)) {
+                  loperator_melem_t<LOpScalarType, LOpAlgebraIDs...>& me) {
     using scalar_type =
         typename loperator<LOpScalarType, LOpAlgebraIDs...>::scalar_type;
     sv_index_type d = get_dim(hs);
+    adaptive_disjoint_sets ds(d);
 
     sparse_state_vector<scalar_type> in_state(d);
     sparse_state_vector<scalar_type> out_state(d);
@@ -119,7 +197,152 @@ public:
       set_zeros(in_state);
     });
 
-    update_root_to_subspace();
+    init_subspaces(ds);
+  }
+
+  // Partition Hilbert space `hs` using Hermitian operator `h` and a list of
+  // diagonal operators `conserved` commuting with `h`.
+  //
+  // Basis states are first sorted into buckets with equal eigenvalues of all
+  // operators from `conserved` (quantum numbers). Invariant subspaces of `h`
+  // are then searched for within each bucket separately. Buckets containing
+  // only one basis state are not acted upon by `h` at all.
+  //
+  // `hs` can be of any type, for which `get_dim(hs)` returns the dimension of
+  // the corresponding Hilbert space, and `foreach(hs, f)` applies functor `f`
+  // to each basis state index in `hs`.
+  template <typename HSType, typename LOpScalarType, int... LOpAlgebraIDs>
+  space_partition(
+      loperator<LOpScalarType, LOpAlgebraIDs...> const& h,
+      HSType const& hs,
+      std::vector<loperator<LOpScalarType, LOpAlgebraIDs...>> const&
+          conserved) {
+    using scalar_type =
+        typename loperator<LOpScalarType, LOpAlgebraIDs...>::scalar_type;
+    sv_index_type d = get_dim(hs);
+
+    sparse_state_vector<scalar_type> in_state(d);
+    sparse_state_vector<scalar_type> out_state(d);
+
+    // subspace_of temporarily stores bucket indices of basis states that are
+    // yet to be processed (`pending`), and the smallest basis state index
+    // within the invariant subspace for all other basis states. Basis states
+    // not visited by `foreach(hs)` form one-element subspaces.
+    subspace_of = detail::adaptive_index_array(d, d == 0 ? 0 : d - 1);
+    for(sv_index_type n = 0; n < d; ++n)
+      subspace_of.set(n, n);
+    std::vector<bool> pending(d, false);
+
+    // Label basis states with indices of their respective buckets
+    std::map<std::vector<scalar_type>,
+             sv_index_type,
+             detail::quantum_numbers_less>
+        qns_to_bucket;
+    std::vector<sv_index_type> bucket_sizes;
+    std::vector<scalar_type> qns(conserved.size());
+    foreach(hs, [&](sv_index_type in_index) {
+      in_state[in_index] = scalar_traits<scalar_type>::make_const(1);
+      for(std::size_t q = 0; q < conserved.size(); ++q) {
+        conserved[q](in_state, out_state);
+        qns[q] = scalar_traits<scalar_type>::make_const(0);
+        foreach(out_state, [&](sv_index_type out_index, scalar_type const& a) {
+          if(out_index != in_index)
+            throw std::runtime_error("Conserved operator " +
+                                     std::to_string(q) + " is not diagonal");
+          qns[q] = a;
+        });
+      }
+      sv_index_type b =
+          qns_to_bucket.emplace(qns, qns_to_bucket.size()).first->second;
+      if(b == bucket_sizes.size()) bucket_sizes.push_back(0);
+      ++bucket_sizes[b];
+      subspace_of.set(in_index, b);
+      pending[in_index] = true;
+      set_zeros(in_state);
+    });
+    qns_to_bucket.clear();
+
+    // Buckets are processed in batches of consecutive buckets. Each batch
+    // holds lists of its basis states, which are collected by one pass over
+    // subspace_of. The batch size is a trade-off between the number of passes
+    // and the memory footprint.
+    sv_index_type n_buckets = bucket_sizes.size();
+    sv_index_type batch_size =
+        std::max(d / 16,
+                 n_buckets == 0 ? sv_index_type(0)
+                                : *std::max_element(bucket_sizes.begin(),
+                                                    bucket_sizes.end()));
+    std::vector<sv_index_type> batch_start, batch_states;
+    for(sv_index_type b_begin = 0, b_end = 0; b_begin < n_buckets;
+        b_begin = b_end) {
+      // Lists of basis states in each bucket of the batch, stored contiguously
+      batch_start.assign(1, 0);
+      for(b_end = b_begin; b_end < n_buckets &&
+                           (b_end == b_begin ||
+                            batch_start.back() + bucket_sizes[b_end] <=
+                                batch_size);
+          ++b_end)
+        batch_start.push_back(batch_start.back() + bucket_sizes[b_end]);
+
+      batch_states.resize(batch_start.back());
+      {
+        std::vector<sv_index_type> pos(batch_start.begin(),
+                                       batch_start.end() - 1);
+        for(sv_index_type n = 0; n < d; ++n) {
+          if(!pending[n]) continue;
+          sv_index_type b = subspace_of[n];
+          if(b >= b_begin && b < b_end) batch_states[pos[b - b_begin]++] = n;
+        }
+      }
+
+      // Find invariant subspaces within each bucket
+      for(sv_index_type b = b_begin; b < b_end; ++b) {
+        auto first = batch_states.cbegin() + batch_start[b - b_begin];
+        auto last = batch_states.cbegin() + batch_start[b - b_begin + 1];
+        std::size_t bucket_size = std::distance(first, last);
+
+        adaptive_disjoint_sets bucket_ds(bucket_size);
+        if(bucket_size > 1) {
+          for(auto it = first; it != last; ++it) {
+            in_state[*it] = scalar_traits<scalar_type>::make_const(1);
+            h(in_state, out_state);
+            foreach(out_state,
+                    [&](sv_index_type out_index, scalar_type const&) {
+                      auto out_it = std::lower_bound(first, last, out_index);
+                      if(out_it == last || *out_it != out_index)
+                        throw std::runtime_error("Operator does not conserve "
+                                                 "the provided quantum "
+                                                 "numbers");
+                      bucket_ds.set_union(std::distance(first, it),
+                                          std::distance(first, out_it));
+                    });
+            set_zeros(in_state);
+          }
+          bucket_ds.compress_sets();
+          bucket_ds.normalize_sets();
+        }
+
+        for(std::size_t i = 0; i < bucket_size; ++i) {
+          subspace_of.set(first[i], first[bucket_ds.find_root(i)]);
+          pending[first[i]] = false;
+        }
+      }
+    }
+    std::vector<bool>().swap(pending);
+
+    // Enumerate subspaces in the order of their smallest basis states
+    subspace_sizes.clear();
+    for(sv_index_type n = 0; n < d; ++n) {
+      sv_index_type root = subspace_of[n];
+      if(root == n) {
+        subspace_of.set(n, subspace_sizes.size());
+        subspace_sizes.push_back(1);
+      } else {
+        sv_index_type subspace = subspace_of[root];
+        subspace_of.set(n, subspace);
+        ++subspace_sizes[subspace];
+      }
+    }
   }
 
   // Perform Phase II of the automatic partition algorithm
@@ -148,7 +371,7 @@ public:
     sparse_state_vector<scalar_type> out_state(d);
     foreach(hs, [&](sv_index_type in_index) {
       in_state[in_index] = scalar_traits<scalar_type>::make_const(1);
-      sv_index_type in_subspace = ds.find_root(in_index);
+      sv_index_type in_subspace = subspace_of[in_index];
 
       auto fill_conn = [&,
                         this](loperator_t const& lop,
@@ -157,7 +380,7 @@ public:
         lop(in_state, out_state);
         // Iterate over non-zero final amplitudes
         foreach(out_state, [&](sv_index_type out_index, scalar_type const& a) {
-          sv_index_type out_subspace = ds.find_root(out_index);
+          sv_index_type out_subspace = subspace_of[out_index];
           conn.insert({in_subspace, out_subspace});
           if(store_matrix_elements) elem[{out_index, in_index}] = a;
         });
@@ -169,6 +392,9 @@ public:
       set_zeros(in_state);
     });
 
+    // Partition of the set of subspaces
+    adaptive_disjoint_sets subspaces_ds(n_subspaces());
+
     // 'Zigzag' traversal algorithm
     while(!Cd_conn.empty()) {
 
@@ -188,7 +414,7 @@ public:
       // - Merges upper_subspace with all subspaces generated from
       //   upper_subspace by application of (C^+ C)^(2*n).
       std::function<void(sv_index_type, bool)> zigzag_traversal =
-          [this,
+          [&subspaces_ds,
            lower_subspace,
            upper_subspace,
            &Cd_conn,
@@ -206,9 +432,9 @@ public:
               (upwards ? Cd_conn : C_conn).erase(it);
 
               if(upwards)
-                ds.set_union(out_subspace, upper_subspace);
+                subspaces_ds.set_union(out_subspace, upper_subspace);
               else
-                ds.set_union(out_subspace, lower_subspace);
+                subspaces_ds.set_union(out_subspace, lower_subspace);
 
               // Recursively apply to all found out_subspace's with
               // a 'flipped' direction
@@ -220,25 +446,31 @@ public:
       zigzag_traversal(lower_subspace, true);
     }
 
-    update_root_to_subspace();
+    merge_subspaces_impl(subspaces_ds);
 
     return std::make_pair(Cd_elements, C_elements);
   }
 
   // Hilbert space dimension
-  sv_index_type dim() const { return ds.size(); }
+  sv_index_type dim() const { return subspace_of.size(); }
 
   // Number of subspaces
-  sv_index_type n_subspaces() const { return ds.n_sets(); }
+  sv_index_type n_subspaces() const { return subspace_sizes.size(); }
 
   // Find what invariant subspace a given basis state belongs to
   sv_index_type operator[](sv_index_type index) const {
-    auto it = root_to_subspace.find(ds.find_root(index));
-    if(it == root_to_subspace.end())
+    if(index >= dim())
       throw std::out_of_range("Unexpected basis state index " +
                               std::to_string(index));
     else
-      return it->second;
+      return subspace_of[index];
+  }
+
+  // Number of basis states spanning a given subspace 'index'
+  sv_index_type subspace_size(sv_index_type index) const {
+    if(index >= n_subspaces())
+      throw std::runtime_error("Wrong subspace index " + std::to_string(index));
+    return subspace_sizes[index];
   }
 
   // Find all subspace-to-subspace connections generated by a given operator
@@ -256,15 +488,13 @@ public:
     sparse_state_vector<scalar_type> in_state(d);
     sparse_state_vector<scalar_type> out_state(d);
     foreach(hs, [&](sv_index_type in_index) {
-      sv_index_type in_subspace =
-          root_to_subspace.find(ds.find_root(in_index))->second;
+      sv_index_type in_subspace = subspace_of[in_index];
 
       in_state[in_index] = scalar_traits<scalar_type>::make_const(1);
       op(in_state, out_state);
 
       foreach(out_state, [&](sv_index_type out_index, scalar_type const&) {
-        sv_index_type out_subspace =
-            root_to_subspace.find(ds.find_root(out_index))->second;
+        sv_index_type out_subspace = subspace_of[out_index];
         connections.emplace(in_subspace, out_subspace);
       });
 
@@ -279,19 +509,21 @@ public:
     if(index >= n_subspaces())
       throw std::runtime_error("Wrong subspace index " + std::to_string(index));
     std::vector<sv_index_type> basis;
-    foreach(*this, [&](sv_index_type i, sv_index_type subspace) {
-      if(subspace == index) basis.emplace_back(i);
-    });
+    basis.reserve(subspace_sizes[index]);
+    for(sv_index_type n = 0; n < dim(); ++n) {
+      if(subspace_of[n] == index) basis.emplace_back(n);
+    }
     return basis;
   }
 
   // Build lists of basis states spanning subspaces in this partition.
+  // This is done in a single pass over all basis states.
   std::vector<std::vector<sv_index_type>> subspace_bases() const {
-    std::vector<std::vector<sv_index_type>> bases(n_subspaces(),
-                                                  std::vector<sv_index_type>{});
-    foreach(*this, [&](sv_index_type i, sv_index_type subspace) {
-      bases[subspace].emplace_back(i);
-    });
+    std::vector<std::vector<sv_index_type>> bases(n_subspaces());
+    for(sv_index_type subspace = 0; subspace < n_subspaces(); ++subspace)
+      bases[subspace].reserve(subspace_sizes[subspace]);
+    for(sv_index_type n = 0; n < dim(); ++n)
+      bases[subspace_of[n]].emplace_back(n);
     return bases;
   }
 
@@ -300,19 +532,297 @@ public:
   // and index of the subspace this basis state belongs to.
   template <typename F> friend void foreach(space_partition const& sp, F&& f) {
     for(sv_index_type n = 0; n < sp.dim(); ++n) {
-      f(n, sp[n]);
+      f(n, sp.subspace_of[n]);
     }
   }
 
+  // Save this partition into a subspace file `path` together with a
+  // user-defined `key`, e.g. the one computed by partition_key().
+  void save(std::string const& path, std::uint64_t key = 0) const {
+    save_impl<double>(path, key, nullptr);
+  }
+
+  // Save this partition and matrix elements `me` into a subspace file `path`
+  // together with a user-defined `key`.
+  template <typename ScalarType>
+  void save(std::string const& path,
+            matrix_elements_map<ScalarType> const& me,
+            std::uint64_t key = 0) const {
+    save_impl<ScalarType>(path, key, &me);
+  }
+
+  // Load a partition from a subspace file `path`. Throws if the key stored in
+  // the file differs from `key`.
+  static space_partition load(std::string const& path, std::uint64_t key = 0) {
+    return load_impl<double>(path, key, nullptr);
+  }
+
+  // Load a partition and matrix elements `me` from a subspace file `path`.
+  // Throws if the key stored in the file differs from `key`.
+  template <typename ScalarType>
+  static space_partition load(std::string const& path,
+                              matrix_elements_map<ScalarType>& me,
+                              std::uint64_t key = 0) {
+    return load_impl<ScalarType>(path, key, &me);
+  }
+
+  // Check if `path` is a readable subspace file with a given key
+  static bool can_load(std::string const& path, std::uint64_t key = 0) {
+    detail::subspace_file_header header{};
+    return read_header(path, header) && header.key == key;
+  }
+
+  // Check if `path` is a readable subspace file with a given key, which
+  // contains matrix elements of type ScalarType
+  template <typename ScalarType>
+  static bool can_load(std::string const& path, std::uint64_t key = 0) {
+    detail::subspace_file_header header{};
+    return read_header(path, header) && header.key == key &&
+           detail::has_subspace_file_scalar<ScalarType>(header);
+  }
+
 private:
-  void update_root_to_subspace() {
+  // Enumerate subspaces found by the partitioning algorithm. Subspaces are
+  // numbered in the order of appearance of their first basis state.
+  void init_subspaces(adaptive_disjoint_sets& ds) {
     ds.compress_sets();
     ds.normalize_sets();
 
-    root_to_subspace.clear();
-    for(sv_index_type n = 0; n < dim(); ++n) {
-      root_to_subspace.emplace(ds.find_root(n), root_to_subspace.size());
+    sv_index_type d = ds.size();
+    subspace_of = detail::adaptive_index_array(d, d == 0 ? 0 : d - 1);
+    subspace_sizes.clear();
+    subspace_sizes.reserve(ds.n_sets());
+    for(sv_index_type n = 0; n < d; ++n) {
+      sv_index_type root = ds.find_root(n);
+      if(root == n) {
+        subspace_of.set(n, subspace_sizes.size());
+        subspace_sizes.push_back(1);
+      } else {
+        sv_index_type subspace = subspace_of[root];
+        subspace_of.set(n, subspace);
+        ++subspace_sizes[subspace];
+      }
+    }
+  }
+
+  // Merge subspaces according to a partition of the set of subspaces.
+  // The merged subspaces are re-enumerated preserving their relative order.
+  void merge_subspaces_impl(adaptive_disjoint_sets& subspaces_ds) {
+    subspaces_ds.compress_sets();
+    subspaces_ds.normalize_sets();
+
+    std::vector<sv_index_type> new_subspace(n_subspaces());
+    std::vector<sv_index_type> new_subspace_sizes;
+    new_subspace_sizes.reserve(subspaces_ds.n_sets());
+    for(sv_index_type s = 0; s < n_subspaces(); ++s) {
+      sv_index_type root = subspaces_ds.find_root(s);
+      if(root == s) {
+        new_subspace[s] = new_subspace_sizes.size();
+        new_subspace_sizes.push_back(subspace_sizes[s]);
+      } else {
+        new_subspace[s] = new_subspace[root];
+        new_subspace_sizes[new_subspace[s]] += subspace_sizes[s];
+      }
     }
+
+    for(sv_index_type n = 0; n < dim(); ++n)
+      subspace_of.set(n, new_subspace[subspace_of[n]]);
+    subspace_sizes = std::move(new_subspace_sizes);
+  }
+
+  // Write `count` integers of a given width returned by `get(i)`
+  template <typename F>
+  static void write_indices(std::ostream& os,
+                            sv_index_type count,
+                            unsigned width,
+                            F&& get) {
+    if(width == 4)
+      write_indices_impl<std::uint32_t>(os, count, get);
+    else
+      write_indices_impl<std::uint64_t>(os, count, get);
+  }
+  template <typename IndexType, typename F>
+  static void
+  write_indices_impl(std::ostream& os, sv_index_type count, F& get) {
+    constexpr sv_index_type chunk_size = 1 << 16;
+    std::vector<IndexType> buffer;
+    buffer.reserve(std::min(count, chunk_size));
+    for(sv_index_type i = 0; i < count; i += chunk_size) {
+      buffer.clear();
+      for(sv_index_type j = i; j < std::min(count, i + chunk_size); ++j)
+        buffer.push_back(static_cast<IndexType>(get(j)));
+      os.write(reinterpret_cast<char const*>(buffer.data()),
+               buffer.size() * sizeof(IndexType));
+    }
+  }
+
+  // Read `count` integers of a given width and pass them to `set(i, value)`
+  template <typename F>
+  static void read_indices(std::istream& is,
+                           sv_index_type count,
+                           unsigned width,
+                           F&& set) {
+    if(width == 4)
+      read_indices_impl<std::uint32_t>(is, count, set);
+    else
+      read_indices_impl<std::uint64_t>(is, count, set);
+  }
+  template <typename IndexType, typename F>
+  static void read_indices_impl(std::istream& is, sv_index_type count, F& set) {
+    constexpr sv_index_type chunk_size = 1 << 16;
+    std::vector<IndexType> buffer;
+    for(sv_index_type i = 0; i < count; i += chunk_size) {
+      buffer.resize(std::min(count - i, chunk_size));
+      is.read(reinterpret_cast<char*>(buffer.data()),
+              buffer.size() * sizeof(IndexType));
+      for(std::size_t j = 0; j < buffer.size(); ++j)
+        set(i + j, buffer[j]);
+    }
+  }
+
+  // Read and check the header of a subspace file `path`
+  static bool read_header(std::string const& path,
+                          detail::subspace_file_header& header) {
+    std::ifstream is(path, std::ios::binary);
+    if(!is.read(reinterpret_cast<char*>(&header), sizeof(header)))
+      return false;
+    try {
+      detail::check_subspace_file_header(header, path);
+    } catch(std::runtime_error const&) {
+      return false;
+    }
+    return true;
+  }
+
+  // Pad a stream with zeros up to a given offset
+  static void pad_to(std::ostream& os, std::size_t offset) {
+    while(std::size_t(os.tellp()) < offset)
+      os.put(0);
+  }
+
+  template <typename ScalarType>
+  void save_impl(std::string const& path,
+                 std::uint64_t key,
+                 matrix_elements_map<ScalarType> const* me) const {
+    static_assert(std::is_trivially_copyable<ScalarType>::value,
+                  "Matrix elements must be of a trivially copyable type");
+
+    std::ofstream os(path, std::ios::binary | std::ios::trunc);
+    if(!os) throw std::runtime_error("Cannot open file '" + path + "'");
+
+    detail::subspace_file_layout layout{
+        dim(),
+        n_subspaces(),
+        detail::subspace_file_index_width(dim())};
+    auto header = detail::make_subspace_file_header(layout, key);
+    if(me != nullptr) {
+      header.n_matrix_elements = me->size();
+      header.scalar_size = sizeof(ScalarType);
+      header.scalar_kind = detail::subspace_file_scalar_kind<ScalarType>();
+    }
+    os.write(reinterpret_cast<char const*>(&header), sizeof(header));
+
+    write_indices(os, dim(), layout.index_width, [this](sv_index_type n) {
+      return subspace_of[n];
+    });
+    pad_to(os, layout.sizes_offset());
+    write_indices(os,
+                  n_subspaces(),
+                  layout.index_width,
+                  [this](sv_index_type s) { return subspace_sizes[s]; });
+    pad_to(os, layout.matrix_elements_offset());
+
+    if(me != nullptr) {
+      for(auto const& e : *me)
+        os.write(reinterpret_cast<char const*>(&e.first.first),
+                 sizeof(std::uint64_t));
+      for(auto const& e : *me)
+        os.write(reinterpret_cast<char const*>(&e.first.second),
+                 sizeof(std::uint64_t));
+      for(auto const& e : *me)
+        os.write(reinterpret_cast<char const*>(&e.second), sizeof(ScalarType));
+    }
+
+    if(!os) throw std::runtime_error("Cannot write file '" + path + "'");
+  }
+
+  template <typename ScalarType>
+  static space_partition load_impl(std::string const& path,
+                                   std::uint64_t key,
+                                   matrix_elements_map<ScalarType>* me) {
+    std::ifstream is(path, std::ios::binary);
+    if(!is) throw std::runtime_error("Cannot open file '" + path + "'");
+
+    detail::subspace_file_header header{};
+    if(!is.read(reinterpret_cast<char*>(&header), sizeof(header)))
+      throw std::runtime_error("File '" + path + "' is not a subspace file");
+    auto layout = detail::check_subspace_file_header(header, path);
+    if(header.key != key)
+      throw std::runtime_error("Key mismatch in subspace file '" + path + "'");
+
+    if(me != nullptr && !detail::has_subspace_file_scalar<ScalarType>(header))
+      throw std::runtime_error("Subspace file '" + path +
+                               "' contains no matrix elements of "
+                               "the requested type");
+
+    auto truncated = [&path]() {
+      return std::runtime_error("Subspace file '" + path + "' is truncated");
+    };
+    auto corrupted = [&path]() {
+      return std::runtime_error("Subspace file '" + path + "' is corrupted");
+    };
+
+    space_partition sp;
+    sv_index_type d = layout.dim;
+    sv_index_type n_subspaces = layout.n_subspaces;
+    sp.subspace_of = detail::adaptive_index_array(d, d == 0 ? 0 : d - 1);
+    bool valid = true;
+    read_indices(is,
+                 d,
+                 layout.index_width,
+                 [&](sv_index_type n, sv_index_type s) {
+                   if(s >= n_subspaces)
+                     valid = false;
+                   else
+                     sp.subspace_of.set(n, s);
+                 });
+    if(!is) throw truncated();
+    if(!valid) throw corrupted();
+
+    is.seekg(layout.sizes_offset());
+    sp.subspace_sizes.resize(n_subspaces);
+    sv_index_type total_size = 0;
+    read_indices(is,
+                 n_subspaces,
+                 layout.index_width,
+                 [&](sv_index_type s, sv_index_type size) {
+                   if(size > d) valid = false;
+                   sp.subspace_sizes[s] = size;
+                   total_size += size;
+                 });
+    if(!is) throw truncated();
+    if(!valid || total_size != d) throw corrupted();
+
+    if(me != nullptr) {
+      is.seekg(layout.matrix_elements_offset());
+      std::vector<std::uint64_t> out_index(header.n_matrix_elements);
+      std::vector<std::uint64_t> in_index(header.n_matrix_elements);
+      std::vector<ScalarType> values(header.n_matrix_elements);
+      is.read(reinterpret_cast<char*>(out_index.data()),
+              out_index.size() * sizeof(std::uint64_t));
+      is.read(reinterpret_cast<char*>(in_index.data()),
+              in_index.size() * sizeof(std::uint64_t));
+      is.read(reinterpret_cast<char*>(values.data()),
+              values.size() * sizeof(ScalarType));
+      me->clear();
+      for(std::size_t i = 0; i < values.size(); ++i)
+        me->emplace_hint(me->end(),
+                         std::make_pair(out_index[i], in_index[i]),
+                         values[i]);
+    }
+
+    if(!is) throw truncated();
+    return sp;
   }
 };
 
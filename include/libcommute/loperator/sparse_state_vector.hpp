@@ -14,20 +14,25 @@
 #define LIBCOMMUTE_LOPERATOR_SPARSE_STATE_VECTOR_HPP_
 
 #include "../scalar_traits.hpp"
+#include "flat_index_map.hpp"
 #include "state_vector.hpp"
 
 #include <cassert>
-#include <unordered_map>
+#include <cstddef>
 
 namespace libcommute {
 
 //
 // Implementation of the StateVector concept based on a sparse storage
 //
+// Non-zero amplitudes are stored in an open-addressing hash table. set_zeros()
+// keeps the allocated storage, so that a vector can be reused without
+// reallocations.
+//
 template <typename ScalarType> class sparse_state_vector {
 
   sv_index_type size_;
-  std::unordered_map<sv_index_type, ScalarType> data_;
+  flat_index_map<ScalarType> data_;
 
 public:
   sparse_state_vector() = delete;
@@ -39,6 +44,12 @@ public:
   // Number of non-zero amplitudes
   inline sv_index_type n_nonzeros() const { return data_.size(); }
 
+  // Number of amplitudes that can be stored without reallocating the storage
+  inline std::size_t capacity() const { return data_.capacity(); }
+
+  // Reserve storage for at least `n` non-zero amplitudes
+  inline void reserve(std::size_t n) { data_.reserve(n); }
+
   // Element access
   inline ScalarType& operator[](sv_index_type n) { return data_[n]; }
 
@@ -46,27 +57,27 @@ public:
   inline friend ScalarType get_element(sparse_state_vector const& sv,
                                        sv_index_type n) {
     assert(n < sv.size_);
-    auto it = sv.data_.find(n);
-    if(it == sv.data_.end())
+    auto const* a = sv.data_.find(n);
+    if(a == nullptr)
       return scalar_traits<ScalarType>::make_const(0);
     else
-      return it->second;
+      return *a;
   }
 
   // Add a constant to the n-th state amplitude
   template <typename T>
   inline friend void
   update_add_element(sparse_state_vector& sv, sv_index_type n, T&& value) {
-    auto it = sv.data_.find(n);
-    if(it == sv.data_.end()) {
-      if(!scalar_traits<ScalarType>::is_zero(value)) sv.data_[n] = value;
+    auto* a = sv.data_.find(n);
+    if(a == nullptr) {
+      if(!is_zero_amplitude<ScalarType>(value)) sv.data_[n] = value;
     } else {
-      it->second += value;
-      if(scalar_traits<ScalarType>::is_zero(it->second)) sv.data_.erase(it);
+      *a += value;
+      if(is_zero_amplitude<ScalarType>(*a)) sv.data_.erase(n);
     }
   }
 
-  // Set all amplitudes to zero
+  // Set all amplitudes to zero, the allocated storage is retained
   inline friend void set_zeros(sparse_state_vector& sv) { sv.data_.clear(); }
 
   // Make an empty vector with the same Hilbert space dimension
@@ -77,28 +88,20 @@ public:
   // Apply functor `f` to all index/non-zero amplitude pairs
   template <typename Functor>
   inline friend void foreach(sparse_state_vector const& sv, Functor&& f) {
-    for(auto const& p : sv.data_)
-      f(p.first, p.second);
+    sv.data_.foreach(f);
   }
 
   // Force removal of all zero amplitudes from the storage
   inline void prune() {
-    for(auto it = data_.begin(); it != data_.end();) {
-      if(scalar_traits<ScalarType>::is_zero(it->second))
-        it = data_.erase(it);
-      else
-        ++it;
-    }
+    data_.erase_if([](sv_index_type, ScalarType const& a) {
+      return is_zero_amplitude<ScalarType>(a);
+    });
   }
 
   // Force removal of all amplitudes meeting a specified criterion
   template <typename UnaryPredicate> inline void prune(UnaryPredicate&& p) {
-    for(auto it = data_.begin(); it != data_.end();) {
-      if(p(it->second))
-        it = data_.erase(it);
-      else
-        ++it;
-    }
+    data_.erase_if(
+        [&p](sv_index_type, ScalarType const& a) -> bool { return p(a); });
   }
 };
 
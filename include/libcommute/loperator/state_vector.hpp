@@ -24,6 +24,30 @@ namespace libcommute {
 // Type of index into a state vector
 using sv_index_type = std::uint64_t;
 
+// Zero test for state amplitudes of type T. Single precision amplitudes
+// usually store results of double precision computations, and they are
+// compared to zero with the tolerance of their accumulator type.
+template <typename T> inline bool is_zero_amplitude(T const& a) {
+  using acc_type = accumulator_type_t<T>;
+  acc_type const& acc = a;
+  return scalar_traits<acc_type>::is_zero(acc);
+}
+
+namespace detail {
+
+// Bijective mixing function (finalizer of the SplitMix64 generator) used to
+// hash state vector indices
+inline std::uint64_t mix_hash(std::uint64_t x) {
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+  return x;
+}
+
+} // namespace detail
+
 //
 // Implementation of the StateVector interface for std::vector
 //
@@ -69,7 +93,7 @@ template <typename T, typename Functor>
 inline void foreach(std::vector<T> const& sv, Functor&& f) {
   for(sv_index_type n = 0; n < sv.size(); ++n) {
     auto const& a = sv[n];
-    if(scalar_traits<T>::is_zero(a))
+    if(is_zero_amplitude<T>(a))
       continue;
     else
       f(n, a);
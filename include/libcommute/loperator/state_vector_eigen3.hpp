@@ -130,7 +130,7 @@ inline void foreach(Eigen::DenseBase<Derived> const& sv, Functor&& f) {
   sv_index_type size = sv.size();
   for(sv_index_type n = 0; n < size; ++n) {
     auto const& a = sv(n);
-    if(scalar_traits<ScalarType>::is_zero(a))
+    if(is_zero_amplitude<ScalarType>(a))
       continue;
     else
       f(n, a);
@@ -168,7 +168,7 @@ foreach(Eigen::Block<XprType, BlockRows, Eigen::Dynamic, InnerPanel> const& sv,
   sv_index_type size = sv.rows();
   for(sv_index_type n = 0; n < size; ++n) {
     auto const& a = sv(n, 0);
-    if(scalar_traits<ScalarType>::is_zero(a))
+    if(is_zero_amplitude<ScalarType>(a))
       continue;
     else
       f(n, a);
@@ -0,0 +1,176 @@
+/*******************************************************************************
+ *
+ * This file is part of libcommute, a quantum operator algebra DSL and
+ * exact diagonalization toolkit for C++11/14/17.
+ *
+ * Copyright (C) 2016-2021 Igor Krivenko <igor.s.krivenko@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ ******************************************************************************/
+#ifndef LIBCOMMUTE_LOPERATOR_SUBSPACE_FILE_HPP_
+#define LIBCOMMUTE_LOPERATOR_SUBSPACE_FILE_HPP_
+
+#include "../expression/expression.hpp"
+#include "../scalar_traits.hpp"
+#include "hilbert_space.hpp"
+#include "state_vector.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+//
+// Binary file format used to store results of Hilbert space partitioning
+//
+// All sections of a subspace file are 8-byte aligned, and integers are
+// stored in the native byte order so that the file can be memory-mapped.
+//
+// 1. Header (subspace_file_header).
+// 2. Subspace serial numbers of all basis states ('dim' integers of width
+//    'index_width').
+// 3. Sizes of all subspaces ('n_subspaces' integers of width 'index_width').
+// 4. Optional matrix elements: 'n_matrix_elements' 64-bit indices of final
+//    states, 'n_matrix_elements' 64-bit indices of initial states, and
+//    'n_matrix_elements' values of kind 'scalar_kind' and size 'scalar_size'.
+//
+
+namespace libcommute {
+
+namespace detail {
+
+// Header of a subspace file
+struct subspace_file_header {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t index_width;
+  std::uint64_t dim;
+  std::uint64_t n_subspaces;
+  std::uint64_t key;
+  std::uint64_t n_matrix_elements;
+  std::uint32_t scalar_size;
+  std::uint32_t scalar_kind;
+};
+
+constexpr char subspace_file_magic[8] = {'L', 'C', 'S', 'P', 'A', 'R', 'T', 0};
+constexpr std::uint32_t subspace_file_version = 2;
+
+// Kinds of matrix element values stored in a subspace file
+constexpr std::uint32_t subspace_file_no_scalar = 0;
+constexpr std::uint32_t subspace_file_integer_scalar = 1;
+constexpr std::uint32_t subspace_file_real_scalar = 2;
+constexpr std::uint32_t subspace_file_complex_scalar = 3;
+constexpr std::uint32_t subspace_file_other_scalar = 4;
+
+// Kind of matrix element values of type ScalarType
+template <typename ScalarType>
+constexpr std::uint32_t subspace_file_scalar_kind() {
+  return is_complex<ScalarType>::value ?
+             subspace_file_complex_scalar :
+             (std::is_floating_point<ScalarType>::value ?
+                  subspace_file_real_scalar :
+                  (std::is_integral<ScalarType>::value ?
+                       subspace_file_integer_scalar :
+                       subspace_file_other_scalar));
+}
+
+// Does a subspace file contain matrix elements of type ScalarType?
+template <typename ScalarType>
+inline bool has_subspace_file_scalar(subspace_file_header const& header) {
+  return header.scalar_kind == subspace_file_scalar_kind<ScalarType>() &&
+         header.scalar_size == sizeof(ScalarType);
+}
+
+// Offsets of sections within a subspace file
+struct subspace_file_layout {
+  sv_index_type dim;
+  sv_index_type n_subspaces;
+  unsigned index_width;
+
+  static std::size_t align(std::size_t offset) { return (offset + 7) / 8 * 8; }
+
+  static constexpr std::size_t table_offset() {
+    return sizeof(subspace_file_header);
+  }
+  std::size_t sizes_offset() const {
+    return align(table_offset() + dim * index_width);
+  }
+  std::size_t matrix_elements_offset() const {
+    return align(sizes_offset() + n_subspaces * index_width);
+  }
+};
+
+// Make a header of a subspace file
+inline subspace_file_header
+make_subspace_file_header(subspace_file_layout const& layout,
+                          std::uint64_t key) {
+  subspace_file_header header{};
+  std::memcpy(header.magic, subspace_file_magic, sizeof(header.magic));
+  header.version = subspace_file_version;
+  header.index_width = layout.index_width;
+  header.dim = layout.dim;
+  header.n_subspaces = layout.n_subspaces;
+  header.key = key;
+  return header;
+}
+
+// Check that a header describes a valid subspace file
+inline subspace_file_layout
+check_subspace_file_header(subspace_file_header const& header,
+                           std::string const& path) {
+  if(std::memcmp(header.magic, subspace_file_magic, sizeof(header.magic)) != 0)
+    throw std::runtime_error("File '" + path + "' is not a subspace file");
+  if(header.version != subspace_file_version)
+    throw std::runtime_error("Unsupported version of subspace file '" + path +
+                             "'");
+  if(header.index_width != 4 && header.index_width != 8)
+    throw std::runtime_error("Unsupported index width in subspace file '" +
+                             path + "'");
+  if(header.n_subspaces > header.dim)
+    throw std::runtime_error("Invalid number of subspaces in subspace file '" +
+                             path + "'");
+  return {header.dim, header.n_subspaces, header.index_width};
+}
+
+// Width of integers used to store subspace serial numbers
+inline unsigned subspace_file_index_width(sv_index_type dim) {
+  if(dim <= sv_index_type(std::numeric_limits<std::uint32_t>::max()))
+    return 4;
+  else
+    return 8;
+}
+
+// 64-bit FNV-1a hash of a string
+inline std::uint64_t fnv1a_hash(std::string const& str) {
+  std::uint64_t hash = 0xcbf29ce484222325ULL;
+  for(char c : str) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+} // namespace detail
+
+// Compute a key identifying the partition of Hilbert space `hs` generated by
+// operator `expr`. The key is a hash of the textual representations of `expr`
+// (coefficients printed with full precision) and of `hs`.
+template <typename ScalarType, typename... IndexTypes>
+std::uint64_t partition_key(expression<ScalarType, IndexTypes...> const& expr,
+                            hilbert_space<IndexTypes...> const& hs) {
+  std::ostringstream ss;
+  ss.precision(std::numeric_limits<double>::max_digits10);
+  ss << expr << '\n' << hs;
+  return detail::fnv1a_hash(ss.str());
+}
+
+} // namespace libcommute
+
+#endif
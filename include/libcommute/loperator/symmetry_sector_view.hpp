@@ -0,0 +1,775 @@
+/*******************************************************************************
+ *
+ * This file is part of libcommute, a quantum operator algebra DSL and
+ * exact diagonalization toolkit for C++11/14/17.
+ *
+ * Copyright (C) 2016-2021 Igor Krivenko <igor.s.krivenko@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ ******************************************************************************/
+#ifndef LIBCOMMUTE_LOPERATOR_SYMMETRY_SECTOR_VIEW_HPP_
+#define LIBCOMMUTE_LOPERATOR_SYMMETRY_SECTOR_VIEW_HPP_
+
+#include "../algebra_ids.hpp"
+#include "../scalar_traits.hpp"
+#include "../utility.hpp"
+
+#include "elementary_space.hpp"
+#include "hilbert_space.hpp"
+#include "n_fermion_sector_view.hpp"
+#include "state_vector.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <memory>
+#include <numeric>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace libcommute {
+
+//
+// Permutation of elementary spaces
+//
+
+// Unitary transformation T of a Hilbert space that maps each elementary space
+// onto another elementary space of the same kind, such as a translation of
+// a lattice by one site. T maps basis states onto basis states, possibly
+// changing the sign of a basis state when fermionic modes are reordered.
+class space_permutation {
+
+  // Elementary space i is mapped onto elementary space permutation_[i]
+  std::vector<int> permutation_;
+
+  // Number of bytes up to the most significant bit of an index
+  unsigned int n_bytes_;
+
+  // Permuted bits, table_[c * 256 + v] for byte value v at byte position c
+  std::vector<sv_index_type> table_;
+
+  // Pairs (bit b of a fermionic mode, mask of fermionic modes above b that are
+  // mapped below the image of b). Each occupied pair of such modes changes
+  // the sign of a basis state.
+  std::vector<std::pair<unsigned int, sv_index_type>> fermion_inversions_;
+
+  // Target position of each bit of a basis state index
+  std::vector<unsigned int> target_;
+
+  // Bits corresponding to fermionic modes
+  sv_index_type fermion_mask_ = 0;
+
+  space_permutation(std::vector<int> permutation,
+                    std::vector<unsigned int> target,
+                    sv_index_type fermion_mask)
+    : permutation_(std::move(permutation)),
+      target_(std::move(target)),
+      fermion_mask_(fermion_mask) {
+    init();
+  }
+
+  // Fill the lookup tables and the list of fermionic inversions
+  void init() {
+    unsigned int n_bits = target_.size();
+    n_bytes_ = (n_bits + 7) / 8;
+    table_.resize(std::size_t(n_bytes_) << 8);
+    for(unsigned int c = 0; c < n_bytes_; ++c) {
+      for(sv_index_type v = 0; v < 256; ++v) {
+        sv_index_type permuted = 0;
+        for(unsigned int b = 0; b < 8 && 8 * c + b < n_bits; ++b) {
+          if((v >> b) & 1) permuted |= detail::pow2(target_[8 * c + b]);
+        }
+        table_[(c << 8) + v] = permuted;
+      }
+    }
+
+    for(unsigned int b1 = 0; b1 < n_bits; ++b1) {
+      if(!((fermion_mask_ >> b1) & 1)) continue;
+      sv_index_type mask = 0;
+      for(unsigned int b2 = b1 + 1; b2 < n_bits; ++b2) {
+        if(((fermion_mask_ >> b2) & 1) && target_[b2] < target_[b1])
+          mask |= detail::pow2(b2);
+      }
+      if(mask != 0) fermion_inversions_.emplace_back(b1, mask);
+    }
+  }
+
+public:
+  // Construct a permutation of elementary spaces of 'hs'. The elementary space
+  // with linear index i (as returned by hs.index()) is mapped onto
+  // the elementary space with linear index permutation[i]. Both elementary
+  // spaces must have the same algebra ID and dimension.
+  template <typename... IndexTypes>
+  space_permutation(hilbert_space<IndexTypes...> const& hs,
+                    std::vector<int> permutation)
+    : permutation_(std::move(permutation)) {
+    using es_type = elementary_space<IndexTypes...>;
+
+    std::vector<es_type const*> spaces;
+    std::vector<bit_range_t> ranges;
+    hs.for_each_elementary_space(
+        [&](es_type const& es, bit_range_t const& range) {
+          spaces.push_back(&es);
+          ranges.push_back(range);
+        });
+
+    if(permutation_.size() != spaces.size())
+      throw std::invalid_argument(
+          "Permutation must have " + std::to_string(spaces.size()) +
+          " elements");
+    std::vector<bool> is_image(spaces.size(), false);
+    for(std::size_t i = 0; i < spaces.size(); ++i) {
+      int j = permutation_[i];
+      if(j < 0 || std::size_t(j) >= spaces.size() || is_image[j])
+        throw std::invalid_argument("Invalid permutation of elementary spaces");
+      is_image[j] = true;
+      if(spaces[i]->algebra_id() != spaces[j]->algebra_id() ||
+         spaces[i]->dim() != spaces[j]->dim() ||
+         spaces[i]->n_bits() != spaces[j]->n_bits())
+        throw std::invalid_argument(
+            "Elementary spaces " + std::to_string(i) + " and " +
+            std::to_string(j) + " cannot be mapped onto each other");
+    }
+
+    // Target position of each bit
+    target_.resize(hs.total_n_bits());
+    for(std::size_t i = 0; i < spaces.size(); ++i) {
+      auto const& r = ranges[i];
+      auto const& r_image = ranges[permutation_[i]];
+      for(int b = r.first; b <= r.second; ++b)
+        target_[b] = r_image.first + (b - r.first);
+    }
+
+    if(hs.has_algebra(fermion)) {
+      auto const& r = hs.algebra_bit_range(fermion);
+      for(int b = r.first; b <= r.second; ++b)
+        fermion_mask_ |= detail::pow2(b);
+    }
+
+    init();
+  }
+
+  // Transformation T^j
+  space_permutation power(unsigned int j) const {
+    std::vector<int> permutation(permutation_.size());
+    std::iota(permutation.begin(), permutation.end(), 0);
+    std::vector<unsigned int> target(target_.size());
+    std::iota(target.begin(), target.end(), 0);
+    for(unsigned int n = 0; n < j; ++n) {
+      for(auto& i : permutation)
+        i = permutation_[i];
+      for(auto& b : target)
+        b = target_[b];
+    }
+    return space_permutation(std::move(permutation),
+                             std::move(target),
+                             fermion_mask_);
+  }
+
+  // Linear indices of the images of all elementary spaces
+  std::vector<int> const& permutation() const { return permutation_; }
+
+  // Smallest positive integer L such that T^L is the identity
+  unsigned int order() const {
+    unsigned int L = 1;
+    std::vector<bool> visited(permutation_.size(), false);
+    for(std::size_t i = 0; i < permutation_.size(); ++i) {
+      unsigned int cycle_length = 0;
+      for(std::size_t j = i; !visited[j]; j = permutation_[j]) {
+        visited[j] = true;
+        ++cycle_length;
+      }
+      if(cycle_length > 0) {
+        unsigned int a = L, b = cycle_length;
+        while(b != 0) {
+          unsigned int t = a % b;
+          a = b;
+          b = t;
+        }
+        L = L / a * cycle_length;
+      }
+    }
+    return L;
+  }
+
+  // Index of the basis state T|index> (up to a sign)
+  inline sv_index_type operator()(sv_index_type index) const {
+    sv_index_type result = 0;
+    for(unsigned int c = 0; c < n_bytes_; ++c) {
+      result |= table_[(c << 8) + (index & 0xFF)];
+      index >>= 8;
+    }
+    return result;
+  }
+
+  // Sign s in T|index> = s|operator()(index)>, +1 or -1
+  inline int sign(sv_index_type index) const {
+    unsigned int parity = 0;
+    for(auto const& inv : fermion_inversions_) {
+      if((index >> inv.first) & 1)
+        parity += detail::popcount(index & inv.second);
+    }
+    return (parity & 1) ? -1 : 1;
+  }
+};
+
+//
+// Symmetry transformation of basis states
+//
+
+// Unitary transformation g = Z F T of a Hilbert space that maps basis states
+// onto basis states up to a sign.
+// - T is a permutation of elementary spaces (lattice translation, reflection,
+//   rotation, etc).
+// - F reverses the order of basis states, n -> d - 1 - n, in a subset of
+//   elementary spaces. For spins this is the spin flip m -> -m. For fermionic
+//   modes i_1 < i_2 < ... it is the particle-hole transformation
+//   F = (c_{i_1} + c^\dagger_{i_1}) (c_{i_2} + c^\dagger_{i_2}) \ldots
+// - Z = \prod_i (-1)^{n_i} is a product of local parity operators over another
+//   subset of elementary spaces, such as a sublattice.
+class basis_symmetry {
+
+  // Permutation of elementary spaces
+  space_permutation permutation_;
+
+  // Bits of flipped elementary spaces whose dimension is a power of 2
+  sv_index_type flip_xor_mask_ = 0;
+
+  // Flipped elementary spaces whose dimension is not a power of 2:
+  // Shift, mask and dimension minus 1
+  struct reversed_space {
+    unsigned int shift;
+    sv_index_type mask;
+    sv_index_type max_n;
+  };
+  std::vector<reversed_space> reversed_spaces_;
+
+  // Fermionic modes with an odd number of flipped fermionic modes above them.
+  // Every occupied such mode changes the sign of a basis state under F.
+  sv_index_type flip_sign_mask_ = 0;
+
+  // Lowest bits of elementary spaces contributing to Z
+  sv_index_type parity_mask_ = 0;
+
+public:
+  // Construct a symmetry transformation that only permutes elementary spaces
+  explicit basis_symmetry(space_permutation permutation)
+    : permutation_(std::move(permutation)) {}
+
+  // Construct a symmetry transformation of basis states of 'hs'.
+  // The elementary space with linear index i is mapped onto the one with
+  // linear index permutation[i] (an empty 'permutation' stands for
+  // the identity). Elements of 'flipped_spaces' and 'parity_spaces' are
+  // linear indices of elementary spaces after the permutation.
+  template <typename... IndexTypes>
+  basis_symmetry(hilbert_space<IndexTypes...> const& hs,
+                 std::vector<int> permutation,
+                 std::vector<int> const& flipped_spaces = {},
+                 std::vector<int> const& parity_spaces = {})
+    : permutation_(hs,
+                   permutation.empty() ? identity_permutation(hs)
+                                       : std::move(permutation)) {
+    using es_type = elementary_space<IndexTypes...>;
+
+    std::vector<es_type const*> spaces;
+    std::vector<bit_range_t> ranges;
+    hs.for_each_elementary_space(
+        [&](es_type const& es, bit_range_t const& range) {
+          spaces.push_back(&es);
+          ranges.push_back(range);
+        });
+
+    auto check_index = [&](int i) {
+      if(i < 0 || std::size_t(i) >= spaces.size())
+        throw std::invalid_argument("Invalid elementary space index " +
+                                    std::to_string(i));
+    };
+
+    std::vector<bool> is_flipped(spaces.size(), false);
+    for(int i : flipped_spaces) {
+      check_index(i);
+      if(is_flipped[i])
+        throw std::invalid_argument("Elementary space " + std::to_string(i) +
+                                    " is flipped more than once");
+      is_flipped[i] = true;
+
+      auto const& r = ranges[i];
+      unsigned int n_bits = r.second - r.first + 1;
+      sv_index_type mask = (detail::pow2(n_bits) - 1) << r.first;
+      if(spaces[i]->dim() == detail::pow2(n_bits))
+        flip_xor_mask_ |= mask;
+      else
+        reversed_spaces_.push_back(
+            {static_cast<unsigned int>(r.first),
+             mask,
+             static_cast<sv_index_type>(spaces[i]->dim() - 1)});
+
+      if(spaces[i]->algebra_id() == fermion) {
+        auto const& rf = hs.algebra_bit_range(fermion);
+        for(int b = rf.first; b < r.first; ++b)
+          flip_sign_mask_ ^= detail::pow2(b);
+      }
+    }
+
+    for(int i : parity_spaces) {
+      check_index(i);
+      parity_mask_ ^= detail::pow2(ranges[i].first);
+    }
+  }
+
+  // Permutation of elementary spaces T
+  space_permutation const& permutation() const { return permutation_; }
+
+  // Is this the identity transformation?
+  bool is_identity() const {
+    auto const& p = permutation_.permutation();
+    for(std::size_t i = 0; i < p.size(); ++i) {
+      if(p[i] != int(i)) return false;
+    }
+    return flip_xor_mask_ == 0 && reversed_spaces_.empty() &&
+           parity_mask_ == 0;
+  }
+
+  // Index of the basis state g|index> and the sign s in
+  // g|index> = s|operator()(index, s)>
+  inline sv_index_type operator()(sv_index_type index, int& sign) const {
+    sv_index_type result = permutation_(index);
+    unsigned int parity = (permutation_.sign(index) == 1 ? 0 : 1) +
+                          detail::popcount(result & flip_sign_mask_);
+    result ^= flip_xor_mask_;
+    for(auto const& s : reversed_spaces_) {
+      sv_index_type n = (result & s.mask) >> s.shift;
+      result = (result & ~s.mask) | ((s.max_n - n) << s.shift);
+    }
+    parity += detail::popcount(result & parity_mask_);
+    sign = (parity & 1) ? -1 : 1;
+    return result;
+  }
+
+  // Index of the basis state g|index> (up to a sign)
+  inline sv_index_type operator()(sv_index_type index) const {
+    int sign;
+    return operator()(index, sign);
+  }
+
+  // Sign s in g|index> = s|operator()(index)>, +1 or -1
+  inline int sign(sv_index_type index) const {
+    int sign;
+    operator()(index, sign);
+    return sign;
+  }
+
+private:
+  template <typename... IndexTypes>
+  static std::vector<int>
+  identity_permutation(hilbert_space<IndexTypes...> const& hs) {
+    std::vector<int> permutation(hs.size());
+    std::iota(permutation.begin(), permutation.end(), 0);
+    return permutation;
+  }
+};
+
+//
+// Symmetry sector
+//
+
+// Subspace of a Hilbert space transforming according to a one-dimensional
+// irreducible representation \chi of a finite symmetry group G.
+// The subspace is spanned by states
+//
+// $$
+//   |a_\chi\rangle = \frac{1}{\sqrt{N_a}}
+//                    \sum_{g\in G} \chi^*(g) g |a\rangle,
+// $$
+//
+// where the representative |a> is the basis state with the smallest index
+// within its orbit {g|a>}, and N_a = |G|^2 / R_a with R_a being the orbit
+// size. Representatives with a vanishing |a_\chi> are excluded.
+class symmetry_sector {
+
+  // Elements of the group
+  std::vector<basis_symmetry> group_;
+
+  // Characters of the group elements
+  std::vector<std::complex<double>> characters_;
+
+  // Sorted list of representatives
+  std::vector<sv_index_type> representatives_;
+
+  // Orbit sizes R_a of the representatives
+  std::vector<unsigned int> orbit_sizes_;
+
+  // 1 / \sqrt{R_a}
+  std::vector<double> inv_sqrt_orbit_sizes_;
+
+public:
+  // Construct a symmetry sector from a list of all group elements, their
+  // characters \chi(g) and a list of basis states invariant under the group.
+  // Characters of a one-dimensional representation are complex numbers of
+  // unit modulus.
+  symmetry_sector(std::vector<basis_symmetry> group,
+                  std::vector<std::complex<double>> characters,
+                  std::vector<sv_index_type> const& basis_states)
+    : group_(std::move(group)), characters_(std::move(characters)) {
+    if(group_.empty())
+      throw std::invalid_argument("Symmetry group must not be empty");
+    if(characters_.size() != group_.size())
+      throw std::invalid_argument("Expected " + std::to_string(group_.size()) +
+                                  " characters");
+    for(auto const& chi : characters_) {
+      if(std::abs(std::abs(chi) - 1) > 1e-10)
+        throw std::invalid_argument(
+            "Characters of a one-dimensional representation must have "
+            "unit modulus");
+    }
+    check_group();
+
+    for(auto index : basis_states) {
+      unsigned int stabilizer_size = 0;
+      bool is_representative = true;
+      for(std::size_t g = 0; g < group_.size(); ++g) {
+        int sign;
+        sv_index_type x = group_[g](index, sign);
+        if(x < index) {
+          is_representative = false;
+          break;
+        }
+        if(x == index) {
+          // g|a> = sign|a> for g from the stabilizer of |a>, and |a_\chi> is
+          // non-vanishing iff \chi(g) = sign for all such g
+          if(std::abs(characters_[g] - double(sign)) > 1e-10) {
+            is_representative = false;
+            break;
+          }
+          ++stabilizer_size;
+        }
+      }
+      if(!is_representative) continue;
+      representatives_.push_back(index);
+      orbit_sizes_.push_back(group_.size() / stabilizer_size);
+    }
+
+    // Sort representatives
+    std::vector<std::size_t> order(representatives_.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [this](std::size_t a, std::size_t b) {
+      return representatives_[a] < representatives_[b];
+    });
+    std::vector<sv_index_type> representatives(order.size());
+    std::vector<unsigned int> orbit_sizes(order.size());
+    inv_sqrt_orbit_sizes_.resize(order.size());
+    for(std::size_t n = 0; n < order.size(); ++n) {
+      representatives[n] = representatives_[order[n]];
+      orbit_sizes[n] = orbit_sizes_[order[n]];
+      inv_sqrt_orbit_sizes_[n] = 1.0 / std::sqrt(double(orbit_sizes[n]));
+    }
+    representatives_ = std::move(representatives);
+    orbit_sizes_ = std::move(orbit_sizes);
+  }
+
+  // Elements of the group
+  std::vector<basis_symmetry> const& group() const { return group_; }
+
+  // Characters of the group elements
+  std::vector<std::complex<double>> const& characters() const {
+    return characters_;
+  }
+
+  // Are all characters real?
+  bool real_characters() const {
+    return std::all_of(characters_.begin(),
+                       characters_.end(),
+                       [](std::complex<double> const& chi) {
+                         return std::abs(chi.imag()) < 1e-10;
+                       });
+  }
+
+  // Dimension of the symmetry sector
+  sv_index_type size() const { return representatives_.size(); }
+
+  // Representative |a> of the n-th basis state |a_\chi>
+  sv_index_type representative(sv_index_type n) const {
+    return representatives_[n];
+  }
+
+  // Orbit size R_a of the n-th representative
+  unsigned int orbit_size(sv_index_type n) const { return orbit_sizes_[n]; }
+
+  // 1 / \sqrt{R_a} for the n-th representative
+  double inv_sqrt_orbit_size(sv_index_type n) const {
+    return inv_sqrt_orbit_sizes_[n];
+  }
+
+  // Find the basis state |a_\chi> of the symmetry sector that contains
+  // the basis state |index>. Returns the serial number n of |a_\chi>, or
+  // size() if there is no such state. Upon success, g|index> = sign|a>, where
+  // g is the group element number 'element'.
+  sv_index_type
+  find(sv_index_type index, std::size_t& element, int& sign) const {
+    sv_index_type a = ~sv_index_type(0);
+    for(std::size_t g = 0; g < group_.size(); ++g) {
+      int s;
+      sv_index_type x = group_[g](index, s);
+      if(x < a) {
+        a = x;
+        element = g;
+        sign = s;
+      }
+    }
+    auto it = std::lower_bound(representatives_.begin(),
+                               representatives_.end(),
+                               a);
+    if(it == representatives_.end() || *it != a) return size();
+    return it - representatives_.begin();
+  }
+
+private:
+  // Check that the group contains the identity transformation with
+  // \chi = 1, and that permutations of elementary spaces are closed under
+  // composition
+  void check_group() const {
+    auto identity = std::find_if(group_.begin(),
+                                 group_.end(),
+                                 [](basis_symmetry const& g) {
+                                   return g.is_identity();
+                                 });
+    if(identity == group_.end())
+      throw std::invalid_argument(
+          "Symmetry group must contain the identity transformation");
+    if(std::abs(characters_[identity - group_.begin()] - 1.0) > 1e-10)
+      throw std::invalid_argument(
+          "Character of the identity transformation must be 1");
+
+    std::set<std::vector<int>> permutations;
+    for(auto const& g : group_)
+      permutations.insert(g.permutation().permutation());
+    std::vector<int> product;
+    for(auto const& p1 : permutations) {
+      for(auto const& p2 : permutations) {
+        product.resize(p2.size());
+        for(std::size_t i = 0; i < p2.size(); ++i)
+          product[i] = p1[p2[i]];
+        if(permutations.count(product) == 0)
+          throw std::invalid_argument(
+              "Permutations of elementary spaces do not form a group");
+      }
+    }
+  }
+};
+
+// Make a shared symmetry sector
+inline std::shared_ptr<symmetry_sector const>
+make_symmetry_sector(std::vector<basis_symmetry> group,
+                     std::vector<std::complex<double>> characters,
+                     std::vector<sv_index_type> const& basis_states) {
+  return std::make_shared<symmetry_sector const>(std::move(group),
+                                                 std::move(characters),
+                                                 basis_states);
+}
+
+namespace detail {
+
+// Complex number converted to a complex scalar type
+template <typename T>
+T make_character(std::complex<double> const& chi, std::true_type) {
+  return T(chi.real(), chi.imag());
+}
+// Complex number converted to a real scalar type (its imaginary part must be
+// zero)
+template <typename T>
+T make_character(std::complex<double> const& chi, std::false_type) {
+  return scalar_traits<T>::make_const(chi.real());
+}
+
+} // namespace detail
+
+// View of a state vector in a symmetry sector. Elements of the adapted state
+// vector are amplitudes of the states |a_\chi>.
+//
+// The view translates operations on basis states of the full Hilbert space as
+// follows.
+// - get_element(view, index) returns the amplitude of |index>.
+// - update_add_element(view, index, value) adds value|index> projected onto
+//   the symmetry sector.
+// - foreach(view, f) visits the representatives |a> only. Each amplitude is
+//   multiplied by the orbit size R_a. A symmetric operator acting on such
+//   a view yields the same result as if it acted on the full state vector.
+template <typename StateVector, bool Ref = true> struct symmetry_sector_view {
+
+  // The underlying state vector
+  typename std::conditional<Ref, StateVector&, StateVector>::type state_vector;
+
+  // Symmetry sector
+  std::shared_ptr<symmetry_sector const> sector;
+
+  using scalar_type = typename element_type<
+      typename std::remove_const<StateVector>::type>::type;
+
+  // Characters \chi(g) converted to scalar_type
+  std::vector<scalar_type> characters;
+
+  template <typename SV>
+  symmetry_sector_view(SV&& sv, std::shared_ptr<symmetry_sector const> sector)
+    : state_vector(std::forward<SV>(sv)), sector(std::move(sector)) {
+    if(!is_complex<scalar_type>::value && !this->sector->real_characters())
+      throw std::invalid_argument("Symmetry sectors with complex characters "
+                                  "require complex amplitudes");
+    characters.reserve(this->sector->characters().size());
+    for(auto const& chi : this->sector->characters()) {
+      characters.push_back(detail::make_character<scalar_type>(
+          chi,
+          std::integral_constant<bool, is_complex<scalar_type>::value>()));
+    }
+  }
+
+  // Serial number of the state |a_\chi> containing a given basis state, or
+  // sector->size() if there is no such state
+  sv_index_type map_index(sv_index_type index) const {
+    std::size_t element;
+    int sign;
+    return sector->find(index, element, sign);
+  }
+
+  // Representative of the n-th state |a_\chi>
+  sv_index_type inverse_map_index(sv_index_type n) const {
+    return sector->representative(n);
+  }
+};
+
+// Get element type of the StateVector object adapted by a given
+// symmetry_sector_view object.
+template <typename StateVector, bool Ref>
+struct element_type<symmetry_sector_view<StateVector, Ref>> {
+  using type = typename symmetry_sector_view<StateVector>::scalar_type;
+};
+
+// Amplitude of a basis state 'index' in the full Hilbert space
+template <typename StateVector, bool Ref>
+inline auto get_element(symmetry_sector_view<StateVector, Ref> const& view,
+                        sv_index_type index) ->
+    typename symmetry_sector_view<StateVector>::scalar_type {
+  using T = typename symmetry_sector_view<StateVector>::scalar_type;
+  std::size_t element;
+  int sign;
+  sv_index_type n = view.sector->find(index, element, sign);
+  if(n == view.sector->size()) return scalar_traits<T>::make_const(0);
+  return get_element(view.state_vector, n) * view.characters[element] *
+         (sign * view.sector->inv_sqrt_orbit_size(n));
+}
+
+// Add value|index> projected onto the symmetry sector
+template <typename StateVector, bool Ref, typename T>
+inline void update_add_element(symmetry_sector_view<StateVector, Ref>& view,
+                               sv_index_type index,
+                               T&& value) {
+  using S = typename symmetry_sector_view<StateVector>::scalar_type;
+  std::size_t element;
+  int sign;
+  sv_index_type n = view.sector->find(index, element, sign);
+  if(n == view.sector->size()) return;
+  update_add_element(view.state_vector,
+                     n,
+                     std::forward<T>(value) *
+                         scalar_traits<S>::conj(view.characters[element]) *
+                         (sign * view.sector->inv_sqrt_orbit_size(n)));
+}
+
+// update_add_element() is not defined for constant views
+template <typename StateVector, bool Ref, typename T>
+inline void update_add_element(symmetry_sector_view<StateVector const, Ref>&,
+                               sv_index_type,
+                               T&&) {
+  static_assert(!std::is_same<StateVector, StateVector>::value,
+                "update_add_element() is not supported for constant views");
+}
+
+// zeros_like() is not defined for views
+template <typename StateVector, bool Ref>
+inline StateVector zeros_like(symmetry_sector_view<StateVector, Ref> const&) {
+  static_assert(!std::is_same<StateVector, StateVector>::value,
+                "zeros_like() is not supported for views");
+}
+
+// Set all amplitudes stored in the adapted StateVector object to zero
+template <typename StateVector, bool Ref>
+inline void set_zeros(symmetry_sector_view<StateVector, Ref>& view) {
+  set_zeros(view.state_vector);
+}
+
+// set_zeros() is not defined for constant views
+template <typename StateVector, bool Ref>
+inline void set_zeros(symmetry_sector_view<StateVector const, Ref>&) {
+  static_assert(!std::is_same<StateVector, StateVector>::value,
+                "set_zeros() is not supported for constant views");
+}
+
+// Apply functor `f` to pairs (representative |a>, R_a times the amplitude of
+// |a> in the full Hilbert space) for all non-zero amplitudes of |a_\chi> with
+// serial numbers in the range [begin, end). Disjoint ranges can be processed
+// concurrently.
+template <typename StateVector, bool Ref, typename Functor>
+inline void foreach(symmetry_sector_view<StateVector, Ref> const& view,
+                    sv_index_type begin,
+                    sv_index_type end,
+                    Functor&& f) {
+  using T = typename symmetry_sector_view<StateVector, Ref>::scalar_type;
+  auto const& sector = *view.sector;
+  for(sv_index_type n = begin; n < end; ++n) {
+    // Emulate decltype(auto)
+    decltype(get_element(view.state_vector, n)) a =
+        get_element(view.state_vector, n);
+    if(is_zero_amplitude<T>(a)) continue;
+    f(sector.representative(n),
+      a * (sector.orbit_size(n) * sector.inv_sqrt_orbit_size(n)));
+  }
+}
+
+// Apply functor `f` to pairs (representative |a>, R_a times the amplitude of
+// |a> in the full Hilbert space) for all non-zero amplitudes of |a_\chi>
+template <typename StateVector, bool Ref, typename Functor>
+inline void foreach(symmetry_sector_view<StateVector, Ref> const& view,
+                    Functor&& f) {
+  foreach(view, 0, view.sector->size(), std::forward<Functor>(f));
+}
+
+template <typename StateVector>
+using make_symmetry_sector_view_ret_t =
+    symmetry_sector_view<remove_cvref_t<StateVector>,
+                         std::is_lvalue_reference<StateVector>::value>;
+
+// Make a non-constant symmetry sector view
+template <typename StateVector>
+auto make_symmetry_sector_view(StateVector&& sv,
+                               std::shared_ptr<symmetry_sector const> sector)
+    -> make_symmetry_sector_view_ret_t<StateVector> {
+  return make_symmetry_sector_view_ret_t<StateVector>(
+      std::forward<StateVector>(sv),
+      std::move(sector));
+}
+
+template <typename StateVector>
+using make_const_symmetry_sector_view_ret_t =
+    symmetry_sector_view<remove_cvref_t<StateVector> const,
+                         std::is_lvalue_reference<StateVector>::value>;
+
+// Make a constant symmetry sector view
+template <typename StateVector>
+auto make_const_symmetry_sector_view(
+    StateVector&& sv,
+    std::shared_ptr<symmetry_sector const> sector)
+    -> make_const_symmetry_sector_view_ret_t<StateVector> {
+  return make_const_symmetry_sector_view_ret_t<StateVector>(
+      std::forward<StateVector>(sv),
+      std::move(sector));
+}
+
+} // namespace libcommute
+
+#endif
@@ -0,0 +1,209 @@
+/*******************************************************************************
+ *
+ * This file is part of libcommute, a quantum operator algebra DSL and
+ * exact diagonalization toolkit for C++11/14/17.
+ *
+ * Copyright (C) 2016-2021 Igor Krivenko <igor.s.krivenko@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ ******************************************************************************/
+#ifndef LIBCOMMUTE_LOPERATOR_TRUNCATED_SPARSE_STATE_VECTOR_HPP_
+#define LIBCOMMUTE_LOPERATOR_TRUNCATED_SPARSE_STATE_VECTOR_HPP_
+
+#include "../scalar_traits.hpp"
+#include "flat_index_map.hpp"
+#include "state_vector.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace libcommute {
+
+//
+// Implementation of the StateVector concept based on a sparse storage with
+// truncation of small amplitudes
+//
+// update_add_element() does not store a new amplitude if its magnitude is
+// below a given threshold. Optionally, the number of stored amplitudes is
+// limited by `max_nonzeros`: When the limit is reached, a new amplitude
+// replaces the stored amplitude of the smallest magnitude if the latter is
+// smaller. The amplitude of the smallest magnitude is found using a min-heap.
+//
+template <typename ScalarType> class truncated_sparse_state_vector {
+
+  using heap_entry_type = std::pair<double, sv_index_type>;
+
+  sv_index_type size_;
+  double threshold_;
+  std::size_t max_nonzeros_;
+  flat_index_map<ScalarType> data_;
+
+  // Min-heap of amplitude magnitudes used when max_nonzeros_ > 0.
+  // The heap is updated lazily: For each stored amplitude, it contains at
+  // least one entry with a magnitude not exceeding the current magnitude of
+  // that amplitude. Outdated entries are discarded or refreshed when they
+  // reach the top of the heap.
+  std::vector<heap_entry_type> heap_;
+
+  static double magnitude(ScalarType const& a) {
+    using std::abs;
+    return double(abs(a));
+  }
+
+  void heap_push(double m, sv_index_type n) {
+    heap_.emplace_back(m, n);
+    std::push_heap(heap_.begin(), heap_.end(), std::greater<heap_entry_type>());
+    maybe_rebuild_heap();
+  }
+
+  void heap_pop() {
+    std::pop_heap(heap_.begin(), heap_.end(), std::greater<heap_entry_type>());
+    heap_.pop_back();
+  }
+
+  // Rebuild the heap from the stored amplitudes when it has accumulated too
+  // many outdated entries. All stored amplitudes must be up to date.
+  void maybe_rebuild_heap() {
+    if(heap_.size() < 2 * data_.size() + 16) return;
+    heap_.clear();
+    data_.foreach([this](sv_index_type n, ScalarType const& a) {
+      heap_.emplace_back(magnitude(a), n);
+    });
+    std::make_heap(heap_.begin(), heap_.end(), std::greater<heap_entry_type>());
+  }
+
+  // Remove the stored amplitude of the smallest magnitude if that magnitude
+  // is below `m`. Returns true if an amplitude has been removed.
+  bool evict_smaller_than(double m) {
+    while(!heap_.empty()) {
+      heap_entry_type top = heap_.front();
+      auto const* a = data_.find(top.second);
+      if(a == nullptr) {
+        heap_pop();
+        continue;
+      }
+      double current = magnitude(*a);
+      if(current == top.first) {
+        if(current >= m) return false;
+        heap_pop();
+        data_.erase(top.second);
+        return true;
+      }
+      heap_pop();
+      // The magnitude has grown since the entry was pushed
+      if(current > top.first) heap_push(current, top.second);
+    }
+    return false;
+  }
+
+public:
+  truncated_sparse_state_vector() = delete;
+
+  // `threshold` - smallest magnitude of a newly stored amplitude
+  // `max_nonzeros` - maximal number of stored amplitudes (0 means no limit)
+  truncated_sparse_state_vector(sv_index_type size,
+                                double threshold,
+                                std::size_t max_nonzeros = 0)
+    : size_(size), threshold_(threshold), max_nonzeros_(max_nonzeros) {
+    if(max_nonzeros_ > 0) data_.reserve(max_nonzeros_);
+  }
+
+  // Size of the vector
+  inline sv_index_type size() const { return size_; }
+
+  // Magnitude threshold for newly stored amplitudes
+  inline double threshold() const { return threshold_; }
+
+  // Maximal number of stored amplitudes (0 means no limit)
+  inline std::size_t max_nonzeros() const { return max_nonzeros_; }
+
+  // Number of non-zero amplitudes
+  inline sv_index_type n_nonzeros() const { return data_.size(); }
+
+  // Get n-th state amplitude
+  inline friend ScalarType get_element(truncated_sparse_state_vector const& sv,
+                                       sv_index_type n) {
+    assert(n < sv.size_);
+    auto const* a = sv.data_.find(n);
+    if(a == nullptr)
+      return scalar_traits<ScalarType>::make_const(0);
+    else
+      return *a;
+  }
+
+  // Add a constant to the n-th state amplitude
+  template <typename T>
+  inline friend void update_add_element(truncated_sparse_state_vector& sv,
+                                        sv_index_type n,
+                                        T&& value) {
+    assert(n < sv.size_);
+    auto* a = sv.data_.find(n);
+    if(a != nullptr) {
+      double old_magnitude = sv.max_nonzeros_ > 0 ? magnitude(*a) : 0;
+      *a += value;
+      if(is_zero_amplitude<ScalarType>(*a))
+        sv.data_.erase(n);
+      else if(sv.max_nonzeros_ > 0) {
+        double m = magnitude(*a);
+        if(m < old_magnitude) sv.heap_push(m, n);
+      }
+      return;
+    }
+
+    if(is_zero_amplitude<ScalarType>(value)) return;
+    ScalarType new_a(std::forward<T>(value));
+    double m = magnitude(new_a);
+    if(m < sv.threshold_) return;
+    if(sv.max_nonzeros_ > 0 && sv.data_.size() == sv.max_nonzeros_ &&
+       !sv.evict_smaller_than(m))
+      return;
+    sv.data_[n] = std::move(new_a);
+    if(sv.max_nonzeros_ > 0) sv.heap_push(m, n);
+  }
+
+  // Set all amplitudes to zero, the allocated storage is retained
+  inline friend void set_zeros(truncated_sparse_state_vector& sv) {
+    sv.data_.clear();
+    sv.heap_.clear();
+  }
+
+  // Make an empty vector with the same Hilbert space dimension and
+  // truncation parameters
+  inline friend truncated_sparse_state_vector
+  zeros_like(truncated_sparse_state_vector const& sv) {
+    return truncated_sparse_state_vector(sv.size_,
+                                         sv.threshold_,
+                                         sv.max_nonzeros_);
+  }
+
+  // Apply functor `f` to all index/non-zero amplitude pairs
+  template <typename Functor>
+  inline friend void foreach(truncated_sparse_state_vector const& sv,
+                             Functor&& f) {
+    sv.data_.foreach(f);
+  }
+
+  // Force removal of all amplitudes meeting a specified criterion
+  template <typename UnaryPredicate> inline void prune(UnaryPredicate&& p) {
+    data_.erase_if(
+        [&p](sv_index_type, ScalarType const& a) -> bool { return p(a); });
+  }
+};
+
+// Get element type of a truncated_sparse_state_vector<ScalarType> object
+template <typename ScalarType>
+struct element_type<truncated_sparse_state_vector<ScalarType>> {
+  using type = ScalarType;
+};
+
+} // namespace libcommute
+
+#endif
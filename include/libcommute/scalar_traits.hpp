@@ -89,6 +89,18 @@ template <typename S> struct scalar_traits<S, with_trait<is_complex, S>> {
   static S conj(S const& x) { return std::conj(x); }
 };
 
+//
+// Type used to accumulate sums of products of values of type S.
+// Single precision values are accumulated in double precision.
+//
+template <typename S> struct accumulator_type { using type = S; };
+template <> struct accumulator_type<float> { using type = double; };
+template <> struct accumulator_type<std::complex<float>> {
+  using type = std::complex<double>;
+};
+template <typename S>
+using accumulator_type_t = typename accumulator_type<S>::type;
+
 //
 // Result types of arithmetic operations
 //
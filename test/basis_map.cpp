@@ -0,0 +1,95 @@
+/*******************************************************************************
+ *
+ * This file is part of libcommute, a quantum operator algebra DSL and
+ * exact diagonalization toolkit for C++11/14/17.
+ *
+ * Copyright (C) 2016-2021 Igor Krivenko <igor.s.krivenko@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ ******************************************************************************/
+
+#include <catch.hpp>
+
+#include <libcommute/loperator/basis_map.hpp>
+
+#include <algorithm>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+using namespace libcommute;
+
+// Random basis states with duplicates
+std::vector<sv_index_type> random_basis_states(std::size_t n,
+                                               sv_index_type max_index) {
+  std::mt19937_64 gen(n);
+  std::uniform_int_distribution<sv_index_type> d(0, max_index);
+  std::vector<sv_index_type> states(n);
+  for(auto& s : states)
+    s = d(gen);
+  for(std::size_t i = 0; i < n / 10; ++i)
+    states.push_back(states[i]);
+  return states;
+}
+
+template <typename Map>
+void check_basis_map(std::vector<sv_index_type> const& basis_states) {
+  Map map(basis_states);
+  std::set<sv_index_type> states_set(basis_states.begin(), basis_states.end());
+  REQUIRE(map.size() == states_set.size());
+
+  // Mapped indices are positions in basis_states()
+  sv_index_type count = 0;
+  for(auto const& p : map) {
+    CHECK(p.second == count++);
+    CHECK(states_set.count(p.first) == 1);
+    CHECK(map.basis_states()[p.second] == p.first);
+  }
+  CHECK(count == map.size());
+
+  for(auto s : states_set) {
+    CHECK(map.basis_states()[map.at(s)] == s);
+    CHECK(map.find(s) == map.at(s));
+  }
+
+  // Basis states that are not in the map
+  std::vector<sv_index_type> absent;
+  for(sv_index_type s : {sv_index_type(0), sv_index_type(1), ~sv_index_type(0)})
+    if(states_set.count(s) == 0) absent.push_back(s);
+  for(auto s : states_set)
+    if(states_set.count(s + 1) == 0) absent.push_back(s + 1);
+  for(auto s : absent) {
+    CHECK(map.find(s) == map.size());
+    CHECK_THROWS_AS(map.at(s), std::out_of_range);
+  }
+}
+
+TEST_CASE("Array-based basis maps", "[basis_map]") {
+  std::vector<std::vector<sv_index_type>> inputs = {
+      {},
+      {5},
+      {3, 5, 6, 9, 10, 12},
+      {12, 10, 9, 6, 5, 3, 3, 12},
+      random_basis_states(100, 1000),
+      random_basis_states(1000, sv_index_type(1) << 40),
+      random_basis_states(100000, ~sv_index_type(0) - 1)};
+
+  SECTION("sorted_basis_map") {
+    for(auto const& basis_states : inputs) {
+      check_basis_map<sorted_basis_map>(basis_states);
+
+      sorted_basis_map map(basis_states);
+      CHECK(std::is_sorted(map.basis_states().begin(),
+                           map.basis_states().end()));
+    }
+  }
+
+  SECTION("perfect_hash_basis_map") {
+    for(auto const& basis_states : inputs)
+      check_basis_map<perfect_hash_basis_map>(basis_states);
+  }
+}
@@ -0,0 +1,121 @@
+/*******************************************************************************
+ *
+ * This file is part of libcommute, a quantum operator algebra DSL and
+ * exact diagonalization toolkit for C++11/14/17.
+ *
+ * Copyright (C) 2016-2021 Igor Krivenko <igor.s.krivenko@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ ******************************************************************************/
+
+#include <catch.hpp>
+
+#include <libcommute/bfloat16.hpp>
+#include <libcommute/expression/factories.hpp>
+#include <libcommute/loperator/loperator.hpp>
+
+#include <cmath>
+#include <complex>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+using namespace libcommute;
+using namespace static_indices;
+
+TEST_CASE("bfloat16", "[bfloat16]") {
+
+  SECTION("Conversions") {
+    CHECK(bfloat16().bits() == 0);
+    CHECK(bfloat16(1.0f).bits() == 0x3F80);
+    CHECK(bfloat16(-2.0f).bits() == 0xC000);
+    CHECK(float(bfloat16::from_bits(0x3F80)) == 1.0f);
+    CHECK(float(bfloat16(0.15625f)) == 0.15625f);
+
+    // Rounding to nearest, ties to even
+    CHECK(float(bfloat16(1.0f + 1.0f / 256)) == 1.0f);
+    CHECK(float(bfloat16(1.0f + 3.0f / 256)) == 1.0f + 1.0f / 64);
+    CHECK(float(bfloat16(1.0f + 1.0f / 128 + 1.0f / 512)) ==
+          1.0f + 1.0f / 128);
+    CHECK(float(bfloat16(1.0f + 1.0f / 256 + 1.0f / 1024)) ==
+          1.0f + 1.0f / 128);
+
+    float inf = std::numeric_limits<float>::infinity();
+    CHECK(float(bfloat16(inf)) == inf);
+    CHECK(std::isnan(float(bfloat16(std::numeric_limits<float>::quiet_NaN()))));
+  }
+
+  SECTION("Compound assignments") {
+    bfloat16 x(1.0f);
+    x += 0.5;
+    CHECK(float(x) == 1.5f);
+    x -= 2.0;
+    CHECK(float(x) == -0.5f);
+    x *= -4.0;
+    CHECK(float(x) == 2.0f);
+  }
+
+  SECTION("Traits") {
+    using traits = scalar_traits<bfloat16>;
+    CHECK(traits::is_zero(bfloat16(0.0f)));
+    CHECK(traits::is_zero(bfloat16(1e-20f)));
+    CHECK_FALSE(traits::is_zero(bfloat16(1e-10f)));
+    CHECK(float(traits::make_const(3.0)) == 3.0f);
+    CHECK(float(traits::conj(bfloat16(3.0f))) == 3.0f);
+    // Products with float and double coefficients are computed in double
+    // precision
+    CHECK(std::is_same<detail::amplitude_product_t<double, bfloat16>,
+                       double>::value);
+    CHECK(std::is_same<detail::amplitude_product_t<float, bfloat16>,
+                       double>::value);
+    CHECK(std::is_same<detail::amplitude_product_t<std::complex<float>,
+                                                   bfloat16>,
+                       std::complex<double>>::value);
+  }
+
+  SECTION("Storage of state amplitudes") {
+    auto expr = 0.5 * (c_dag(0) * c(1) + c_dag(1) * c(0)) + 2.0 * n(0);
+    auto hs = make_hilbert_space(expr);
+    auto lop = make_loperator(expr, hs);
+
+    std::vector<bfloat16> in = {bfloat16(1.0f),
+                                bfloat16(0.5f),
+                                bfloat16(0.25f),
+                                bfloat16(0.125f)};
+    std::vector<double> out(hs.dim());
+    lop(in, out);
+    CHECK(out == std::vector<double>{0, 1.125, 0.25, 0.25});
+
+    std::vector<bfloat16> out_b(hs.dim());
+    lop(in, out_b);
+    for(sv_index_type i = 0; i < hs.dim(); ++i)
+      CHECK(float(out_b[i]) == float(out[i]));
+  }
+
+  SECTION("Complex coefficients") {
+    auto expr = std::complex<double>(0, 0.5) * c_dag(0) * c(1) +
+                std::complex<double>(0, -0.5) * c_dag(1) * c(0) +
+                2.0 * n(0);
+    auto hs = make_hilbert_space(expr);
+    auto lop = make_loperator(expr, hs);
+
+    CHECK(std::complex<double>(1, 2) * bfloat16(0.5f) ==
+          std::complex<double>(0.5, 1));
+    CHECK(bfloat16(0.5f) * std::complex<float>(1, 2) ==
+          std::complex<float>(0.5, 1));
+
+    std::vector<bfloat16> in = {bfloat16(1.0f),
+                                bfloat16(0.5f),
+                                bfloat16(0.25f),
+                                bfloat16(0.125f)};
+    std::vector<std::complex<double>> out(hs.dim());
+    lop(in, out);
+    CHECK(out == std::vector<std::complex<double>>{0,
+                                                   {1.0, 0.125},
+                                                   {0, -0.25},
+                                                   0.25});
+  }
+}
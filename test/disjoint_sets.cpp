@@ -17,11 +17,18 @@
 
 using namespace libcommute;
 
+#include <cstdint>
 #include <iostream>
+#include <limits>
+#include <stdexcept>
 
-TEST_CASE("Disjoint sets data structure", "[disjoint_sets]") {
+TEMPLATE_TEST_CASE("Disjoint sets data structure",
+                   "[disjoint_sets]",
+                   disjoint_sets,
+                   compact_disjoint_sets,
+                   adaptive_disjoint_sets) {
 
-  disjoint_sets ds(10);
+  TestType ds(10);
 
   SECTION("Basic tests") {
     CHECK(ds.size() == 10);
@@ -75,3 +82,29 @@ TEST_CASE("Disjoint sets data structure", "[disjoint_sets]") {
     CHECK(ds.find_root(7) == 1);
   }
 }
+
+TEST_CASE("Memory-compact disjoint sets", "[compact_disjoint_sets]") {
+  CHECK(disjoint_sets::max_size() == std::numeric_limits<std::size_t>::max());
+  CHECK(compact_disjoint_sets::max_size() == std::size_t(1) << 32);
+
+  // Deep trees with ranks stored in 8-bit integers
+  compact_disjoint_sets ds(1 << 16);
+  for(std::size_t step = 1; step < ds.size(); step *= 2) {
+    for(std::size_t x = 0; x + step < ds.size(); x += 2 * step)
+      ds.set_union(x, x + step);
+  }
+  CHECK(ds.n_sets() == 1);
+  ds.compress_sets();
+  ds.normalize_sets();
+  for(std::size_t x = 0; x < ds.size(); ++x)
+    CHECK(ds.find_root(x) == 0);
+
+  using tiny_disjoint_sets = basic_disjoint_sets<std::uint8_t, std::uint8_t>;
+  CHECK(tiny_disjoint_sets::max_size() == 256);
+  tiny_disjoint_sets tds(255);
+  CHECK(tds.make_set() == 255);
+  CHECK_THROWS_AS(tds.make_set(), std::length_error);
+  CHECK_THROWS_AS(tiny_disjoint_sets(257), std::length_error);
+
+  CHECK(adaptive_disjoint_sets(100).is_compact());
+}
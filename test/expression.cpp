@@ -49,6 +49,17 @@ TEST_CASE("Expression with static indices", "[expression]") {
     expr_real<int, std::string> expr_tiny_monomial(1e-100, mon);
     CHECK_THAT(expr_tiny_monomial, Prints<decltype(expr_tiny_monomial)>("0"));
 
+    // Coefficients of single precision expressions are compared to zero with
+    // the single precision tolerance, so that rounding residues of cancelling
+    // terms are eliminated
+    using expr_float = expression<float, int, std::string>;
+    CHECK(expr_float(1e-6f, mon).size() == 0);
+    CHECK(expr_float(1e-3f, mon).size() == 1);
+    expr_float expr_float_sum(0.3f, mon);
+    expr_float_sum += expr_float(0.6f, mon);
+    expr_float_sum -= expr_float(0.9f, mon);
+    CHECK(expr_float_sum.size() == 0);
+
     expr_real<int, std::string> expr_monomial(3, mon);
     CHECK_THAT(expr_monomial,
                Prints<decltype(expr_monomial)>("3*C+(1,up)C(2,dn)"));
@@ -0,0 +1,120 @@
+/*******************************************************************************
+ *
+ * This file is part of libcommute, a quantum operator algebra DSL and
+ * exact diagonalization toolkit for C++11/14/17.
+ *
+ * Copyright (C) 2016-2021 Igor Krivenko <igor.s.krivenko@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ ******************************************************************************/
+
+#include <catch.hpp>
+
+#include <libcommute/loperator/flat_index_map.hpp>
+
+#include <map>
+#include <random>
+
+using namespace libcommute;
+
+template <typename T>
+void check_same_content(flat_index_map<T> const& map,
+                        std::map<sv_index_type, T> const& ref) {
+  REQUIRE(map.size() == ref.size());
+  std::map<sv_index_type, T> content;
+  map.foreach([&](sv_index_type key, T const& value) {
+    CHECK(content.emplace(key, value).second);
+  });
+  CHECK(content == ref);
+  for(auto const& p : ref) {
+    REQUIRE(map.find(p.first) != nullptr);
+    CHECK(*map.find(p.first) == p.second);
+  }
+}
+
+TEST_CASE("Open-addressing hash map", "[flat_index_map]") {
+
+  SECTION("Basic operations") {
+    flat_index_map<double> map;
+    CHECK(map.empty());
+    CHECK(map.capacity() == 0);
+    CHECK(map.find(3) == nullptr);
+    CHECK(map.erase(3) == 0);
+
+    map[3] = 1.0;
+    map[5] += 2.0;
+    CHECK(map[7] == 0);
+    CHECK(map.size() == 3);
+    CHECK(*map.find(3) == 1.0);
+    CHECK(*map.find(5) == 2.0);
+    CHECK(*map.find(7) == 0);
+    CHECK(map.find(4) == nullptr);
+
+    CHECK(map.erase(7) == 1);
+    CHECK(map.erase(7) == 0);
+    CHECK(map.size() == 2);
+
+    auto capacity = map.capacity();
+    map.clear();
+    CHECK(map.empty());
+    CHECK(map.capacity() == capacity);
+    CHECK(map.find(3) == nullptr);
+
+    map.reserve(1000);
+    CHECK(map.capacity() >= 1000);
+    capacity = map.capacity();
+    for(sv_index_type key = 0; key < 1000; ++key)
+      map[key * 7] = key;
+    CHECK(map.capacity() == capacity);
+    CHECK(map.size() == 1000);
+    map.reserve(10);
+    CHECK(map.capacity() == capacity);
+  }
+
+  SECTION("Random operations") {
+    std::mt19937_64 gen(1);
+    std::uniform_int_distribution<sv_index_type> key_d(0, 5000);
+    std::uniform_int_distribution<int> op_d(0, 3);
+
+    flat_index_map<long> map;
+    std::map<sv_index_type, long> ref;
+    for(int i = 0; i < 100000; ++i) {
+      auto key = key_d(gen);
+      switch(op_d(gen)) {
+        case 0:
+        case 1:
+          map[key] += i;
+          ref[key] += i;
+          break;
+        case 2: CHECK(map.erase(key) == ref.erase(key)); break;
+        case 3: CHECK((map.find(key) == nullptr) == (ref.count(key) == 0));
+      }
+    }
+    check_same_content(map, ref);
+
+    map.erase_if([](sv_index_type key, long) { return key % 3 == 0; });
+    for(auto it = ref.begin(); it != ref.end();) {
+      if(it->first % 3 == 0)
+        it = ref.erase(it);
+      else
+        ++it;
+    }
+    check_same_content(map, ref);
+
+    map.erase_if([](sv_index_type, long) { return true; });
+    CHECK(map.empty());
+  }
+
+  SECTION("Strided keys") {
+    flat_index_map<int> map;
+    std::map<sv_index_type, int> ref;
+    for(sv_index_type key = 0; key < 100000; ++key) {
+      map[key << 20] = int(key);
+      ref[key << 20] = int(key);
+    }
+    check_same_content(map, ref);
+  }
+}
@@ -13,6 +13,8 @@
 
 #include <catch.hpp>
 
+#include "print_matcher.hpp"
+
 #include <libcommute/expression/factories.hpp>
 #include <libcommute/loperator/elementary_space_boson.hpp>
 #include <libcommute/loperator/elementary_space_fermion.hpp>
@@ -22,6 +24,7 @@
 #include <tuple>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 using namespace libcommute;
 
@@ -138,6 +141,13 @@ TEST_CASE("Hilbert space", "[hilbert_space]") {
     }
   }
 
+  SECTION("Stream output") {
+    CHECK_THAT(hs_type(), Prints<hs_type>("{}"));
+    CHECK_THAT(
+        hs_type(es_s1_i, es_b_x, es_f_dn),
+        Prints<hs_type>("{-3(dn,0):[0,0], -2(x,0):[1,4], -1(i,0):[5,6]}"));
+  }
+
   SECTION("has(), index(), bit_range() and basis_state_index()") {
     hs_type hs(es_s32_i,
                es_s32_j,
@@ -364,3 +374,27 @@ TEST_CASE("Hilbert space", "[hilbert_space]") {
     CHECK_THROWS_AS(hs_type(expr), ex_type);
   }
 }
+
+TEST_CASE("hilbert_space::for_each_elementary_space()", "[hilbert_space]") {
+  using namespace static_indices;
+
+  using hs_type = hilbert_space<int>;
+
+  hs_type hs(make_space_spin(1.0, 0),
+             make_space_boson(3, 0),
+             make_space_fermion(0),
+             make_space_spin(0.5, 1));
+
+  std::vector<std::pair<std::size_t, bit_range_t>> dims_and_ranges;
+  hs.for_each_elementary_space(
+      [&](elementary_space<int> const& es, bit_range_t const& range) {
+        dims_and_ranges.emplace_back(es.dim(), range);
+      });
+
+  std::vector<std::pair<std::size_t, bit_range_t>> ref = {
+      {2, bit_range_t(0, 0)},
+      {8, bit_range_t(1, 3)},
+      {2, bit_range_t(4, 4)},
+      {3, bit_range_t(5, 6)}};
+  CHECK(dims_and_ranges == ref);
+}
@@ -115,6 +115,46 @@ TEST_CASE("Linear operator with constant coefficients", "[loperator]") {
     CHECK(out == state_vector{-6.0 * I, 12.0 * I, .0, 6.0 * I});
   }
 
+  SECTION("Mixed precision") {
+    std::vector<float> const coeffs = {0.1f, 0.3f, 0.7f};
+    expression<float, int> expr;
+    for(int i = 0; i < 3; ++i)
+      expr += coeffs[i] * (c_dag(i) * c((i + 1) % 3) + n(i));
+
+    auto hs = make_hilbert_space(expr);
+    auto lop = make_loperator(expr, hs);
+    auto lop_d = make_loperator(transform(expr,
+                                          [](monomial<int> const&,
+                                             float const& x) {
+                                            return double(x);
+                                          }),
+                                hs);
+
+    std::vector<float> in(hs.dim());
+    for(sv_index_type i = 0; i < hs.dim(); ++i)
+      in[i] = 1.0f / float(i + 3);
+    std::vector<double> const in_d(in.begin(), in.end());
+
+    // Products of single precision numbers are computed in double precision
+    std::vector<double> out(hs.dim()), out_ref(hs.dim());
+    lop(in, out);
+    lop_d(in_d, out_ref);
+    CHECK(out == out_ref);
+
+    // Storage in single precision
+    std::vector<float> out_f(hs.dim());
+    lop(in, out_f);
+    for(sv_index_type i = 0; i < hs.dim(); ++i)
+      CHECK(out_f[i] == Approx(out_ref[i]).epsilon(1e-6));
+
+    // Complex single precision amplitudes
+    std::vector<std::complex<float>> const in_c(in.begin(), in.end());
+    std::vector<std::complex<double>> out_c(hs.dim());
+    lop(in_c, out_c);
+    for(sv_index_type i = 0; i < hs.dim(); ++i)
+      CHECK(out_c[i] == std::complex<double>(out_ref[i]));
+  }
+
   SECTION("my_complex") {
     my_complex const I(0, 1);
 
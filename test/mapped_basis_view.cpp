@@ -17,6 +17,7 @@
 #include <libcommute/loperator/loperator.hpp>
 #include <libcommute/loperator/mapped_basis_view.hpp>
 
+#include <algorithm>
 #include <map>
 #include <set>
 #include <type_traits>
@@ -43,6 +44,60 @@ void check_equal_maps_up_to_value_permutation(
   CHECK(values1 == values2);
 }
 
+// basic_basis_mapper with an array-based map
+template <typename Map, typename HSType, typename ExprType>
+void check_array_based_mapper(
+    HSType const& hs,
+    ExprType const& Hex,
+    std::unordered_map<sv_index_type, sv_index_type> const& map) {
+  using namespace static_indices;
+  using state_vector = std::vector<double>;
+
+  std::vector<sv_index_type> basis_indices{12, 10, 9, 6, 5, 3};
+  basic_basis_mapper<Map> mapper(basis_indices);
+  CHECK(mapper.size() == 6);
+  for(auto i : basis_indices)
+    CHECK(mapper.map().basis_states()[mapper.map().at(i)] == i);
+  std::unordered_map<sv_index_type, sv_index_type> mapper_map(
+      mapper.map().begin(),
+      mapper.map().end());
+  check_equal_maps_up_to_value_permutation(mapper_map, map);
+  auto inv_map = mapper.inverse_map();
+  for(auto const& p : mapper_map)
+    CHECK(inv_map.at(p.second) == p.first);
+  CHECK(&mapper.basis_states() == &mapper.map().basis_states());
+
+  // Spin flips
+  auto Hop = make_loperator(Hex, hs);
+  state_vector in(6), out(6);
+  in[mapper.map().at(5)] = 1;
+  in[mapper.map().at(6)] = 2;
+  in[mapper.map().at(9)] = 3;
+  in[mapper.map().at(10)] = 4;
+  auto in_view = mapper.make_const_view(in);
+  auto out_view = mapper.make_view(out);
+  CHECK(std::is_same<decltype(out_view),
+                     mapped_basis_view<state_vector, true, Map>>::value);
+  CHECK(get_element(in_view, 10) == 4);
+  Hop(in_view, out_view);
+  state_vector out_ref(6);
+  out_ref[mapper.map().at(6)] = 6;
+  out_ref[mapper.map().at(9)] = 4;
+  CHECK(out == out_ref);
+
+  // Compositions
+  using O_list_t = std::vector<loperator<double, fermion, boson, spin>>;
+  O_list_t O_list{make_loperator(c_dag("dn", 1), hs),
+                  make_loperator(c_dag("dn", 2), hs),
+                  make_loperator(c_dag("up", 1), hs),
+                  make_loperator(c_dag("up", 2), hs)};
+  basic_basis_mapper<Map> mapper_N0(O_list, hs, 0);
+  CHECK(mapper_N0.size() == 1);
+  CHECK(mapper_N0.map().at(0) == 0);
+  basic_basis_mapper<Map> mapper_N2(O_list, hs, 2);
+  CHECK(mapper_N2.map().basis_states() == mapper.map().basis_states());
+}
+
 TEST_CASE("Basis-mapped view of a state vector", "[mapped_basis_view]") {
 
   using namespace static_indices;
@@ -167,6 +222,19 @@ TEST_CASE("Basis-mapped view of a state vector", "[mapped_basis_view]") {
       for(auto i : {3, 5, 6, 9, 10, 12})
         inv_map[inv_map.size()] = i;
       CHECK(mapper.inverse_map() == inv_map);
+      CHECK(mapper.basis_states() == basis_indices);
+
+      // Views made by the mapper iterate over the dense inverse map
+      auto view = mapper.make_const_view(st);
+      CHECK(view.basis_states == &mapper.basis_states());
+      std::vector<sv_index_type> foreach_indices;
+      foreach_res_t foreach_res;
+      foreach(view, [&](sv_index_type n, double a) {
+        foreach_indices.push_back(n);
+        foreach_res[n] = 2 * a;
+      });
+      CHECK(foreach_indices == std::vector<sv_index_type>{5, 6, 9, 10, 12});
+      CHECK(foreach_res == foreach_res_ref);
     }
 
     SECTION("O|vac>") {
@@ -177,6 +245,11 @@ TEST_CASE("Basis-mapped view of a state vector", "[mapped_basis_view]") {
       basis_mapper mapper(make_loperator(P, hs), hs);
       CHECK(mapper.size() == 6);
       check_equal_maps_up_to_value_permutation(mapper.map(), map);
+      for(sv_index_type n = 0; n < mapper.size(); ++n)
+        CHECK(mapper.map().at(mapper.basis_states()[n]) == n);
+
+      basis_mapper mapper_sorted(make_loperator(P, hs), hs, true);
+      CHECK(mapper_sorted.map() == map);
     }
 
     SECTION("Compositions") {
@@ -196,7 +269,34 @@ TEST_CASE("Basis-mapped view of a state vector", "[mapped_basis_view]") {
       CHECK(mapper_N0.map().at(0) == 0);
 
       basis_mapper mapper(O_list, hs, 2);
-      check_equal_maps_up_to_value_permutation(mapper.map(), map);
+      CHECK(mapper.map() == map);
+      for(sv_index_type n = 0; n < mapper.size(); ++n)
+        CHECK(mapper.map().at(mapper.basis_states()[n]) == n);
+    }
+
+    SECTION("Compositions/many fermions") {
+      using O_list_t = std::vector<loperator<double, fermion, boson, spin>>;
+
+      expression<double, int> Hc;
+      for(int i = 0; i < 10; ++i)
+        Hc += c_dag(i);
+      auto hs_f = make_hilbert_space(Hc);
+
+      O_list_t O_list;
+      for(int i = 0; i < 10; ++i)
+        O_list.emplace_back(make_loperator(c_dag(i), hs_f));
+
+      for(unsigned int N = 0; N <= 10; ++N) {
+        std::vector<sv_index_type> ref;
+        for(sv_index_type index = 0; index < hs_f.dim(); ++index) {
+          unsigned int n = 0;
+          for(sv_index_type i = index; i != 0; i >>= 1)
+            n += i & 1;
+          if(n == N) ref.push_back(index);
+        }
+        basis_mapper mapper(O_list, hs_f, N);
+        CHECK(mapper.basis_states() == ref);
+      }
     }
 
     SECTION("Compositions/bosons") {
@@ -214,9 +314,18 @@ TEST_CASE("Basis-mapped view of a state vector", "[mapped_basis_view]") {
       for(int N = 0; N < 10; ++N) {
         basis_mapper mapper(O_list, hs_b, N);
         CHECK(mapper.size() == map_size_ref[N]);
+        auto const& states = mapper.basis_states();
+        CHECK(std::is_sorted(states.begin(), states.end()));
+        for(sv_index_type n = 0; n < states.size(); ++n)
+          CHECK(mapper.map().at(states[n]) == n);
       }
     }
 
+    SECTION("Array-based maps") {
+      check_array_based_mapper<sorted_basis_map>(hs, Hex, map);
+      check_array_based_mapper<perfect_hash_basis_map>(hs, Hex, map);
+    }
+
     SECTION("make_view() and make_const_view()") {
       std::vector<sv_index_type> basis_indices{3, 5, 6, 9, 10, 12};
       basis_mapper mapper(basis_indices);
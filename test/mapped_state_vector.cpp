@@ -0,0 +1,179 @@
+/*******************************************************************************
+ *
+ * This file is part of libcommute, a quantum operator algebra DSL and
+ * exact diagonalization toolkit for C++11/14/17.
+ *
+ * Copyright (C) 2016-2021 Igor Krivenko <igor.s.krivenko@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ ******************************************************************************/
+
+#include <catch.hpp>
+
+#include <libcommute/expression/factories.hpp>
+#include <libcommute/loperator/elementary_space_fermion.hpp>
+#include <libcommute/loperator/hilbert_space.hpp>
+#include <libcommute/loperator/loperator.hpp>
+#include <libcommute/loperator/mapped_basis_view.hpp>
+#include <libcommute/loperator/mapped_state_vector.hpp>
+#include <libcommute/loperator/n_fermion_sector_view.hpp>
+
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+using namespace libcommute;
+
+TEST_CASE("Implementation of the StateVector concept based on "
+          "a memory-mapped file",
+          "[mapped_state_vector]") {
+  using namespace static_indices;
+
+  std::string const path = "mapped_state_vector.bin";
+
+  SECTION("Basic operations") {
+    sv_index_type const size = 10001;
+    std::string temp_path;
+    {
+      mapped_state_vector<double> v(path, size);
+      CHECK(std::is_same<element_type_t<decltype(v)>, double>::value);
+      CHECK(v.size() == size);
+      CHECK_FALSE(v.is_temporary());
+      CHECK(v.file().size() == size * sizeof(double));
+      CHECK(v.chunk_size() == mapped_state_vector<double>::default_chunk_size);
+
+      // Several chunks are processed by foreach()
+      v.set_chunk_size(1);
+      CHECK(v.chunk_size() == mapped_file::page_size());
+
+      for(sv_index_type n = 0; n < size; n += 7)
+        update_add_element(v, n, double(n + 1));
+      update_add_element(v, 7, 1.0);
+      CHECK(get_element(v, 7) == 9.0);
+      CHECK(get_element(v, 8) == 0);
+      v[7] = 8.0;
+
+      sv_index_type count = 0, prev = 0;
+      foreach(v, [&](sv_index_type n, double a) {
+        CHECK(n % 7 == 0);
+        CHECK(a == n + 1);
+        CHECK((count == 0 || n > prev));
+        prev = n;
+        ++count;
+      });
+      CHECK(count == (size + 6) / 7);
+
+      auto v2 = zeros_like(v);
+      temp_path = v2.file().path();
+      CHECK(v2.is_temporary());
+      CHECK(temp_path.compare(0, path.size() + 1, path + ".") == 0);
+      CHECK(v2.size() == size);
+      CHECK(v2.chunk_size() == v.chunk_size());
+      CHECK(std::ifstream(temp_path).good());
+      foreach(v2, [](sv_index_type, double) { FAIL(); });
+
+      v.advise(mapped_file::random);
+      v.sync();
+    }
+    // Temporary files are removed
+    CHECK_FALSE(std::ifstream(temp_path).good());
+
+    {
+      mapped_state_vector<double> v(path, mapped_file::read_only);
+      CHECK(v.size() == size);
+      CHECK(get_element(v, 7) == 8.0);
+      CHECK(get_element(v, 14) == 15.0);
+      CHECK_THROWS_AS(mapped_state_vector<std::complex<double>>(
+                          path,
+                          mapped_file::read_only),
+                      std::runtime_error);
+    }
+    {
+      mapped_state_vector<double> v(path, mapped_file::read_write);
+      set_zeros(v);
+      CHECK(v.size() == size);
+      CHECK(get_element(v, 7) == 0);
+      foreach(v, [](sv_index_type, double) { FAIL(); });
+    }
+    std::remove(path.c_str());
+  }
+
+  int const L = 10;
+  hilbert_space<int> hs;
+  for(int i = 0; i < L; ++i)
+    hs.add(make_space_fermion(i));
+
+  expression<std::complex<double>, int> H;
+  for(int i = 0; i < L; ++i) {
+    int j = (i + 1) % L;
+    H += std::complex<double>(-1.0, 0.2) * c_dag(i) * c(j);
+    H += std::complex<double>(-1.0, -0.2) * c_dag(j) * c(i);
+    H += 0.5 * n(i) * n(j);
+  }
+  auto Hop = make_loperator(H, hs);
+
+  using cvector = std::vector<std::complex<double>>;
+
+  SECTION("Action of loperator") {
+    cvector in(hs.dim());
+    for(sv_index_type n = 0; n < hs.dim(); ++n)
+      in[n] = std::complex<double>(std::cos(0.1 * n), std::sin(0.2 * n));
+    auto out = Hop(in);
+
+    {
+      mapped_state_vector<std::complex<double>> src(path, hs.dim());
+      src.set_chunk_size(1);
+      for(sv_index_type n = 0; n < hs.dim(); ++n)
+        src[n] = in[n];
+      auto dst = zeros_like(src);
+      Hop(src, dst);
+      for(sv_index_type n = 0; n < hs.dim(); ++n)
+        CHECK(std::abs(get_element(dst, n) - out[n]) < 1e-12);
+
+      auto dst2 = Hop(src);
+      CHECK(dst2.is_temporary());
+      for(sv_index_type n = 0; n < hs.dim(); ++n)
+        CHECK(std::abs(get_element(dst2, n) - out[n]) < 1e-12);
+    }
+    std::remove(path.c_str());
+  }
+
+  SECTION("Views") {
+    unsigned int const N = 4;
+    auto size = n_fermion_sector_size(hs, N);
+    auto basis_states = n_fermion_sector_basis_states(hs, N);
+
+    cvector in(size);
+    for(sv_index_type n = 0; n < size; ++n)
+      in[n] = std::complex<double>(std::cos(0.3 * n), std::sin(0.4 * n));
+    cvector out(size);
+    Hop(make_const_nfs_view(in, hs, N), make_nfs_view(out, hs, N));
+
+    {
+      mapped_state_vector<std::complex<double>> src(path, size);
+      for(sv_index_type n = 0; n < size; ++n)
+        src[n] = in[n];
+      auto dst = zeros_like(src);
+
+      Hop(make_const_nfs_view(src, hs, N), make_nfs_view(dst, hs, N));
+      for(sv_index_type n = 0; n < size; ++n)
+        CHECK(std::abs(get_element(dst, n) - out[n]) < 1e-12);
+
+      basis_mapper mapper(basis_states);
+      cvector out_mapped(size);
+      Hop(mapper.make_const_view(in), mapper.make_view(out_mapped));
+      Hop(mapper.make_const_view(src), mapper.make_view(dst));
+      for(sv_index_type n = 0; n < size; ++n)
+        CHECK(std::abs(get_element(dst, n) - out_mapped[n]) < 1e-12);
+    }
+    std::remove(path.c_str());
+  }
+}
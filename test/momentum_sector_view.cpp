@@ -0,0 +1,256 @@
+/*******************************************************************************
+ *
+ * This file is part of libcommute, a quantum operator algebra DSL and
+ * exact diagonalization toolkit for C++11/14/17.
+ *
+ * Copyright (C) 2016-2021 Igor Krivenko <igor.s.krivenko@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ ******************************************************************************/
+
+#include <catch.hpp>
+
+#include <libcommute/expression/factories.hpp>
+#include <libcommute/loperator/elementary_space_fermion.hpp>
+#include <libcommute/loperator/elementary_space_spin.hpp>
+#include <libcommute/loperator/hilbert_space.hpp>
+#include <libcommute/loperator/loperator.hpp>
+#include <libcommute/loperator/momentum_sector_view.hpp>
+#include <libcommute/loperator/n_fermion_sector_view.hpp>
+#include <libcommute/loperator/n_quanta_sector_view.hpp>
+
+#include <cmath>
+#include <complex>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+using namespace libcommute;
+
+using hs_type = hilbert_space<int>;
+using cvector = std::vector<std::complex<double>>;
+
+// Explicitly constructed state |a(k)> in the full Hilbert space
+cvector make_momentum_state(momentum_sector const& sector,
+                            sv_index_type a,
+                            sv_index_type dim) {
+  cvector v(dim, 0);
+  auto const& T = sector.translation();
+  sv_index_type x = a;
+  int sign = 1;
+  for(unsigned int j = 0; j < sector.L(); ++j) {
+    v[x] += std::polar(1.0, -sector.k() * j) * double(sign);
+    sign *= T.sign(x);
+    x = T(x);
+  }
+  double norm = std::sqrt(
+      std::accumulate(v.begin(),
+                      v.end(),
+                      0.0,
+                      [](double s, std::complex<double> z) {
+                        return s + std::norm(z);
+                      }));
+  for(auto& z : v)
+    z /= norm;
+  return v;
+}
+
+std::complex<double> dot(cvector const& v1, cvector const& v2) {
+  std::complex<double> res = 0;
+  for(std::size_t i = 0; i < v1.size(); ++i)
+    res += std::conj(v1[i]) * v2[i];
+  return res;
+}
+
+// Compare action of a translation invariant operator on a momentum sector view
+// with the explicitly computed matrix elements
+template <typename LOp>
+void check_momentum_sector(hs_type const& hs,
+                           LOp const& Hop,
+                           std::shared_ptr<momentum_sector const> sector) {
+  auto size = sector->size();
+
+  std::vector<cvector> states;
+  for(sv_index_type n = 0; n < size; ++n)
+    states.push_back(
+        make_momentum_state(*sector, sector->representative(n), hs.dim()));
+
+  cvector in(size), out(size);
+  auto view_in = make_const_momentum_sector_view(in, sector);
+  auto view_out = make_momentum_sector_view(out, sector);
+  for(sv_index_type n = 0; n < size; ++n) {
+    CHECK(view_in.map_index(sector->representative(n)) == n);
+    CHECK(view_in.inverse_map_index(n) == sector->representative(n));
+
+    std::fill(in.begin(), in.end(), 0);
+    in[n] = 1;
+
+    // get_element() returns amplitudes in the full Hilbert space
+    for(sv_index_type index = 0; index < hs.dim(); ++index) {
+      auto a = get_element(view_in, index);
+      CHECK(std::abs(a - states[n][index]) < 1e-12);
+    }
+
+    Hop(view_in, view_out);
+    cvector H_state = Hop(states[n]);
+    for(sv_index_type n2 = 0; n2 < size; ++n2) {
+      CHECK(std::abs(out[n2] - dot(states[n2], H_state)) < 1e-12);
+    }
+  }
+}
+
+TEST_CASE("Permutation of elementary spaces", "[space_permutation]") {
+  using namespace static_indices;
+
+  SECTION("Spins") {
+    hs_type hs;
+    for(int i = 0; i < 4; ++i)
+      hs.add(make_space_spin(1.0, i));
+
+    space_permutation T(hs, {1, 2, 3, 0});
+    CHECK(T.order() == 4);
+    CHECK(T(0x0) == 0x0);
+    CHECK(T(0x2) == 0x8);
+    CHECK(T(0x1B) == 0x6C);
+    CHECK(T(0xC1) == 0x7);
+    CHECK(T.sign(0xFF) == 1);
+
+    space_permutation T2 = T.power(2);
+    CHECK(T2.permutation() == std::vector<int>{2, 3, 0, 1});
+    CHECK(T2.order() == 2);
+    for(sv_index_type x : {0x2, 0x1B, 0xC1})
+      CHECK(T2(x) == T(T(x)));
+    CHECK(T.power(0)(0x1B) == 0x1B);
+    CHECK(T.power(4)(0x1B) == 0x1B);
+
+    space_permutation P(hs, {1, 0, 3, 2});
+    CHECK(P.order() == 2);
+    CHECK(P(0x1B) == 0x4E);
+
+    CHECK_THROWS_AS(space_permutation(hs, {1, 2, 3}), std::invalid_argument);
+    CHECK_THROWS_AS(space_permutation(hs, {1, 1, 3, 0}),
+                    std::invalid_argument);
+    CHECK_THROWS_AS(space_permutation(hs, {1, 2, 3, 4}),
+                    std::invalid_argument);
+
+    hs.add(make_space_spin(0.5, 4));
+    CHECK_THROWS_AS(space_permutation(hs, {4, 1, 2, 3, 0}),
+                    std::invalid_argument);
+  }
+
+  SECTION("Fermions") {
+    hs_type hs;
+    for(int i = 0; i < 3; ++i)
+      hs.add(make_space_fermion(i));
+
+    space_permutation T(hs, {1, 2, 0});
+    CHECK(T.order() == 3);
+    // c^+_2 c^+_1 c^+_0 |0> -> c^+_0 c^+_2 c^+_1 |0> = c^+_2 c^+_1 c^+_0 |0>
+    CHECK(T(0x7) == 0x7);
+    CHECK(T.sign(0x7) == 1);
+    // c^+_2 c^+_0 |0> -> c^+_0 c^+_1 |0> = -c^+_1 c^+_0 |0>
+    CHECK(T(0x5) == 0x3);
+    CHECK(T.sign(0x5) == -1);
+    // c^+_1 c^+_0 |0> -> c^+_2 c^+_1 |0>
+    CHECK(T(0x3) == 0x6);
+    CHECK(T.sign(0x3) == 1);
+
+    space_permutation T2 = T.power(2);
+    CHECK(T2(0x5) == 0x6);
+    CHECK(T2.sign(0x5) == -1);
+    CHECK(T2(0x7) == 0x7);
+    CHECK(T2.sign(0x7) == 1);
+  }
+}
+
+TEST_CASE("View of a state vector in a momentum sector",
+          "[momentum_sector_view]") {
+  using namespace static_indices;
+
+  SECTION("Heisenberg ring") {
+    int const L = 6;
+    hs_type hs;
+    for(int i = 0; i < L; ++i)
+      hs.add(make_space_spin(0.5, i));
+
+    expression<double, int> H;
+    for(int i = 0; i < L; ++i) {
+      int j = (i + 1) % L;
+      H += S_z(i) * S_z(j) + 0.5 * (S_p(i) * S_m(j) + S_m(i) * S_p(j));
+    }
+    auto Hop = make_loperator(H, hs);
+
+    std::vector<int> perm(L);
+    for(int i = 0; i < L; ++i)
+      perm[hs.index(make_space_spin(0.5, i))] =
+          hs.index(make_space_spin(0.5, (i + 1) % L));
+    space_permutation T(hs, perm);
+
+    std::vector<sv_index_type> all_states(hs.dim());
+    std::iota(all_states.begin(), all_states.end(), 0);
+
+    sv_index_type total_size = 0;
+    for(unsigned int m = 0; m < L; ++m) {
+      auto sector = make_momentum_sector(T, m, all_states);
+      CHECK(sector->L() == L);
+      CHECK(sector->m() == m);
+      total_size += sector->size();
+      check_momentum_sector(hs, Hop, sector);
+
+      // Sectors with a fixed total magnetization
+      for(unsigned int N = 0; N <= L; ++N) {
+        check_momentum_sector(
+            hs,
+            Hop,
+            make_momentum_sector(T, m, n_quanta_sector_basis_states(hs, N)));
+      }
+    }
+    CHECK(total_size == hs.dim());
+
+    CHECK_THROWS_AS(make_momentum_sector(T, L, all_states),
+                    std::invalid_argument);
+
+    // Real amplitudes are supported only for k = 0, pi
+    std::vector<double> st;
+    CHECK_NOTHROW(make_momentum_sector_view(st,
+                                            make_momentum_sector(T, 0, {})));
+    CHECK_NOTHROW(make_momentum_sector_view(st,
+                                            make_momentum_sector(T, 3, {})));
+    CHECK_THROWS_AS(make_momentum_sector_view(st,
+                                              make_momentum_sector(T, 1, {})),
+                    std::invalid_argument);
+  }
+
+  SECTION("Spinless fermions on a ring") {
+    int const L = 5;
+    hs_type hs;
+    for(int i = 0; i < L; ++i)
+      hs.add(make_space_fermion(i));
+
+    expression<double, int> H;
+    for(int i = 0; i < L; ++i) {
+      int j = (i + 1) % L;
+      H += -(c_dag(i) * c(j) + c_dag(j) * c(i)) + 0.5 * n(i) * n(j);
+    }
+    auto Hop = make_loperator(H, hs);
+
+    std::vector<int> perm(L);
+    for(int i = 0; i < L; ++i)
+      perm[i] = (i + 1) % L;
+    space_permutation T(hs, perm);
+
+    for(unsigned int N = 0; N <= L; ++N) {
+      auto basis_states = n_fermion_sector_basis_states(hs, N);
+      sv_index_type total_size = 0;
+      for(unsigned int m = 0; m < L; ++m) {
+        auto sector = make_momentum_sector(T, m, basis_states);
+        total_size += sector->size();
+        check_momentum_sector(hs, Hop, sector);
+      }
+      CHECK(total_size == basis_states.size());
+    }
+  }
+}
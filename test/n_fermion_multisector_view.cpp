@@ -259,7 +259,8 @@ TEST_CASE("View of a state vector projected on a direct product of "
                          unsigned int M_nonmultisector) {
       REQUIRE(N.size() == M.size());
 
-      CHECK(view.sector_map_index_data.size() == M.size());
+      CHECK(view.descriptor->sector_gathers.size() == M.size());
+      CHECK(view.descriptor->rankings.size() == M.size());
       // cppcheck-suppress cppcheckError
       for(std::size_t i = 0; i < M.size(); ++i) {
         CHECK(view.sector_params[i].M == M[i]);
@@ -692,6 +693,126 @@ TEST_CASE("View of a state vector projected on a direct product of "
     }
   }
 
+  SECTION("bit_gather") {
+    for(sv_index_type mask : {sv_index_type(0),
+                              sv_index_type(0x1),
+                              sv_index_type(0x3C6),
+                              sv_index_type(0xF0F0F0F0F0F0F0F0),
+                              ~sv_index_type(0)}) {
+      detail::bit_gather gather(mask);
+      CHECK(gather.mask() == mask);
+      CHECK(gather.size() == popcount(mask, {0, 63}));
+      for(sv_index_type index : {sv_index_type(0),
+                                 sv_index_type(0x2C4),
+                                 sv_index_type(0x123456789ABCDEF0),
+                                 ~sv_index_type(0)}) {
+        sv_index_type ref = 0;
+        unsigned int k = 0;
+        for(unsigned int b = 0; b < 64; ++b) {
+          if((mask >> b) & 1) ref += ((index >> b) & 1) << k++;
+        }
+        CHECK(gather(index) == ref);
+      }
+    }
+  }
+
+  SECTION("Ranking algorithms") {
+    state_vector st{};
+
+    hs_type hs;
+    for(unsigned int i = 0; i < M_total; ++i)
+      hs.add(make_space_fermion(int(i)));
+    hs.add(make_space_boson(2, int(M_total)));
+
+    // All ranking algorithms must produce identical results
+    for(unsigned int N1 = 0; N1 <= Na_max; ++N1) {
+      for(unsigned int N2 = 0; N2 <= N5_max; ++N2) {
+        for(unsigned int N3 = 0; N3 <= Nb_max; ++N3) {
+          std::vector<sd_type> sectors = {sda(N1), sd5(N2), sdb(N3)};
+          auto view = view_type(st, hs, sectors);
+          auto view3 = make_nfms_view<staggered_ranking<3>>(st, hs, sectors);
+          auto view_lin = make_nfms_view<lin_table_ranking>(st, hs, sectors);
+          auto selector = sda5b_index_selector(N1, N2, N3);
+          for(sv_index_type index = 0; index < hs.dim(); ++index) {
+            if(!selector(index)) continue;
+            auto mapped_index = view.map_index(index);
+            CHECK(view3.map_index(index) == mapped_index);
+            CHECK(view_lin.map_index(index) == mapped_index);
+          }
+        }
+      }
+    }
+
+    auto cview = make_const_nfms_view<lin_table_ranking>(st, hs, {sda(2)});
+    CHECK(std::is_same<decltype(cview),
+                       n_fermion_multisector_view<state_vector const,
+                                                  true,
+                                                  lin_table_ranking>>::value);
+  }
+
+  SECTION("Shared descriptor") {
+    hs_type hs;
+    for(unsigned int i = 0; i < M_total; ++i)
+      hs.add(make_space_fermion(int(i)));
+    hs.add(make_space_boson(2, int(M_total)));
+
+    std::vector<sd_type> sectors = {sda(2), sd5(1), sdb(3)};
+    auto descriptor = make_nfms_descriptor<lin_table_ranking>(hs, sectors);
+    CHECK(std::is_same<decltype(descriptor),
+                       std::shared_ptr<n_fermion_multisector_descriptor<
+                           lin_table_ranking> const>>::value);
+
+    auto size = n_fermion_multisector_size(hs, sectors);
+    state_vector st1(size), st2(size);
+    std::iota(st1.begin(), st1.end(), 1);
+    std::iota(st2.begin(), st2.end(), 1);
+
+    auto view1 = make_nfms_view(st1, descriptor);
+    auto view2 = make_const_nfms_view(st2, descriptor);
+    CHECK(std::is_same<decltype(view1),
+                       n_fermion_multisector_view<state_vector,
+                                                  true,
+                                                  lin_table_ranking>>::value);
+    CHECK(std::is_same<decltype(view2),
+                       n_fermion_multisector_view<state_vector const,
+                                                  true,
+                                                  lin_table_ranking>>::value);
+    CHECK(view1.descriptor == descriptor);
+    CHECK(view2.descriptor == descriptor);
+    CHECK(&view1.sector_params == &descriptor->sector_params);
+    CHECK(&view2.bit_to_sector == &descriptor->bit_to_sector);
+
+    // Views built from a shared descriptor and from scratch must agree
+    auto view_ref = view_type(st1, hs, sectors);
+    CHECK(view1.sector_strides == view_ref.sector_strides);
+    CHECK(view1.M_nonmultisector == view_ref.M_nonmultisector);
+    auto selector = sda5b_index_selector(2, 1, 3);
+    for(sv_index_type index = 0; index < hs.dim(); ++index) {
+      if(!selector(index)) continue;
+      CHECK(view1.map_index(index) == view_ref.map_index(index));
+      CHECK(view2.map_index(index) == view_ref.map_index(index));
+    }
+
+    // Each view iterates over its own state vector
+    std::vector<sv_index_type> indices1, indices2;
+    foreach(view1, [&](sv_index_type index, double a) {
+      CHECK(sv_index_type(a) == view_ref.map_index(index) + 1);
+      indices1.push_back(index);
+    });
+    foreach(view2, [&](sv_index_type index, double a) {
+      CHECK(sv_index_type(a) == view_ref.map_index(index) + 1);
+      indices2.push_back(index);
+    });
+    CHECK(indices1.size() == size);
+    CHECK(indices2 == indices1);
+
+    // A copy of a view shares the descriptor
+    auto view3 = view1;
+    CHECK(view3.descriptor == descriptor);
+    CHECK(&view3.sector_strides == &descriptor->sector_strides);
+    CHECK(descriptor.use_count() == 4);
+  }
+
   SECTION("foreach()") {
     hs_type hs;
 
@@ -708,6 +829,25 @@ TEST_CASE("View of a state vector projected on a direct product of "
       });
       // Check that all elements of 'st' have been processed
       CHECK(count == st.size());
+
+      // inverse_map_index() is the inverse of map_index()
+      for(sv_index_type n = 0; n < st.size(); ++n)
+        CHECK(view.map_index(view.inverse_map_index(n)) == n);
+
+      // Process elements of 'st' in chunks
+      for(sv_index_type chunk : {1, 3, 7, 1000}) {
+        count = 0;
+        for(sv_index_type begin = 0; begin < st.size(); begin += chunk) {
+          auto end = std::min(begin + chunk, sv_index_type(st.size()));
+          foreach(view, begin, end, [&](sv_index_type index, double a) {
+            CHECK(sv_index_type(a) == ++count);
+            CHECK(view.map_index(index) == count - 1);
+          });
+          CHECK(count == end);
+        }
+        CHECK(count == st.size());
+      }
+      foreach(view, 1, 1, [](sv_index_type, double) { CHECK(false); });
     };
 
     SECTION("Empty Hilbert space") {
@@ -16,6 +16,7 @@
 #include <libcommute/expression/factories.hpp>
 #include <libcommute/loperator/elementary_space_boson.hpp>
 #include <libcommute/loperator/elementary_space_fermion.hpp>
+#include <libcommute/loperator/elementary_space_spin.hpp>
 #include <libcommute/loperator/hilbert_space.hpp>
 #include <libcommute/loperator/loperator.hpp>
 #include <libcommute/loperator/n_fermion_sector_view.hpp>
@@ -363,6 +364,85 @@ TEST_CASE("View of a state vector projected on a single N-fermion sector",
     }
   }
 
+  SECTION("Ranking algorithms") {
+    unsigned int const M = 11;
+    state_vector st{};
+
+    hs_type hs;
+
+    // All ranking algorithms must produce identical results
+    auto check_ranking = [&hs, &st](unsigned int M, unsigned int N) {
+      auto view = view_type(st, hs, N);
+      auto view1 = n_fermion_sector_view<state_vector,
+                                         true,
+                                         staggered_ranking<1>>(st, hs, N);
+      auto view3 = n_fermion_sector_view<state_vector,
+                                         true,
+                                         staggered_ranking<3>>(st, hs, N);
+      auto view8 = make_nfs_view<staggered_ranking<>>(st, hs, N);
+      auto view16 = make_nfs_view<staggered_ranking<16>>(st, hs, N);
+      auto view_lin = make_nfs_view<lin_table_ranking>(st, hs, N);
+      for(sv_index_type index = 0; index < hs.dim(); ++index) {
+        if(popcount(index, M) != N) continue;
+        auto mapped_index = view.map_index(index);
+        CHECK(view1.map_index(index) == mapped_index);
+        CHECK(view3.map_index(index) == mapped_index);
+        CHECK(view8.map_index(index) == mapped_index);
+        CHECK(view16.map_index(index) == mapped_index);
+        CHECK(view_lin.map_index(index) == mapped_index);
+      }
+    };
+
+    for(unsigned int i = 0; i < M; ++i)
+      hs.add(make_space_fermion(int(i)));
+
+    SECTION("Purely fermionic Hilbert spaces") {
+      for(unsigned int N = 0; N <= M; ++N)
+        check_ranking(M, N);
+    }
+
+    hs.add(make_space_boson(2, int(M)));
+
+    SECTION("Fermions and bosons") {
+      for(unsigned int N = 0; N <= M; ++N)
+        check_ranking(M, N);
+    }
+
+    SECTION("make_nfs_view() and make_const_nfs_view()") {
+      auto view = make_nfs_view<staggered_ranking<4>>(st, hs, 2);
+      CHECK(std::is_same<decltype(view),
+                         n_fermion_sector_view<state_vector,
+                                               true,
+                                               staggered_ranking<4>>>::value);
+      auto cview = make_const_nfs_view<staggered_ranking<4>>(st, hs, 2);
+      CHECK(std::is_same<decltype(cview),
+                         n_fermion_sector_view<state_vector const,
+                                               true,
+                                               staggered_ranking<4>>>::value);
+    }
+
+    SECTION("Shared lookup tables") {
+      state_vector st2{};
+      auto view1 = make_nfs_view<lin_table_ranking>(st, hs, 5);
+      auto view2 = make_nfs_view(st2, hs, 5, view1.ranking);
+      CHECK(std::is_same<decltype(view2),
+                         n_fermion_sector_view<state_vector,
+                                               true,
+                                               lin_table_ranking>>::value);
+      CHECK(view2.ranking.tables() == view1.ranking.tables());
+      auto cview = make_const_nfs_view(st2, hs, 5, view1.ranking);
+      CHECK(std::is_same<decltype(cview),
+                         n_fermion_sector_view<state_vector const,
+                                               true,
+                                               lin_table_ranking>>::value);
+      CHECK(cview.ranking.tables() == view1.ranking.tables());
+      for(sv_index_type index = 0; index < hs.dim(); ++index) {
+        if(popcount(index, M) != 5) continue;
+        CHECK(view2.map_index(index) == view1.map_index(index));
+      }
+    }
+  }
+
   SECTION("foreach()") {
     unsigned int const M = 8;
 
@@ -381,6 +461,25 @@ TEST_CASE("View of a state vector projected on a single N-fermion sector",
       });
       // Check that all elements of 'st' have been processed
       CHECK(count == st.size());
+
+      // inverse_map_index() is the inverse of map_index()
+      for(sv_index_type n = 0; n < st.size(); ++n)
+        CHECK(view.map_index(view.inverse_map_index(n)) == n);
+
+      // Process elements of 'st' in chunks
+      for(sv_index_type chunk : {1, 3, 7, 1000}) {
+        count = 0;
+        for(sv_index_type begin = 0; begin < st.size(); begin += chunk) {
+          auto end = std::min(begin + chunk, sv_index_type(st.size()));
+          foreach(view, begin, end, [&](sv_index_type index, double a) {
+            CHECK(sv_index_type(a) == ++count);
+            CHECK(view.map_index(index) == count - 1);
+          });
+          CHECK(count == end);
+        }
+        CHECK(count == st.size());
+      }
+      foreach(view, 1, 1, [](sv_index_type, double) { CHECK(false); });
     };
 
     SECTION("Empty Hilbert space") {
@@ -549,3 +648,188 @@ TEST_CASE("View of a state vector projected on a single N-fermion sector",
     }
   }
 }
+
+TEST_CASE("View of a state vector projected on a single N-fermion sector "
+          "with a mixed-radix non-fermionic part",
+          "[n_fermion_sector_mixed_radix_view]") {
+
+  using namespace static_indices;
+
+  using hs_type = hilbert_space<int>;
+  using state_vector = std::vector<double>;
+  using view_type = n_fermion_sector_mixed_radix_view<state_vector>;
+
+  unsigned int const M = 4;
+
+  hs_type hs(make_space_boson(2, 0), make_space_spin(1.0, 0));
+  hs.add(make_space_spin(0.5, 1));
+  for(unsigned int i = 0; i < M; ++i)
+    hs.add(make_space_fermion(int(i)));
+
+  // Boson truncated to 3 states
+  std::vector<sv_index_type> const dims = {3, 2, 3};
+
+  // Reference list of basis states within the sector
+  auto sector_states_ref = [&](unsigned int N) {
+    std::vector<sv_index_type> states;
+    for(sv_index_type index = 0; index < hs.dim(); ++index) {
+      if(popcount(index, M) != N) continue;
+      // Boson and spin 1 (spin 1/2 occupies bit M + 2)
+      sv_index_type n_b = (index >> M) & 3;
+      sv_index_type n_s1 = (index >> (M + 3)) & 3;
+      if(n_b < dims[0] && n_s1 < dims[2]) states.push_back(index);
+    }
+    return states;
+  };
+
+  SECTION("nonfermion_dims()") {
+    CHECK(nonfermion_dims(hs) == std::vector<sv_index_type>{4, 2, 3});
+    CHECK(nonfermion_dims(hs_type(make_space_fermion(0))).empty());
+  }
+
+  SECTION("n_fermion_sector_size") {
+    for(unsigned int N = 0; N <= M; ++N) {
+      CHECK(n_fermion_sector_size(hs, N, dims) ==
+            detail::binomial(M, N) * 18);
+      CHECK(n_fermion_sector_size(hs, N, nonfermion_dims(hs)) ==
+            detail::binomial(M, N) * 24);
+    }
+    CHECK_THROWS_AS(n_fermion_sector_size(hs, M + 1, dims),
+                    std::runtime_error);
+    for(auto const& wrong_dims : {std::vector<sv_index_type>{3, 2},
+                                  std::vector<sv_index_type>{3, 2, 3, 1},
+                                  std::vector<sv_index_type>{5, 2, 3},
+                                  std::vector<sv_index_type>{0, 2, 3}}) {
+      CHECK_THROWS_AS(n_fermion_sector_size(hs, 1, wrong_dims),
+                      std::invalid_argument);
+    }
+  }
+
+  SECTION("map_index() and n_fermion_sector_basis_states()") {
+    for(unsigned int N = 0; N <= M; ++N) {
+      state_vector st{};
+      view_type view(st, hs, N, dims);
+      auto states = sector_states_ref(N);
+      REQUIRE(view.size() == states.size());
+
+      std::vector<sv_index_type> basis_states(states.size());
+      for(auto index : states) {
+        auto n = view.map_index(index);
+        REQUIRE(n < states.size());
+        basis_states[n] = index;
+      }
+      std::vector<sv_index_type> sorted_states = basis_states;
+      std::sort(sorted_states.begin(), sorted_states.end());
+      CHECK(sorted_states == states);
+
+      CHECK(n_fermion_sector_basis_states(hs, N, dims) == basis_states);
+      for(sv_index_type n = 0; n < states.size(); ++n)
+        CHECK(view.inverse_map_index(n) == basis_states[n]);
+    }
+  }
+
+  SECTION("foreach()") {
+    for(unsigned int N = 0; N <= M; ++N) {
+      state_vector st(n_fermion_sector_size(hs, N, dims));
+      view_type view(st, hs, N, dims);
+
+      std::iota(st.begin(), st.end(), 1);
+      sv_index_type count = 0;
+      foreach(view, [&](sv_index_type index, double a) {
+        CHECK(sv_index_type(a) == view.map_index(index) + 1);
+        ++count;
+      });
+      CHECK(count == st.size());
+
+      for(sv_index_type chunk : {1, 7, 1000}) {
+        count = 0;
+        for(sv_index_type begin = 0; begin < st.size(); begin += chunk) {
+          auto end = std::min(begin + chunk, sv_index_type(st.size()));
+          foreach(view, begin, end, [&](sv_index_type index, double a) {
+            CHECK(sv_index_type(a) == ++count);
+            CHECK(view.map_index(index) == count - 1);
+          });
+          CHECK(count == end);
+        }
+        CHECK(count == st.size());
+      }
+    }
+  }
+
+  SECTION("get_element() and update_add_element()") {
+    for(unsigned int N = 0; N <= M; ++N) {
+      state_vector st(n_fermion_sector_size(hs, N, dims));
+      view_type view(st, hs, N, dims);
+      std::iota(st.begin(), st.end(), 1);
+
+      auto states = sector_states_ref(N);
+      for(sv_index_type index = 0; index < hs.dim(); ++index) {
+        if(popcount(index, M) != N) continue;
+        if(std::binary_search(states.begin(), states.end(), index)) {
+          CHECK(get_element(view, index) == view.map_index(index) + 1);
+        } else {
+          // Outside of the truncated non-fermionic spaces
+          CHECK(get_element(view, index) == 0);
+          update_add_element(view, index, 100.0);
+        }
+      }
+      // Updates outside of the truncated spaces are discarded
+      for(sv_index_type n = 0; n < st.size(); ++n)
+        CHECK(st[n] == n + 1);
+    }
+  }
+
+  SECTION("make_nfs_mixed_radix_view() and "
+          "make_const_nfs_mixed_radix_view()") {
+    state_vector st{};
+    auto view_st = make_nfs_mixed_radix_view(st, hs, 1, dims);
+    auto view_tmp = make_nfs_mixed_radix_view(state_vector{}, hs, 1, dims);
+    auto cview_st = make_const_nfs_mixed_radix_view(st, hs, 1, dims);
+    auto cview_tmp =
+        make_const_nfs_mixed_radix_view(state_vector{}, hs, 1, dims);
+
+    CHECK(std::is_same<
+          decltype(view_st),
+          n_fermion_sector_mixed_radix_view<state_vector, true>>::value);
+    CHECK(std::is_same<
+          decltype(view_tmp),
+          n_fermion_sector_mixed_radix_view<state_vector, false>>::value);
+    CHECK(std::is_same<
+          decltype(cview_st),
+          n_fermion_sector_mixed_radix_view<state_vector const, true>>::value);
+    CHECK(std::is_same<decltype(cview_tmp),
+                       n_fermion_sector_mixed_radix_view<state_vector const,
+                                                         false>>::value);
+  }
+
+  SECTION("loperator") {
+    // Holstein-like model with a truncated phonon mode
+    auto H = -(c_dag(0) * c(1) + c_dag(1) * c(0) + c_dag(2) * c(3) +
+               c_dag(3) * c(2)) +
+             0.7 * (n(0) + n(2)) * (a_dag(0) + a(0)) +
+             0.3 * (S_p<3>(0) * S_m(1) + S_m<3>(0) * S_p(1)) +
+             2.0 * a_dag(0) * a(0);
+    auto Hop = make_loperator(H, hs);
+
+    for(unsigned int N = 0; N <= M; ++N) {
+      auto size = n_fermion_sector_size(hs, N, dims);
+      state_vector in(size);
+      std::iota(in.begin(), in.end(), 1);
+      state_vector out(size);
+      Hop(make_const_nfs_mixed_radix_view(in, hs, N, dims),
+          make_nfs_mixed_radix_view(out, hs, N, dims));
+
+      // Reference: Action of the projected operator in the full Hilbert space
+      auto view = make_const_nfs_mixed_radix_view(in, hs, N, dims);
+      state_vector in_full(hs.dim(), 0);
+      for(sv_index_type n = 0; n < size; ++n)
+        in_full[view.inverse_map_index(n)] = in[n];
+      state_vector out_full = Hop(in_full);
+      state_vector out_ref(size);
+      for(sv_index_type n = 0; n < size; ++n)
+        out_ref[n] = out_full[view.inverse_map_index(n)];
+
+      CHECK_THAT(out, Catch::Matchers::Approx(out_ref));
+    }
+  }
+}
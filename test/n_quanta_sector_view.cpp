@@ -0,0 +1,250 @@
+/*******************************************************************************
+ *
+ * This file is part of libcommute, a quantum operator algebra DSL and
+ * exact diagonalization toolkit for C++11/14/17.
+ *
+ * Copyright (C) 2016-2021 Igor Krivenko <igor.s.krivenko@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ ******************************************************************************/
+
+#include <catch.hpp>
+
+#include <libcommute/expression/factories.hpp>
+#include <libcommute/loperator/elementary_space_boson.hpp>
+#include <libcommute/loperator/elementary_space_fermion.hpp>
+#include <libcommute/loperator/elementary_space_spin.hpp>
+#include <libcommute/loperator/hilbert_space.hpp>
+#include <libcommute/loperator/loperator.hpp>
+#include <libcommute/loperator/n_quanta_sector_view.hpp>
+
+#include <algorithm>
+#include <functional>
+#include <numeric>
+#include <set>
+#include <type_traits>
+#include <vector>
+
+using namespace libcommute;
+
+using hs_type = hilbert_space<int>;
+
+// Total number of quanta in elementary spaces with given algebra IDs.
+// Returns -1 if 'index' does not correspond to a valid basis state of those
+// elementary spaces.
+int n_quanta(hs_type const& hs,
+             sv_index_type index,
+             std::set<int> const& algebra_ids) {
+  int count = 0;
+  hs.for_each_elementary_space(
+      [&](elementary_space<int> const& es, bit_range_t const& range) {
+        if(count < 0 || algebra_ids.count(es.algebra_id()) == 0) return;
+        sv_index_type n = (index >> range.first) &
+                          ((sv_index_type(1) << es.n_bits()) - 1);
+        count = n < es.dim() ? count + int(n) : -1;
+      });
+  return count;
+}
+
+// List of basis states with N quanta in the order of their indices
+std::vector<sv_index_type>
+sector_states_ref(hs_type const& hs,
+                  unsigned int N,
+                  std::set<int> const& algebra_ids) {
+  std::vector<sv_index_type> states;
+  for(sv_index_type index = 0; index < hs.dim(); ++index) {
+    if(n_quanta(hs, index, algebra_ids) == int(N)) states.push_back(index);
+  }
+  return states;
+}
+
+TEST_CASE("View of a state vector projected on a sector with N quanta",
+          "[n_quanta_sector_view]") {
+  using namespace static_indices;
+
+  using state_vector = std::vector<double>;
+  using view_type = n_quanta_sector_view<state_vector>;
+
+  std::set<int> const default_ids = default_n_quanta_algebra_ids();
+  std::set<int> const fermion_boson_ids = {fermion, boson};
+
+  // Chain of spins 1/2
+  hs_type hs_spin_half;
+  for(int i = 0; i < 6; ++i)
+    hs_spin_half.add(make_space_spin(0.5, i));
+
+  // Spins 1 and 3/2, whose dimensions are not powers of 2
+  hs_type hs_spin(make_space_spin(1.0, 0),
+                  make_space_spin(1.0, 1),
+                  make_space_spin(1.5, 2),
+                  make_space_spin(1.0, 3));
+
+  // Fermions, bosons and spins
+  hs_type hs_mixed(make_space_fermion(0),
+                   make_space_fermion(1),
+                   make_space_boson(2, 0),
+                   make_space_boson(2, 1),
+                   make_space_spin(0.5, 0),
+                   make_space_spin(1.0, 1));
+
+  // Call f(hs, N, algebra_ids) for all tested sectors
+  auto for_each_sector = [&](std::function<void(hs_type const&,
+                                                unsigned int,
+                                                std::set<int> const&)> f) {
+    for(unsigned int N = 0; N <= 7; ++N)
+      f(hs_spin_half, N, default_ids);
+    for(unsigned int N = 0; N <= 10; ++N)
+      f(hs_spin, N, default_ids);
+    for(unsigned int N = 0; N <= 10; ++N)
+      f(hs_mixed, N, default_ids);
+    for(unsigned int N = 0; N <= 9; ++N)
+      f(hs_mixed, N, fermion_boson_ids);
+  };
+
+  SECTION("n_quanta_sector_size") {
+    for(unsigned int N = 0; N <= 6; ++N) {
+      CHECK(n_quanta_sector_size(hs_spin_half, N) ==
+            detail::binomial(6, N));
+    }
+    CHECK(n_quanta_sector_size(hs_spin_half, 7) == 0);
+
+    for_each_sector([](hs_type const& hs,
+                       unsigned int N,
+                       std::set<int> const& algebra_ids) {
+      CHECK(n_quanta_sector_size(hs, N, algebra_ids) ==
+            sector_states_ref(hs, N, algebra_ids).size());
+    });
+  }
+
+  SECTION("map_index()") {
+    for_each_sector([](hs_type const& hs,
+                       unsigned int N,
+                       std::set<int> const& algebra_ids) {
+      state_vector st{};
+      view_type view(st, hs, N, algebra_ids);
+      auto states = sector_states_ref(hs, N, algebra_ids);
+      CHECK(view.size() == states.size());
+
+      std::vector<sv_index_type> mapped_states(states.size());
+      for(auto index : states) {
+        auto n = view.map_index(index);
+        REQUIRE(n < states.size());
+        mapped_states[n] = index;
+      }
+      // Basis states with the same non-sector bits are ordered by their
+      // indices
+      for(std::size_t n = 0; n + 1 < mapped_states.size(); ++n) {
+        auto ns1 = view.nonsector_gather(mapped_states[n]);
+        auto ns2 = view.nonsector_gather(mapped_states[n + 1]);
+        if(ns1 == ns2) CHECK(mapped_states[n] < mapped_states[n + 1]);
+      }
+      std::sort(mapped_states.begin(), mapped_states.end());
+      CHECK(mapped_states == states);
+    });
+  }
+
+  SECTION("foreach()") {
+    for_each_sector([](hs_type const& hs,
+                       unsigned int N,
+                       std::set<int> const& algebra_ids) {
+      state_vector st(n_quanta_sector_size(hs, N, algebra_ids));
+      view_type view(st, hs, N, algebra_ids);
+
+      // Start from 1 so that none of st's elements is vanishing
+      std::iota(st.begin(), st.end(), 1);
+      sv_index_type count = 0;
+      foreach(view, [&](sv_index_type index, double a) {
+        CHECK(sv_index_type(a) == view.map_index(index) + 1);
+        ++count;
+      });
+      CHECK(count == st.size());
+
+      // inverse_map_index() is the inverse of map_index()
+      for(sv_index_type n = 0; n < st.size(); ++n)
+        CHECK(view.map_index(view.inverse_map_index(n)) == n);
+
+      // Process elements of 'st' in chunks
+      for(sv_index_type chunk : {1, 3, 1000}) {
+        count = 0;
+        for(sv_index_type begin = 0; begin < st.size(); begin += chunk) {
+          auto end = std::min(begin + chunk, sv_index_type(st.size()));
+          foreach(view, begin, end, [&](sv_index_type index, double a) {
+            CHECK(sv_index_type(a) == ++count);
+            CHECK(view.map_index(index) == count - 1);
+          });
+          CHECK(count == end);
+        }
+        CHECK(count == st.size());
+      }
+      foreach(view, 1, 1, [](sv_index_type, double) { CHECK(false); });
+    });
+  }
+
+  SECTION("n_quanta_sector_basis_states()") {
+    for_each_sector([](hs_type const& hs,
+                       unsigned int N,
+                       std::set<int> const& algebra_ids) {
+      state_vector st{};
+      view_type view(st, hs, N, algebra_ids);
+      auto states = sector_states_ref(hs, N, algebra_ids);
+      std::vector<sv_index_type> ref(states.size());
+      for(auto index : states)
+        ref[view.map_index(index)] = index;
+      CHECK(n_quanta_sector_basis_states(hs, N, algebra_ids) == ref);
+    });
+  }
+
+  SECTION("make_nqs_view() and make_const_nqs_view()") {
+    state_vector st{};
+    state_vector const& st_cref = st;
+
+    auto view_st = make_nqs_view(st, hs_spin_half, 3);
+    auto view_tmp = make_nqs_view(state_vector{}, hs_spin_half, 3);
+    auto cview_st = make_const_nqs_view(st_cref, hs_spin_half, 3);
+    auto cview_tmp = make_const_nqs_view(state_vector{}, hs_spin_half, 3);
+
+    CHECK(std::is_same<decltype(view_st),
+                       n_quanta_sector_view<state_vector, true>>::value);
+    CHECK(std::is_same<decltype(view_tmp),
+                       n_quanta_sector_view<state_vector, false>>::value);
+    CHECK(std::is_same<decltype(cview_st),
+                       n_quanta_sector_view<state_vector const, true>>::value);
+    CHECK(
+        std::is_same<decltype(cview_tmp),
+                     n_quanta_sector_view<state_vector const, false>>::value);
+  }
+
+  SECTION("loperator") {
+    // Jaynes-Cummings-like model with two spins
+    auto H = 2.0 * a_dag(0) * a(0) + S_z(0) + S_z(1) +
+             0.5 * (a_dag(0) * S_m(0) + S_p(0) * a(0)) +
+             0.3 * (a_dag(0) * S_m(1) + S_p(1) * a(0));
+    hs_type hs(make_space_spin(0.5, 0),
+               make_space_spin(0.5, 1),
+               make_space_boson(3, 0));
+    auto Hop = make_loperator(H, hs);
+
+    for(unsigned int N = 0; N <= 9; ++N) {
+      auto size = n_quanta_sector_size(hs, N);
+      state_vector in(size);
+      std::iota(in.begin(), in.end(), 1);
+      state_vector out(size);
+      Hop(make_const_nqs_view(in, hs, N), make_nqs_view(out, hs, N));
+
+      // Reference: Action of H in the full Hilbert space
+      auto view = make_const_nqs_view(in, hs, N);
+      state_vector in_full(hs.dim(), 0);
+      for(sv_index_type n = 0; n < size; ++n)
+        in_full[view.inverse_map_index(n)] = in[n];
+      state_vector out_full = Hop(in_full);
+      state_vector out_ref(size);
+      for(sv_index_type n = 0; n < size; ++n)
+        out_ref[n] = out_full[view.inverse_map_index(n)];
+
+      CHECK_THAT(out, Catch::Matchers::Approx(out_ref));
+    }
+  }
+}
@@ -0,0 +1,146 @@
+/*******************************************************************************
+ *
+ * This file is part of libcommute, a quantum operator algebra DSL and
+ * exact diagonalization toolkit for C++11/14/17.
+ *
+ * Copyright (C) 2016-2021 Igor Krivenko <igor.s.krivenko@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ ******************************************************************************/
+
+#include <catch.hpp>
+
+#include <libcommute/expression/factories.hpp>
+#include <libcommute/loperator/out_of_core_space_partition.hpp>
+#include <libcommute/loperator/space_partition.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace libcommute;
+
+TEST_CASE("Out-of-core Hilbert space partition",
+          "[out_of_core_space_partition]") {
+  using namespace static_indices;
+
+  // 3 orbital Hubbard-Kanamori atom
+  int const n_orbs = 3;
+  double const mu = 0.7;
+  double const U = 3.0;
+  double const J = 0.3;
+
+  expression<double, std::string, int> H;
+  for(int o = 0; o < n_orbs; ++o) {
+    H += -mu * (n("up", o) + n("dn", o));
+    H += U * n("up", o) * n("dn", o);
+  }
+  for(int o1 = 0; o1 < n_orbs; ++o1) {
+    for(int o2 = 0; o2 < n_orbs; ++o2) {
+      if(o1 == o2) continue;
+      H += (U - 2 * J) * n("up", o1) * n("dn", o2);
+      if(o2 < o1) {
+        H += (U - 3 * J) * n("up", o1) * n("up", o2);
+        H += (U - 3 * J) * n("dn", o1) * n("dn", o2);
+      }
+      H += -J * c_dag("up", o1) * c_dag("dn", o1) * c("up", o2) * c("dn", o2);
+      H += -J * c_dag("up", o1) * c_dag("dn", o2) * c("up", o2) * c("dn", o1);
+    }
+  }
+
+  auto hs = make_hilbert_space(H);
+  auto Hop = make_loperator(H, hs);
+
+  auto ref_sp = space_partition(Hop, hs);
+  auto ref_bases = ref_sp.subspace_bases();
+
+  std::string const path = "out_of_core_space_partition.subspaces";
+
+  auto check_partition = [&](out_of_core_space_partition const& sp) {
+    CHECK(sp.path() == path);
+    CHECK(sp.dim() == 64);
+    CHECK(sp.n_subspaces() == 44);
+
+    for(sv_index_type n = 0; n < sp.dim(); ++n)
+      CHECK(sp[n] == ref_sp[n]);
+    CHECK_THROWS_AS(sp[64], std::out_of_range);
+
+    for(sv_index_type s = 0; s < sp.n_subspaces(); ++s) {
+      CHECK(sp.subspace_size(s) == ref_sp.subspace_size(s));
+      CHECK(sp.subspace_basis(s) == ref_bases[s]);
+    }
+    CHECK_THROWS_AS(sp.subspace_size(44), std::runtime_error);
+
+    sv_index_type count = 0;
+    foreach(sp, [&](sv_index_type i, sv_index_type subspace) {
+      CHECK(i == count++);
+      CHECK(subspace == ref_sp[i]);
+    });
+    CHECK(count == 64);
+  };
+
+  SECTION("Construction") {
+    for(sv_index_type buffer_size : {1, 3, 1000}) {
+      out_of_core_space_partition sp(Hop, hs, path, buffer_size);
+      check_partition(sp);
+      // The buffer file must be removed
+      CHECK_FALSE(std::ifstream(path + ".links").good());
+    }
+    CHECK_THROWS_AS(out_of_core_space_partition(Hop, hs, path, 0),
+                    std::invalid_argument);
+  }
+
+  SECTION("Construction with a key") {
+    auto key = partition_key(H, hs);
+    {
+      out_of_core_space_partition sp(Hop, hs, path);
+      CHECK(sp.key() == 0);
+    }
+    CHECK(space_partition::can_load(path));
+    CHECK_FALSE(space_partition::can_load(path, key));
+    {
+      out_of_core_space_partition sp(Hop, hs, path, 3, key);
+      CHECK(sp.key() == key);
+      check_partition(sp);
+    }
+    CHECK(space_partition::can_load(path, key));
+    CHECK_FALSE(space_partition::can_load(path));
+    CHECK(out_of_core_space_partition(path).key() == key);
+    auto loaded_sp = space_partition::load(path, key);
+    for(sv_index_type n = 0; n < loaded_sp.dim(); ++n)
+      CHECK(loaded_sp[n] == ref_sp[n]);
+  }
+
+  SECTION("Reopening") {
+    { out_of_core_space_partition sp(Hop, hs, path); }
+    out_of_core_space_partition sp(path);
+    check_partition(sp);
+
+    CHECK_THROWS_AS(out_of_core_space_partition("nonexistent.subspaces"),
+                    std::system_error);
+
+    std::string const bad_path = "out_of_core_space_partition.bad";
+    {
+      std::ofstream bad_file(bad_path);
+      bad_file << "This is not a subspace file, but it is long enough";
+    }
+    CHECK_THROWS_AS(out_of_core_space_partition(bad_path), std::runtime_error);
+    std::remove(bad_path.c_str());
+  }
+
+  SECTION("Opening files written by space_partition::save()") {
+    matrix_elements_map<double> matrix_elements;
+    auto sp_with_me = space_partition(Hop, hs, matrix_elements);
+    sp_with_me.save(path, matrix_elements, 123);
+    out_of_core_space_partition sp(path);
+    CHECK(sp.key() == 123);
+    check_partition(sp);
+  }
+
+  std::remove(path.c_str());
+}
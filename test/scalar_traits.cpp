@@ -101,6 +101,17 @@ TEST_CASE("Traits of scalar types", "[scalar_traits]") {
   }
 }
 
+TEST_CASE("Accumulator types", "[accumulator_type]") {
+  CHECK(std::is_same<accumulator_type_t<long>, long>::value);
+  CHECK(std::is_same<accumulator_type_t<float>, double>::value);
+  CHECK(std::is_same<accumulator_type_t<double>, double>::value);
+  CHECK(std::is_same<accumulator_type_t<std::complex<float>>,
+                     std::complex<double>>::value);
+  CHECK(std::is_same<accumulator_type_t<std::complex<double>>,
+                     std::complex<double>>::value);
+  CHECK(std::is_same<accumulator_type_t<my_complex>, my_complex>::value);
+}
+
 TEST_CASE("Result types of arithmetic operations", "[arithmetic_result_type]") {
   using cmplx = std::complex<double>;
 
@@ -0,0 +1,159 @@
+/*******************************************************************************
+ *
+ * This file is part of libcommute, a quantum operator algebra DSL and
+ * exact diagonalization toolkit for C++11/14/17.
+ *
+ * Copyright (C) 2016-2021 Igor Krivenko <igor.s.krivenko@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ ******************************************************************************/
+
+#include <catch.hpp>
+
+#include <libcommute/expression/factories.hpp>
+#include <libcommute/loperator/elementary_space_fermion.hpp>
+#include <libcommute/loperator/hilbert_space.hpp>
+#include <libcommute/loperator/loperator.hpp>
+#include <libcommute/loperator/sharded_state_vector.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+using namespace libcommute;
+
+// Run `f(transport)` on each rank of an in-process group in a separate thread
+template <typename F> void run_ranks(int n_ranks, F&& f) {
+  in_process_group group(n_ranks);
+  std::vector<std::thread> threads;
+  for(int r = 0; r < n_ranks; ++r) {
+    threads.emplace_back([&group, &f, r]() {
+      in_process_transport transport(group, r);
+      f(transport);
+    });
+  }
+  for(auto& t : threads)
+    t.join();
+}
+
+TEST_CASE("Partition of basis states into blocks", "[block_partition]") {
+  block_partition p(10, 4);
+  CHECK(p.dim() == 10);
+  CHECK(p.n_blocks() == 4);
+  std::vector<sv_index_type> begins = {0, 3, 6, 9}, ends = {3, 6, 9, 10};
+  for(int b = 0; b < 4; ++b) {
+    CHECK(p.begin(b) == begins[b]);
+    CHECK(p.end(b) == ends[b]);
+    for(auto n = p.begin(b); n < p.end(b); ++n)
+      CHECK(p.block(n) == b);
+  }
+
+  block_partition p2(2, 4);
+  CHECK(p2.end(1) == 2);
+  CHECK(p2.begin(2) == p2.end(2));
+
+  CHECK_THROWS_AS(block_partition(10, 0), std::invalid_argument);
+}
+
+TEST_CASE("State vector sharded between ranks", "[sharded_state_vector]") {
+  using namespace static_indices;
+
+  using state_vector = sharded_state_vector<std::complex<double>,
+                                            in_process_transport>;
+  CHECK(std::is_same<element_type_t<state_vector>,
+                     std::complex<double>>::value);
+  CHECK_THROWS_AS(in_process_group(0), std::invalid_argument);
+
+  int const L = 8;
+  hilbert_space<int> hs;
+  for(int i = 0; i < L; ++i)
+    hs.add(make_space_fermion(i));
+
+  expression<std::complex<double>, int> H;
+  for(int i = 0; i < L; ++i) {
+    int j = (i + 1) % L;
+    H += std::complex<double>(-1.0, 0.3) * c_dag(i) * c(j);
+    H += std::complex<double>(-1.0, -0.3) * c_dag(j) * c(i);
+    H += 0.5 * n(i) * n(j);
+  }
+  auto Hop = make_loperator(H, hs);
+
+  std::vector<std::complex<double>> in(hs.dim());
+  for(sv_index_type n = 0; n < hs.dim(); ++n)
+    in[n] = std::complex<double>(std::cos(0.1 * n), std::sin(0.3 * n));
+  auto out = Hop(in);
+  auto out2 = Hop(out);
+
+  // Catch2 assertions are not thread-safe. The ranks store the results in
+  // disjoint parts of shared arrays, which are checked afterwards.
+  for(int n_ranks : {1, 3, 4}) {
+    std::vector<std::complex<double>> res1(hs.dim()), res2(hs.dim());
+    std::vector<sv_index_type> visited(hs.dim(), 0);
+    std::vector<int> pending(n_ranks), pending_after(n_ranks);
+    std::vector<int> zeros_after_reset(n_ranks);
+    std::vector<int> foreach_threw(n_ranks, 0);
+    std::vector<int> get_element_threw(n_ranks, 0);
+
+    run_ranks(n_ranks, [&](in_process_transport& transport) {
+      int r = transport.rank();
+      state_vector src(hs.dim(), transport);
+      for(auto n = src.local_begin(); n < src.local_end(); ++n)
+        update_add_element(src, n, in[n]);
+
+      state_vector dst = zeros_like(src);
+      Hop(src, dst);
+      pending[r] = int(dst.n_pending());
+      try {
+        foreach(dst, [](sv_index_type, std::complex<double> const&) {});
+      } catch(std::logic_error const&) {
+        foreach_threw[r] = 1;
+      }
+      dst.exchange();
+      pending_after[r] = int(dst.n_pending());
+
+      foreach(dst, [&](sv_index_type n, std::complex<double> const& a) {
+        // Only local amplitudes are visited
+        if(n >= dst.local_begin() && n < dst.local_end()) ++visited[n];
+        res1[n] = a;
+      });
+
+      // Second application reusing the source vector
+      apply_and_exchange(Hop, dst, src);
+      for(auto n = src.local_begin(); n < src.local_end(); ++n)
+        res2[n] = get_element(src, n);
+      // Amplitudes stored by other ranks cannot be read
+      try {
+        get_element(src, (src.local_end() % hs.dim()));
+      } catch(std::out_of_range const&) {
+        get_element_threw[r] = 1;
+      }
+
+      set_zeros(src);
+      zeros_after_reset[r] = std::all_of(src.local_data().begin(),
+                                         src.local_data().end(),
+                                         [](std::complex<double> const& a) {
+                                           return a == 0.0;
+                                         });
+    });
+
+    for(int r = 0; r < n_ranks; ++r) {
+      if(n_ranks > 1) CHECK(pending[r] > 0);
+      CHECK(foreach_threw[r] == (pending[r] > 0 ? 1 : 0));
+      CHECK(get_element_threw[r] == (n_ranks > 1 ? 1 : 0));
+      CHECK(pending_after[r] == 0);
+      CHECK(zeros_after_reset[r]);
+    }
+    for(sv_index_type n = 0; n < hs.dim(); ++n) {
+      CHECK(visited[n] == (std::abs(out[n]) < 1e-12 ? 0 : 1));
+      CHECK(std::abs(res1[n] - out[n]) < 1e-12);
+      CHECK(std::abs(res2[n] - out2[n]) < 1e-12);
+    }
+  }
+}
@@ -0,0 +1,159 @@
+/*******************************************************************************
+ *
+ * This file is part of libcommute, a quantum operator algebra DSL and
+ * exact diagonalization toolkit for C++11/14/17.
+ *
+ * Copyright (C) 2016-2021 Igor Krivenko <igor.s.krivenko@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ ******************************************************************************/
+
+#include <catch.hpp>
+
+#include <libcommute/expression/factories.hpp>
+#include <libcommute/loperator/elementary_space_fermion.hpp>
+#include <libcommute/loperator/hilbert_space.hpp>
+#include <libcommute/loperator/loperator.hpp>
+#include <libcommute/loperator/sorted_sparse_state_vector.hpp>
+#include <libcommute/loperator/sparse_state_vector.hpp>
+
+#include <map>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+using namespace libcommute;
+
+template <typename T>
+std::vector<std::pair<sv_index_type, T>>
+to_list(sorted_sparse_state_vector<T> const& v) {
+  std::vector<std::pair<sv_index_type, T>> l;
+  foreach(v, [&](sv_index_type n, T const& a) { l.emplace_back(n, a); });
+  return l;
+}
+
+TEST_CASE("Implementation of the StateVector concept based on a sorted sparse "
+          "storage",
+          "[sorted_sparse_state_vector]") {
+
+  SECTION("Basic operations") {
+    sorted_sparse_state_vector<double> v(100);
+    update_add_element(v, 2, 3);
+    update_add_element(v, 0, 1);
+    update_add_element(v, 1, 2);
+    update_add_element(v, 5, 0);
+
+    CHECK(std::is_same<element_type_t<decltype(v)>, double>::value);
+    CHECK(v.size() == 100);
+    CHECK(v.n_buffered() == 3);
+    CHECK(v.n_nonzeros() == 3);
+    CHECK(v.n_buffered() == 0);
+    sv_index_type prev = 0;
+    foreach(v, [&](sv_index_type i, double a) {
+      CHECK(i + 1 == a);
+      CHECK(i >= prev);
+      prev = i;
+    });
+
+    CHECK(get_element(v, 1) == 2);
+    update_add_element(v, 1, 4);
+    CHECK(get_element(v, 1) == 6);
+    CHECK(v.n_nonzeros() == 3);
+    update_add_element(v, 50, 10);
+    CHECK(get_element(v, 50) == 10);
+    CHECK(v.n_nonzeros() == 4);
+    update_add_element(v, 50, -10);
+    CHECK(get_element(v, 50) == 0);
+    CHECK(v.n_nonzeros() == 3);
+
+    // Contributions cancelling within the buffer
+    update_add_element(v, 60, 1);
+    update_add_element(v, 60, -1);
+    v.consolidate();
+    CHECK(v.n_buffered() == 0);
+    CHECK(v.n_nonzeros() == 3);
+
+    sorted_sparse_state_vector<double> v2(100);
+    update_add_element(v2, 1, -6);
+    update_add_element(v2, 3, 7);
+    v.merge(v2);
+    using list_t = std::vector<std::pair<sv_index_type, double>>;
+    CHECK(to_list(v) == list_t{{0, 1}, {2, 3}, {3, 7}});
+    v.merge(v);
+    CHECK(to_list(v) == list_t{{0, 2}, {2, 6}, {3, 14}});
+
+    v.prune([](double a) { return a > 5; });
+    CHECK(to_list(v) == list_t{{0, 2}});
+
+    auto v3 = zeros_like(v);
+    CHECK(v3.size() == 100);
+    CHECK(v3.n_nonzeros() == 0);
+    set_zeros(v);
+    CHECK(v.n_nonzeros() == 0);
+  }
+
+  SECTION("Random updates") {
+    std::mt19937_64 gen(1);
+    for(sv_index_type max_index :
+        {sv_index_type(1000), sv_index_type(1) << 40, ~sv_index_type(0)}) {
+      std::uniform_int_distribution<sv_index_type> index_d(0, max_index);
+      std::uniform_int_distribution<int> value_d(-3, 3);
+
+      sorted_sparse_state_vector<long> v(~sv_index_type(0));
+      std::map<sv_index_type, long> ref;
+      std::vector<sv_index_type> indices(20000);
+      for(auto& index : indices)
+        index = index_d(gen);
+      for(int pass = 0; pass < 3; ++pass) {
+        for(int i = 0; i < 20000; ++i) {
+          auto index = indices[(i * 7919) % indices.size()];
+          long value = value_d(gen);
+          update_add_element(v, index, value);
+          if((ref[index] += value) == 0) ref.erase(index);
+        }
+        CHECK(to_list(v) ==
+              std::vector<std::pair<sv_index_type, long>>(ref.begin(),
+                                                          ref.end()));
+      }
+    }
+  }
+
+  SECTION("Action of loperator") {
+    using namespace static_indices;
+
+    int const L = 10;
+    hilbert_space<int> hs;
+    for(int i = 0; i < L; ++i)
+      hs.add(make_space_fermion(i));
+
+    expression<double, int> H;
+    for(int i = 0; i < L; ++i) {
+      int j = (i + 1) % L;
+      H += -(c_dag(i) * c(j) + c_dag(j) * c(i)) + 0.3 * n(i) * n(j);
+    }
+    auto Hop = make_loperator(H, hs);
+
+    sorted_sparse_state_vector<double> in(hs.dim()), out(hs.dim());
+    sparse_state_vector<double> in_ref(hs.dim()), out_ref(hs.dim());
+    update_add_element(in, 0x3F, 1.0);
+    update_add_element(in_ref, 0x3F, 1.0);
+
+    // Repeated application of H
+    for(int k = 0; k < 4; ++k) {
+      Hop(in, out);
+      Hop(in_ref, out_ref);
+      REQUIRE(out.n_nonzeros() == out_ref.n_nonzeros());
+      sv_index_type prev = 0;
+      foreach(out, [&](sv_index_type i, double a) {
+        CHECK(i >= prev);
+        prev = i;
+        CHECK(a == Approx(get_element(out_ref, i)));
+      });
+      std::swap(in, out);
+      std::swap(in_ref, out_ref);
+    }
+  }
+}
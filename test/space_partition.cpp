@@ -18,6 +18,11 @@
 
 #include <algorithm>
 #include <cmath>
+#include <complex>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
 #include <set>
 #include <string>
 #include <vector>
@@ -155,6 +160,38 @@ TEST_CASE("Automatic Hilbert space partition", "[space_partition]") {
 
     CHECK(cl == ref_cl);
 
+    SECTION("Conserved quantities") {
+      expression<double, std::string, int> N_up, N_dn;
+      for(int o = 0; o < n_orbs; ++o) {
+        N_up += n("up", o);
+        N_dn += n("dn", o);
+      }
+
+      std::vector<decltype(Hop)> conserved{make_loperator(N_up, hs),
+                                           make_loperator(N_dn, hs)};
+      auto sp_qn = space_partition(Hop, hs, conserved);
+
+      CHECK(sp_qn.dim() == 64);
+      CHECK(sp_qn.n_subspaces() == 44);
+      foreach(sp_qn, [&](int i, int subspace) { CHECK(sp[i] == subspace); });
+
+      std::vector<decltype(Hop)> conserved_Sz{
+          make_loperator(0.5 * (N_up - N_dn), hs)};
+      auto sp_Sz = space_partition(Hop, hs, conserved_Sz);
+      CHECK(sp_Sz.n_subspaces() == 44);
+      foreach(sp_Sz, [&](int i, int subspace) { CHECK(sp[i] == subspace); });
+
+      std::vector<decltype(Hop)> non_diagonal{
+          make_loperator(c_dag("up", 0) * c("dn", 0), hs)};
+      CHECK_THROWS_AS(space_partition(Hop, hs, non_diagonal),
+                      std::runtime_error);
+
+      std::vector<decltype(Hop)> non_conserved{
+          make_loperator(n("up", 0), hs)};
+      CHECK_THROWS_AS(space_partition(Hop, hs, non_conserved),
+                      std::runtime_error);
+    }
+
     SECTION("subspace_bases()") {
       auto bases = sp.subspace_bases();
       CHECK(bases.size() == sp.n_subspaces());
@@ -169,8 +206,16 @@ TEST_CASE("Automatic Hilbert space partition", "[space_partition]") {
         auto basis = sp.subspace_basis(subspace);
         std::set<sv_index_type> basis_set{basis.cbegin(), basis.cend()};
         CHECK(ref_cl.count(basis_set) == 1);
+        CHECK(sp.subspace_size(subspace) == basis.size());
       }
       CHECK_THROWS_AS(sp.subspace_basis(sp.n_subspaces()), std::runtime_error);
+      CHECK_THROWS_AS(sp.subspace_size(sp.n_subspaces()), std::runtime_error);
+    }
+
+    SECTION("operator[]") {
+      for(sv_index_type i = 0; i < sp.dim(); ++i)
+        CHECK(sp[i] < sp.n_subspaces());
+      CHECK_THROWS_AS(sp[sp.dim()], std::out_of_range);
     }
   }
 
@@ -363,6 +408,14 @@ TEST_CASE("Automatic Hilbert space partition", "[space_partition]") {
     foreach(sp, [&](int i, int subspace) { v_cl[subspace].insert(i); });
     std::set<std::set<sv_index_type>> cl{v_cl.cbegin(), v_cl.cend()};
 
+    // Subspaces are enumerated in the order of appearance of their first
+    // basis state
+    for(sv_index_type subspace = 0; subspace < sp.n_subspaces(); ++subspace) {
+      CHECK(sp.subspace_size(subspace) == v_cl[subspace].size());
+      if(subspace > 0)
+        CHECK(*v_cl[subspace - 1].begin() < *v_cl[subspace].begin());
+    }
+
     std::vector<double> in_state(sp.dim());
 
     for(auto const& op : all_ops) {
@@ -441,4 +494,100 @@ TEST_CASE("Automatic Hilbert space partition", "[space_partition]") {
       }
     }
   }
+
+  SECTION("save() and load()") {
+    std::string const path = "space_partition.subspaces";
+    std::uint64_t key = partition_key(H, hs);
+    CHECK(key == partition_key(H, hs));
+    CHECK(key != partition_key(H + n("up", 0), hs));
+    CHECK(key != partition_key(H * 1.000001, hs));
+
+    matrix_elements_map<double> matrix_elements;
+    auto sp = space_partition(Hop, hs, matrix_elements);
+    // Make subspace numbers differ from those of a freshly computed partition
+    sp.merge_subspaces(make_loperator(c_dag("up", 0), hs),
+                       make_loperator(c("up", 0), hs),
+                       hs);
+
+    auto check_loaded = [&](space_partition const& sp_loaded) {
+      CHECK(sp_loaded.dim() == sp.dim());
+      CHECK(sp_loaded.n_subspaces() == sp.n_subspaces());
+      for(sv_index_type i = 0; i < sp.dim(); ++i)
+        CHECK(sp_loaded[i] == sp[i]);
+      CHECK(sp_loaded.subspace_bases() == sp.subspace_bases());
+      for(sv_index_type s = 0; s < sp.n_subspaces(); ++s)
+        CHECK(sp_loaded.subspace_size(s) == sp.subspace_size(s));
+    };
+
+    CHECK_FALSE(space_partition::can_load(path, key));
+
+    sp.save(path, key);
+    CHECK(space_partition::can_load(path, key));
+    CHECK_FALSE(space_partition::can_load(path, key + 1));
+    check_loaded(space_partition::load(path, key));
+    CHECK_THROWS_AS(space_partition::load(path), std::runtime_error);
+    matrix_elements_map<double> loaded_elements;
+    CHECK_THROWS_AS(space_partition::load(path, loaded_elements, key),
+                    std::runtime_error);
+
+    sp.save(path, matrix_elements);
+    CHECK(space_partition::can_load(path));
+    check_loaded(space_partition::load(path));
+    check_loaded(space_partition::load(path, loaded_elements));
+    CHECK(loaded_elements == matrix_elements);
+
+    // Type of matrix elements must match
+    CHECK(space_partition::can_load<double>(path));
+    CHECK_FALSE(space_partition::can_load<float>(path));
+    CHECK_FALSE(space_partition::can_load<std::complex<float>>(path));
+    CHECK_FALSE(space_partition::can_load<std::int64_t>(path));
+    matrix_elements_map<std::complex<float>> elements_cf;
+    CHECK_THROWS_AS(space_partition::load(path, elements_cf),
+                    std::runtime_error);
+    for(auto const& e : matrix_elements)
+      elements_cf.emplace(e.first, std::complex<float>(float(e.second)));
+    sp.save(path, elements_cf);
+    CHECK(space_partition::can_load<std::complex<float>>(path));
+    CHECK_FALSE(space_partition::can_load<double>(path));
+    CHECK_THROWS_AS(space_partition::load(path, loaded_elements),
+                    std::runtime_error);
+    matrix_elements_map<std::complex<float>> loaded_elements_cf;
+    check_loaded(space_partition::load(path, loaded_elements_cf));
+    CHECK(loaded_elements_cf == elements_cf);
+
+    // Corrupted and truncated files
+    detail::subspace_file_layout layout{
+        sp.dim(),
+        sp.n_subspaces(),
+        detail::subspace_file_index_width(sp.dim())};
+    REQUIRE(layout.index_width == 4);
+    auto overwrite = [&](std::size_t offset, std::uint32_t value) {
+      std::fstream fs(path, std::ios::binary | std::ios::in | std::ios::out);
+      fs.seekp(offset);
+      fs.write(reinterpret_cast<char const*>(&value), sizeof(value));
+    };
+
+    sp.save(path);
+    overwrite(layout.table_offset(), std::uint32_t(sp.n_subspaces()));
+    CHECK_THROWS_AS(space_partition::load(path), std::runtime_error);
+
+    sp.save(path);
+    overwrite(layout.sizes_offset(), std::uint32_t(sp.subspace_size(0) + 1));
+    CHECK_THROWS_AS(space_partition::load(path), std::runtime_error);
+
+    sp.save(path);
+    {
+      std::ifstream is(path, std::ios::binary);
+      std::vector<char> head(layout.sizes_offset());
+      is.read(head.data(), head.size());
+      is.close();
+      std::ofstream os(path, std::ios::binary | std::ios::trunc);
+      os.write(head.data(), head.size());
+    }
+    CHECK(space_partition::can_load(path));
+    CHECK_THROWS_AS(space_partition::load(path), std::runtime_error);
+
+    std::remove(path.c_str());
+    CHECK_THROWS_AS(space_partition::load(path), std::runtime_error);
+  }
 }
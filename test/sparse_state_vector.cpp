@@ -61,4 +61,42 @@ TEST_CASE("Implementation of the StateVector concept based on a sparse storage",
   CHECK(v3.n_nonzeros() == 2);
   CHECK(get_element(v3, 1) == 5);
   CHECK(get_element(v3, 11) == 7);
+
+  // Storage is retained by set_zeros()
+  sparse_state_vector<double> v4(1000);
+  v4.reserve(500);
+  auto capacity = v4.capacity();
+  CHECK(capacity >= 500);
+  for(int i = 0; i < 500; ++i)
+    update_add_element(v4, 2 * i, i + 1);
+  CHECK(v4.n_nonzeros() == 500);
+  CHECK(v4.capacity() == capacity);
+  set_zeros(v4);
+  CHECK(v4.n_nonzeros() == 0);
+  CHECK(v4.capacity() == capacity);
+  CHECK(get_element(v4, 2) == 0);
+
+  // References returned by operator[] stay valid as long as no element is
+  // inserted or erased
+  sparse_state_vector<double> v5(100);
+  v5[1] = 1;
+  v5[2] = 2;
+  double& a = v5[1];
+  CHECK(&v5[1] == &a);
+  update_add_element(v5, 1, 3);
+  update_add_element(v5, 2, 3);
+  CHECK(a == 4);
+  CHECK(get_element(v5, 50) == 0);
+  foreach(v5, [](sv_index_type, double) {});
+  a = 5;
+  CHECK(get_element(v5, 1) == 5);
+  CHECK(&v5[1] == &a);
+  // After an insertion, a reference has to be obtained again
+  for(int i = 10; i < 100; ++i)
+    v5[i] = i;
+  CHECK(v5[1] == 5);
+  CHECK(v5[2] == 5);
+  update_add_element(v5, 2, -5);
+  CHECK(v5.n_nonzeros() == 91);
+  CHECK(v5[1] == 5);
 }
@@ -15,7 +15,9 @@
 
 #include <libcommute/loperator/state_vector.hpp>
 
+#include <complex>
 #include <type_traits>
+#include <vector>
 
 using namespace libcommute;
 
@@ -60,4 +62,25 @@ TEST_CASE("Implementation of StateVector interface for std::vector",
               [](int i, std::complex<double> a) { CHECK(double(i + 1) == a); });
     }
   }
+
+  SECTION("is_zero_amplitude()") {
+    CHECK(is_zero_amplitude(0));
+    CHECK_FALSE(is_zero_amplitude(1));
+    CHECK(is_zero_amplitude(1e-20));
+    CHECK_FALSE(is_zero_amplitude(1e-10));
+    // Single precision amplitudes share the double precision tolerance
+    CHECK(scalar_traits<float>::is_zero(1e-10f));
+    CHECK_FALSE(is_zero_amplitude(1e-10f));
+    CHECK(is_zero_amplitude(1e-20f));
+    CHECK_FALSE(is_zero_amplitude(std::complex<float>(0, 1e-10f)));
+    CHECK(is_zero_amplitude(std::complex<float>(1e-20f, 0)));
+
+    std::vector<float> v_fe{1e-10f, 0, 1e-20f};
+    int n_visited = 0;
+    foreach(v_fe, [&n_visited](int i, float) {
+      CHECK(i == 0);
+      ++n_visited;
+    });
+    CHECK(n_visited == 1);
+  }
 }
@@ -0,0 +1,316 @@
+/*******************************************************************************
+ *
+ * This file is part of libcommute, a quantum operator algebra DSL and
+ * exact diagonalization toolkit for C++11/14/17.
+ *
+ * Copyright (C) 2016-2021 Igor Krivenko <igor.s.krivenko@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ ******************************************************************************/
+
+#include <catch.hpp>
+
+#include <libcommute/expression/factories.hpp>
+#include <libcommute/loperator/elementary_space_fermion.hpp>
+#include <libcommute/loperator/elementary_space_spin.hpp>
+#include <libcommute/loperator/hilbert_space.hpp>
+#include <libcommute/loperator/loperator.hpp>
+#include <libcommute/loperator/n_fermion_sector_view.hpp>
+#include <libcommute/loperator/symmetry_sector_view.hpp>
+
+#include <cmath>
+#include <complex>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+using namespace libcommute;
+
+using hs_type = hilbert_space<int>;
+using cvector = std::vector<std::complex<double>>;
+
+// Explicitly constructed state |a_chi> in the full Hilbert space
+cvector make_symmetric_state(symmetry_sector const& sector,
+                             sv_index_type a,
+                             sv_index_type dim) {
+  cvector v(dim, 0);
+  auto const& group = sector.group();
+  for(std::size_t g = 0; g < group.size(); ++g) {
+    int sign;
+    sv_index_type x = group[g](a, sign);
+    v[x] += std::conj(sector.characters()[g]) * double(sign);
+  }
+  double norm = std::sqrt(
+      std::accumulate(v.begin(),
+                      v.end(),
+                      0.0,
+                      [](double s, std::complex<double> z) {
+                        return s + std::norm(z);
+                      }));
+  for(auto& z : v)
+    z /= norm;
+  return v;
+}
+
+std::complex<double> dot(cvector const& v1, cvector const& v2) {
+  std::complex<double> res = 0;
+  for(std::size_t i = 0; i < v1.size(); ++i)
+    res += std::conj(v1[i]) * v2[i];
+  return res;
+}
+
+// Compare action of a symmetric operator on a symmetry sector view with
+// the explicitly computed matrix elements
+template <typename LOp>
+void check_symmetry_sector(hs_type const& hs,
+                           LOp const& Hop,
+                           std::shared_ptr<symmetry_sector const> sector) {
+  auto size = sector->size();
+
+  std::vector<cvector> states;
+  for(sv_index_type n = 0; n < size; ++n)
+    states.push_back(
+        make_symmetric_state(*sector, sector->representative(n), hs.dim()));
+
+  cvector in(size), out(size);
+  auto view_in = make_const_symmetry_sector_view(in, sector);
+  auto view_out = make_symmetry_sector_view(out, sector);
+  for(sv_index_type n = 0; n < size; ++n) {
+    CHECK(view_in.map_index(sector->representative(n)) == n);
+    CHECK(view_in.inverse_map_index(n) == sector->representative(n));
+
+    std::fill(in.begin(), in.end(), 0);
+    in[n] = 1;
+
+    // get_element() returns amplitudes in the full Hilbert space
+    for(sv_index_type index = 0; index < hs.dim(); ++index) {
+      auto a = get_element(view_in, index);
+      CHECK(std::abs(a - states[n][index]) < 1e-12);
+    }
+
+    Hop(view_in, view_out);
+    cvector H_state = Hop(states[n]);
+    for(sv_index_type n2 = 0; n2 < size; ++n2) {
+      CHECK(std::abs(out[n2] - dot(states[n2], H_state)) < 1e-12);
+    }
+  }
+}
+
+TEST_CASE("Symmetry transformation of basis states", "[basis_symmetry]") {
+  using namespace static_indices;
+
+  SECTION("Spins") {
+    // Linear indices: 0 - spin 1/2 (bit 0), 1 and 2 - spins 1 (bits 1-2, 3-4)
+    hs_type hs(make_space_spin(1.0, 0),
+               make_space_spin(1.0, 1),
+               make_space_spin(0.5, 2));
+
+    basis_symmetry flip_all(hs, {}, {0, 1, 2});
+    // |m_2 = -1/2, m_0 = 1, m_1 = 1> -> |1/2, -1, -1>
+    CHECK(flip_all(0x14) == 0x1);
+    CHECK(flip_all.sign(0x14) == 1);
+    // |m_2 = 1/2, m_0 = 0, m_1 = -1> -> |-1/2, 0, 1>
+    CHECK(flip_all(0x3) == 0x12);
+
+    basis_symmetry swap_flip(hs, {0, 2, 1}, {1});
+    // |m_2 = -1/2, m_0 = 1, m_1 = -1> -> |-1/2, 1, 1>
+    CHECK(swap_flip(0x4) == 0x14);
+
+    basis_symmetry parity(hs, {}, {}, {1, 2});
+    CHECK(parity(0xA) == 0xA);
+    CHECK(parity.sign(0xA) == 1);
+    CHECK(parity.sign(0x2) == -1);
+    CHECK(parity.sign(0x5) == 1);
+
+    CHECK_THROWS_AS(basis_symmetry(hs, {}, {3}), std::invalid_argument);
+    CHECK_THROWS_AS(basis_symmetry(hs, {}, {0, 0}), std::invalid_argument);
+    CHECK_THROWS_AS(basis_symmetry(hs, {}, {}, {-1}), std::invalid_argument);
+  }
+
+  SECTION("Fermions") {
+    hs_type hs;
+    for(int i = 0; i < 4; ++i)
+      hs.add(make_space_fermion(i));
+
+    // Compare with the action of
+    // (-1)^{n_1} (-1)^{n_3} (c_0 + c^+_0)(c_2 + c^+_2)(c_3 + c^+_3) T,
+    // where T = c^+_0 c_1 + c^+_1 c_0 swaps modes 0 and 1 when only one of
+    // them is occupied.
+    basis_symmetry g(hs, {1, 0, 2, 3}, {0, 2, 3}, {1, 3});
+
+    auto Z = (1.0 - 2.0 * n(1)) * (1.0 - 2.0 * n(3));
+    auto F = (c(0) + c_dag(0)) * (c(2) + c_dag(2)) * (c(3) + c_dag(3));
+    auto T = c_dag(0) * c(1) + c_dag(1) * c(0);
+    auto gop = make_loperator(Z * F * T, hs);
+
+    for(sv_index_type index = 0; index < hs.dim(); ++index) {
+      if((index & 0x3) == 0x0 || (index & 0x3) == 0x3) continue;
+      std::vector<double> in(hs.dim(), 0);
+      in[index] = 1;
+      auto out = gop(in);
+      for(sv_index_type index2 = 0; index2 < hs.dim(); ++index2)
+        CHECK(out[index2] == (index2 == g(index) ? g.sign(index) : 0));
+    }
+  }
+}
+
+TEST_CASE("View of a state vector in a symmetry sector",
+          "[symmetry_sector_view]") {
+  using namespace static_indices;
+
+  SECTION("Heisenberg ring") {
+    int const L = 6;
+    hs_type hs;
+    for(int i = 0; i < L; ++i)
+      hs.add(make_space_spin(0.5, i));
+
+    expression<double, int> H;
+    for(int i = 0; i < L; ++i) {
+      int j = (i + 1) % L;
+      H += S_z(i) * S_z(j) + 0.5 * (S_p(i) * S_m(j) + S_m(i) * S_p(j));
+    }
+    auto Hop = make_loperator(H, hs);
+
+    std::vector<int> all_spaces(L);
+    std::iota(all_spaces.begin(), all_spaces.end(), 0);
+
+    // Dihedral group D_6 times the global spin flip
+    std::vector<basis_symmetry> group;
+    for(int f = 0; f < 2; ++f) {
+      for(int r = 0; r < 2; ++r) {
+        for(int j = 0; j < L; ++j) {
+          std::vector<int> perm(L);
+          for(int i = 0; i < L; ++i)
+            perm[i] = ((r ? L - i : i) + j) % L;
+          group.emplace_back(hs, perm, f ? all_spaces : std::vector<int>{});
+        }
+      }
+    }
+
+    std::vector<sv_index_type> all_states(hs.dim());
+    std::iota(all_states.begin(), all_states.end(), 0);
+
+    // One-dimensional representations with k = 0, pi
+    for(int m : {0, 1}) {
+      for(int p : {1, -1}) {
+        for(int z : {1, -1}) {
+          cvector characters;
+          for(int f = 0; f < 2; ++f) {
+            for(int r = 0; r < 2; ++r) {
+              for(int j = 0; j < L; ++j)
+                characters.emplace_back(((m * j) % 2 ? -1 : 1) * (r ? p : 1) *
+                                        (f ? z : 1));
+            }
+          }
+          auto sector = make_symmetry_sector(group, characters, all_states);
+          check_symmetry_sector(hs, Hop, sector);
+        }
+      }
+    }
+
+    // Sum of dimensions of all sectors of the cyclic subgroup
+    sv_index_type total_size = 0;
+    std::vector<basis_symmetry> translations(group.begin(), group.begin() + L);
+    for(int m = 0; m < L; ++m) {
+      cvector characters;
+      for(int j = 0; j < L; ++j)
+        characters.push_back(std::polar(1.0, 2 * std::acos(-1.0) * m * j / L));
+      auto sector = make_symmetry_sector(translations, characters, all_states);
+      total_size += sector->size();
+      check_symmetry_sector(hs, Hop, sector);
+
+      // Complex characters require complex amplitudes
+      std::vector<double> st;
+      if(m == 0 || 2 * m == L)
+        CHECK_NOTHROW(make_symmetry_sector_view(st, sector));
+      else
+        CHECK_THROWS_AS(make_symmetry_sector_view(st, sector),
+                        std::invalid_argument);
+    }
+    CHECK(total_size == hs.dim());
+
+    CHECK_THROWS_AS(make_symmetry_sector({}, {}, all_states),
+                    std::invalid_argument);
+    CHECK_THROWS_AS(make_symmetry_sector(translations, {1.0}, all_states),
+                    std::invalid_argument);
+    CHECK_THROWS_AS(make_symmetry_sector(translations,
+                                         cvector(L, 2.0),
+                                         all_states),
+                    std::invalid_argument);
+
+    // No identity transformation
+    std::vector<basis_symmetry> no_identity(translations.begin() + 1,
+                                            translations.end());
+    CHECK_THROWS_AS(make_symmetry_sector(no_identity,
+                                         cvector(L - 1, 1.0),
+                                         all_states),
+                    std::invalid_argument);
+    // Character of the identity transformation is not 1
+    CHECK_THROWS_AS(make_symmetry_sector(translations,
+                                         cvector(L, -1.0),
+                                         all_states),
+                    std::invalid_argument);
+    // Not closed under composition
+    std::vector<basis_symmetry> not_closed(translations.begin(),
+                                           translations.begin() + 2);
+    CHECK_THROWS_AS(make_symmetry_sector(not_closed,
+                                         cvector(2, 1.0),
+                                         all_states),
+                    std::invalid_argument);
+  }
+
+  SECTION("Particle-hole symmetric fermions on a ring") {
+    int const L = 6;
+    hs_type hs;
+    for(int i = 0; i < L; ++i)
+      hs.add(make_space_fermion(i));
+
+    expression<double, int> H;
+    for(int i = 0; i < L; ++i) {
+      int j = (i + 1) % L;
+      H += -(c_dag(i) * c(j) + c_dag(j) * c(i)) +
+           0.5 * (n(i) - 0.5) * (n(j) - 0.5);
+    }
+    auto Hop = make_loperator(H, hs);
+
+    std::vector<int> all_spaces(L);
+    std::iota(all_spaces.begin(), all_spaces.end(), 0);
+    std::vector<int> sublattice = {0, 2, 4};
+
+    // Translations by 2 sites times the particle-hole transformation
+    // c_i -> \pm(-1)^i c^+_i
+    std::vector<basis_symmetry> group;
+    for(int f = 0; f < 2; ++f) {
+      for(int j = 0; j < L; j += 2) {
+        std::vector<int> perm(L);
+        for(int i = 0; i < L; ++i)
+          perm[i] = (i + j) % L;
+        group.emplace_back(hs,
+                           perm,
+                           f ? all_spaces : std::vector<int>{},
+                           f ? sublattice : std::vector<int>{});
+      }
+    }
+
+    auto half_filling = n_fermion_sector_basis_states(hs, L / 2);
+    sv_index_type total_size = 0;
+    for(int m = 0; m < 3; ++m) {
+      for(int z : {1, -1}) {
+        cvector characters;
+        for(int f = 0; f < 2; ++f) {
+          for(int j = 0; j < 3; ++j)
+            characters.push_back(
+                std::polar(1.0, 2 * std::acos(-1.0) * m * j / 3) *
+                double(f ? z : 1));
+        }
+        auto sector = make_symmetry_sector(group, characters, half_filling);
+        total_size += sector->size();
+        check_symmetry_sector(hs, Hop, sector);
+      }
+    }
+    CHECK(total_size == half_filling.size());
+  }
+}
@@ -0,0 +1,154 @@
+/*******************************************************************************
+ *
+ * This file is part of libcommute, a quantum operator algebra DSL and
+ * exact diagonalization toolkit for C++11/14/17.
+ *
+ * Copyright (C) 2016-2021 Igor Krivenko <igor.s.krivenko@gmail.com>
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ ******************************************************************************/
+
+#include <catch.hpp>
+
+#include <libcommute/expression/factories.hpp>
+#include <libcommute/loperator/elementary_space_fermion.hpp>
+#include <libcommute/loperator/hilbert_space.hpp>
+#include <libcommute/loperator/loperator.hpp>
+#include <libcommute/loperator/truncated_sparse_state_vector.hpp>
+
+#include <cmath>
+#include <complex>
+#include <map>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+using namespace libcommute;
+
+template <typename T>
+std::map<sv_index_type, T> to_map(truncated_sparse_state_vector<T> const& v) {
+  std::map<sv_index_type, T> m;
+  foreach(v, [&](sv_index_type n, T const& a) { m.emplace(n, a); });
+  return m;
+}
+
+TEST_CASE("Implementation of the StateVector concept based on a sparse storage "
+          "with truncation",
+          "[truncated_sparse_state_vector]") {
+
+  SECTION("Threshold") {
+    truncated_sparse_state_vector<double> v(100, 0.1);
+    CHECK(std::is_same<element_type_t<decltype(v)>, double>::value);
+    CHECK(v.size() == 100);
+    CHECK(v.threshold() == 0.1);
+    CHECK(v.max_nonzeros() == 0);
+
+    update_add_element(v, 1, 0.05);
+    update_add_element(v, 2, -0.05);
+    update_add_element(v, 3, 0.5);
+    update_add_element(v, 4, -0.5);
+    CHECK(v.n_nonzeros() == 2);
+    CHECK(get_element(v, 1) == 0);
+    CHECK(get_element(v, 4) == -0.5);
+
+    // Small contributions to stored amplitudes are not discarded
+    update_add_element(v, 3, 0.05);
+    CHECK(get_element(v, 3) == 0.55);
+    update_add_element(v, 3, -0.5);
+    CHECK(get_element(v, 3) == Approx(0.05));
+    update_add_element(v, 4, 0.5);
+    CHECK(v.n_nonzeros() == 1);
+
+    auto v2 = zeros_like(v);
+    CHECK(v2.threshold() == 0.1);
+    CHECK(v2.n_nonzeros() == 0);
+    set_zeros(v);
+    CHECK(v.n_nonzeros() == 0);
+
+    truncated_sparse_state_vector<std::complex<double>> vc(100, 1.0);
+    update_add_element(vc, 1, std::complex<double>(0.8, 0.8));
+    update_add_element(vc, 2, std::complex<double>(0.6, 0.6));
+    CHECK(vc.n_nonzeros() == 1);
+    CHECK(get_element(vc, 1) == std::complex<double>(0.8, 0.8));
+  }
+
+  SECTION("Fixed number of amplitudes") {
+    std::mt19937 gen(1);
+    std::uniform_int_distribution<sv_index_type> index_d(0, 999);
+    std::uniform_real_distribution<double> value_d(-1, 1);
+
+    std::size_t const K = 50;
+    truncated_sparse_state_vector<double> v(1000, 0.01, K);
+    CHECK(v.max_nonzeros() == K);
+
+    // Reference implementation with a linear search of the smallest amplitude
+    std::map<sv_index_type, double> ref;
+    for(int i = 0; i < 20000; ++i) {
+      auto n = index_d(gen);
+      double value = value_d(gen);
+      update_add_element(v, n, value);
+
+      auto it = ref.find(n);
+      if(it != ref.end()) {
+        it->second += value;
+      } else if(std::abs(value) >= 0.01) {
+        if(ref.size() == K) {
+          auto min_it = ref.begin();
+          for(auto it2 = ref.begin(); it2 != ref.end(); ++it2) {
+            if(std::abs(it2->second) < std::abs(min_it->second)) min_it = it2;
+          }
+          if(std::abs(min_it->second) < std::abs(value)) {
+            ref.erase(min_it);
+            ref.emplace(n, value);
+          }
+        } else
+          ref.emplace(n, value);
+      }
+
+      REQUIRE(v.n_nonzeros() <= K);
+    }
+    CHECK(v.n_nonzeros() == ref.size());
+    CHECK(to_map(v) == ref);
+
+    v.prune([](double a) { return std::abs(a) < 0.5; });
+    for(auto const& p : to_map(v))
+      CHECK(std::abs(p.second) >= 0.5);
+  }
+
+  SECTION("Action of loperator") {
+    using namespace static_indices;
+
+    int const L = 10;
+    hilbert_space<int> hs;
+    for(int i = 0; i < L; ++i)
+      hs.add(make_space_fermion(i));
+
+    // Hopping from mode 0 to modes 1, ..., L-1
+    expression<double, int> H;
+    for(int i = 1; i < L; ++i)
+      H += 0.1 * i * c_dag(i) * c(0);
+    auto Hop = make_loperator(H, hs);
+
+    std::vector<double> in(hs.dim(), 0);
+    in[0x1] = 1.0;
+    auto out = Hop(in);
+
+    truncated_sparse_state_vector<double> in_t(hs.dim(), 0);
+    update_add_element(in_t, 0x1, 1.0);
+
+    truncated_sparse_state_vector<double> out_t(hs.dim(), 0.45);
+    Hop(in_t, out_t);
+    CHECK(out_t.n_nonzeros() == 5);
+    for(sv_index_type n = 0; n < hs.dim(); ++n)
+      CHECK(get_element(out_t, n) == (std::abs(out[n]) > 0.45 ? out[n] : 0));
+
+    truncated_sparse_state_vector<double> out_k(hs.dim(), 0, 3);
+    Hop(in_t, out_k);
+    CHECK(out_k.n_nonzeros() == 3);
+    for(sv_index_type n = 0; n < hs.dim(); ++n)
+      CHECK(get_element(out_k, n) == (std::abs(out[n]) > 0.65 ? out[n] : 0));
+  }
+}